@@ -0,0 +1,41 @@
+#ifndef MXD_ARENA_H
+#define MXD_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator over a caller-supplied buffer. Allocations are never freed
+// individually; mxd_arena_reset() releases everything at once. An arena is
+// not thread-safe, so give each thread its own.
+typedef struct {
+  uint8_t *base;
+  size_t capacity;
+  size_t used;
+  size_t high_water; // Largest 'used' seen since init
+} mxd_arena_t;
+
+// Use buffer as backing storage for arena
+int mxd_arena_init(mxd_arena_t *arena, void *buffer, size_t capacity);
+
+// Allocate size bytes aligned to align (a power of two, 0 for the default
+// alignment). Returns NULL when the arena is exhausted.
+void *mxd_arena_alloc(mxd_arena_t *arena, size_t size, size_t align);
+
+// Allocate zeroed memory with the default alignment
+void *mxd_arena_calloc(mxd_arena_t *arena, size_t count, size_t size);
+
+// Release every allocation made from arena
+void mxd_arena_reset(mxd_arena_t *arena);
+
+// Bytes still available for allocation
+size_t mxd_arena_remaining(const mxd_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MXD_ARENA_H
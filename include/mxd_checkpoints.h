@@ -37,6 +37,12 @@ int mxd_create_checkpoint(mxd_checkpoint_manager_t *manager,
                           const uint8_t *state_data, size_t state_size,
                           uint64_t block_height, uint64_t timestamp);
 
+// Create a checkpoint from an already computed state digest, such as the
+// UTXO set commitment (mxd_get_utxo_commitment_at), without serializing state
+int mxd_create_checkpoint_from_hash(mxd_checkpoint_manager_t *manager,
+                                    const uint8_t state_hash[64],
+                                    uint64_t block_height, uint64_t timestamp);
+
 // Validate checkpoint state transition
 int mxd_validate_checkpoint(const mxd_checkpoint_manager_t *manager,
                             const mxd_checkpoint_t *checkpoint);
@@ -8,9 +8,63 @@ extern "C" {
 #include <stddef.h>
 #include <stdint.h>
 
+// Hash algorithms supported by the streaming API
+typedef enum {
+  MXD_HASH_SHA1 = 0,
+  MXD_HASH_SHA256 = 1,
+  MXD_HASH_SHA512 = 2
+} mxd_hash_alg_t;
+
+// Streaming hash context. The underlying digest state is borrowed from a
+// per-thread pool on init and handed back on final, so hashing does not touch
+// the heap once the pool is warm. Contexts must not be shared across threads.
+typedef struct {
+  void *md_ctx;       // Pooled OpenSSL EVP_MD_CTX
+  mxd_hash_alg_t alg; // Algorithm selected at init
+} mxd_hash_ctx_t;
+
+// Streaming hashing (init/update/final)
+int mxd_hash_init(mxd_hash_ctx_t *ctx, mxd_hash_alg_t alg);
+int mxd_hash_update(mxd_hash_ctx_t *ctx, const void *data, size_t length);
+int mxd_hash_final(mxd_hash_ctx_t *ctx, uint8_t *output);
+
+// Release a context without producing a digest (error paths)
+void mxd_hash_abort(mxd_hash_ctx_t *ctx);
+
+// Digest length in bytes for an algorithm (0 if unknown)
+size_t mxd_hash_digest_length(mxd_hash_alg_t alg);
+
 // SHA-512 hashing
 int mxd_sha512(const uint8_t *input, size_t length, uint8_t output[64]);
 
+// Batch SHA-512 over count independent messages. Uses multi-lane AVX2 or
+// AVX-512 kernels when the CPU supports them, one-shot hashing otherwise.
+int mxd_sha512_batch(const uint8_t *const inputs[], const size_t lengths[],
+                     uint8_t outputs[][64], size_t count);
+
+// CPU features probed for hashing backend selection
+#define MXD_CPU_FEATURE_SHA_NI (1u << 0)
+#define MXD_CPU_FEATURE_AVX2 (1u << 1)
+#define MXD_CPU_FEATURE_AVX512F (1u << 2)
+
+// Hashing backends selected at startup
+typedef struct {
+  uint32_t cpu_features;            // MXD_CPU_FEATURE_* bits
+  const char *sha256_backend;       // Single-message SHA-256 (OpenSSL, with CPU hint)
+  const char *sha512_backend;       // Single-message SHA-512 (OpenSSL, with CPU hint)
+  const char *sha512_batch_backend; // mxd_sha512_batch kernel
+  int self_test_passed;             // Known-answer tests passed
+} mxd_crypto_backend_info_t;
+
+// Probe CPU features, run known-answer self-tests and select the hashing
+// backends. Runs once per process (later calls return the first result) and
+// happens implicitly on first use; call it at startup to log the selection.
+// Returns -1 if a self-test failed.
+int mxd_crypto_init_backends(void);
+
+// Backends in use (probes first if needed)
+void mxd_crypto_get_backend_info(mxd_crypto_backend_info_t *info);
+
 // SHA-256 hashing
 int mxd_sha256(const uint8_t *input, size_t length, uint8_t output[32]);
 
@@ -23,6 +77,32 @@ int mxd_ripemd160(const uint8_t *input, size_t length, uint8_t output[20]);
 // HASH160 (SHA-256 followed by RIPEMD-160)
 int mxd_hash160(const uint8_t *input, size_t length, uint8_t output[20]);
 
+// Size of a MuHash group element (integers modulo 2^3072 - 1103717)
+#define MXD_MUHASH_ELEMENT_SIZE 384
+
+// Incremental multiset hash (MuHash). Elements can be inserted and removed
+// in any order; two accumulators over the same multiset finalize to the same
+// digest. Insertions and removals are kept as separate products so each
+// update is a single modular multiplication; the one inversion happens in
+// mxd_muhash_final. The state is plain bytes and can be stored as is.
+typedef struct {
+  uint8_t numerator[MXD_MUHASH_ELEMENT_SIZE];   // Big-endian
+  uint8_t denominator[MXD_MUHASH_ELEMENT_SIZE]; // Big-endian
+} mxd_muhash_t;
+
+// Reset to the empty set
+void mxd_muhash_init(mxd_muhash_t *muhash);
+
+// Add or remove one element
+int mxd_muhash_insert(mxd_muhash_t *muhash, const uint8_t *data, size_t length);
+int mxd_muhash_remove(mxd_muhash_t *muhash, const uint8_t *data, size_t length);
+
+// Merge the elements of other into muhash
+int mxd_muhash_combine(mxd_muhash_t *muhash, const mxd_muhash_t *other);
+
+// 64-byte digest of the set; does not modify the accumulator
+int mxd_muhash_final(const mxd_muhash_t *muhash, uint8_t output[64]);
+
 // Argon2 key derivation (SENSITIVE: ~1GB memory, use for user passwords)
 int mxd_argon2(const char *input, const uint8_t *salt, uint8_t *output,
                size_t output_length);
@@ -40,6 +120,27 @@ int mxd_dilithium_verify(const uint8_t *signature, size_t signature_length,
                          const uint8_t *message, size_t message_length,
                          const uint8_t *public_key);
 
+// Verification that consults and fills the shared signature cache
+// (mxd_sigcache.h), so a tuple verified once is not checked again
+int mxd_dilithium_verify_cached(const uint8_t *signature, size_t signature_length,
+                                const uint8_t *message, size_t message_length,
+                                const uint8_t *public_key);
+
+// One (signature, message, public key) tuple for batch verification
+typedef struct {
+  const uint8_t *signature;
+  size_t signature_length;
+  const uint8_t *message;
+  size_t message_length;
+  const uint8_t *public_key;
+} mxd_sig_verify_item_t;
+
+// Verify count signatures across a fixed worker pool, consulting the
+// signature cache for each item. results[i] is set to 0 for a valid signature
+// and -1 otherwise. Returns 0 only if every signature verified.
+int mxd_dilithium_verify_batch(const mxd_sig_verify_item_t *items, size_t count,
+                               int *results);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,6 +11,12 @@ extern "C" {
 // Maximum number of transactions in mempool
 #define MXD_MAX_MEMPOOL_SIZE 10000
 
+// Default memory budget for pooled transactions
+#define MXD_MEMPOOL_DEFAULT_MAX_BYTES (64 * 1024 * 1024)
+
+// Most transactions, counting descendants, one admission may replace
+#define MXD_MEMPOOL_MAX_REPLACED 100
+
 // Transaction priority levels
 typedef enum {
   MXD_PRIORITY_LOW = 0,
@@ -21,24 +27,46 @@ typedef enum {
 // Mempool transaction entry
 typedef struct {
   mxd_transaction_t tx;       // Transaction data
+  uint8_t tx_hash[64];        // Hash computed once on admission
   double fee;                 // Transaction fee
+  size_t size;                // Bytes held in memory; fee rate is fee / size
   mxd_tx_priority_t priority; // Transaction priority
   uint64_t timestamp;         // Entry timestamp
+  void *body;                 // Shared storage behind tx.inputs and tx.outputs
 } mxd_mempool_entry_t;
 
+// All mempool functions may be called from any thread. Returned
+// transactions are copies owned by the caller.
+
 // Initialize mempool
 int mxd_init_mempool(void);
 
-// Add transaction to mempool
+// Add transaction to mempool. Each outpoint is spent by at most one pooled
+// transaction: a transaction spending outpoints already spent in the pool
+// replaces the spenders and their descendants only if its voluntary tip
+// exceeds their combined tips, and is rejected otherwise. When the byte
+// budget or entry limit is reached, entries with a lower fee rate are
+// evicted to make room; a transaction that cannot pay for its place, or
+// pays below mxd_get_mempool_min_fee_rate, is rejected.
 int mxd_add_to_mempool(const mxd_transaction_t *tx, mxd_tx_priority_t priority);
 
 // Remove transaction from mempool
 int mxd_remove_from_mempool(const uint8_t tx_hash[64]);
 
+// Remove pooled transactions, with their descendants, that spend any input
+// of tx (e.g. once tx is confirmed in a block). tx itself is left in place.
+// Returns the number removed, or -1 on error.
+int mxd_remove_mempool_conflicts(const mxd_transaction_t *tx);
+
+// Get the hash of the pooled transaction spending an outpoint
+int mxd_get_mempool_spender(const uint8_t prev_tx_hash[64], uint32_t output_index,
+                            uint8_t spender_hash[64]);
+
 // Get transaction from mempool
 int mxd_get_from_mempool(const uint8_t tx_hash[64], mxd_transaction_t *tx);
 
-// Get highest priority transactions
+// Get up to *tx_count transactions of at least min_priority, best first
+// (priority, then fee rate, then age)
 int mxd_get_priority_transactions(mxd_transaction_t *txs, size_t *tx_count,
                                   mxd_tx_priority_t min_priority);
 
@@ -48,6 +76,18 @@ int mxd_clean_mempool(uint64_t max_age);
 // Get current mempool size
 size_t mxd_get_mempool_size(void);
 
+// Set the memory budget in bytes (0 selects MXD_MEMPOOL_DEFAULT_MAX_BYTES).
+// Lowering it evicts the lowest fee-rate entries at once.
+int mxd_set_mempool_max_bytes(size_t max_bytes);
+
+// Get bytes held by pooled transactions
+size_t mxd_get_mempool_bytes(void);
+
+// Get the minimum fee rate, in coins per byte, a transaction must pay to be
+// admitted. It rises above the rate of entries evicted for space and halves
+// every ten minutes after, returning to zero once the pool has room again.
+double mxd_get_mempool_min_fee_rate(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,7 @@ extern "C" {
 #include <stddef.h>
 #include <stdint.h>
 #include "mxd_blockchain.h"
+#include "mxd_transaction.h"
 
 int mxd_should_relay_block(const mxd_block_t *block, int just_signed);
 
@@ -94,10 +95,14 @@ int mxd_send_message_with_retry(const char *address, uint16_t port,
                                 mxd_message_type_t type, const void *payload,
                                 size_t payload_length, int max_retries);
 
-// Broadcast message to all peers
+// Broadcast message to all peers. MXD_MSG_TRANSACTIONS payloads must be
+// transaction lists in the canonical wire format.
 int mxd_broadcast_message(mxd_message_type_t type, const void *payload,
                           size_t payload_length);
 
+// Encode transactions as a wire-format list and broadcast them
+int mxd_broadcast_transactions(const mxd_transaction_t *txs, size_t count);
+
 // Broadcast message to Rapid Table peers only (priority propagation)
 int mxd_broadcast_to_rapid_table(mxd_message_type_t type, const void *payload,
                                 size_t payload_length);
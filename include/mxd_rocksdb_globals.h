@@ -5,8 +5,25 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <rocksdb/c.h>
 
+// Column families. Keys keep their string prefixes inside each family.
+typedef enum {
+    MXD_CF_DEFAULT = 0,  // Metadata ("current_height", "utxo_meta:")
+    MXD_CF_UTXO,         // "utxo:" records
+    MXD_CF_PUBKEY_INDEX, // "pubkey:" address index
+    MXD_CF_BALANCE,      // "balance:" per-address totals (MXD_COUNTER_MERGE)
+    MXD_CF_BLOCKS,       // "block:height:", "block:hash:"
+    MXD_CF_SIGNATURES,   // "sig:", "validator:"
+    MXD_CF_BLACKLIST,    // "blacklist:"
+    MXD_CF_COUNT
+} mxd_rocksdb_cf_t;
+
+// Values in MXD_CF_BALANCE are arrays of int64 counters; a merge operand of
+// the same length is added element-wise, so updates need no read
+#define MXD_COUNTER_MERGE_MAX 4
+
 // Accessor functions for global RocksDB variables
 rocksdb_t *mxd_get_rocksdb_db(void);
 rocksdb_readoptions_t *mxd_get_rocksdb_readoptions(void);
@@ -16,6 +33,22 @@ void mxd_set_rocksdb_db(rocksdb_t *db);
 void mxd_set_rocksdb_readoptions(rocksdb_readoptions_t *options);
 void mxd_set_rocksdb_writeoptions(rocksdb_writeoptions_t *options);
 
+// Open db_path with every column family, creating missing ones. db_options
+// holds the database-wide settings; each family adds its own table, bloom
+// and prefix settings, and all families share one block cache.
+rocksdb_t *mxd_rocksdb_open(const rocksdb_options_t *db_options, const char *db_path,
+                            size_t block_cache_size, char **err);
+
+// Release the column family handles and close db
+void mxd_rocksdb_close(rocksdb_t *db);
+
+// Handle of a column family of the open database (NULL when closed)
+rocksdb_column_family_handle_t *mxd_get_rocksdb_cf(mxd_rocksdb_cf_t cf);
+
+// Move keys starting with prefix from the default family into cf, for
+// databases written before column families were used
+int mxd_rocksdb_migrate_prefix(const char *prefix, mxd_rocksdb_cf_t cf);
+
 #ifdef __cplusplus
 }
 #endif
@@ -80,6 +80,8 @@ int mxd_block_has_validation_quorum(const mxd_block_t *block, const mxd_rapid_ta
 
 int mxd_block_has_min_relay_signatures(const mxd_block_t *block);
 
+// Returns 1 or 2 for the winning block, or -1 on error. Switching the UTXO
+// set to the winner's branch is left to the caller (mxd_reorganize_utxo).
 int mxd_resolve_fork_by_validation(const mxd_block_t *block1, const mxd_block_t *block2,
                                   const mxd_rapid_table_t *table);
 
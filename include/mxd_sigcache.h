@@ -0,0 +1,57 @@
+#ifndef MXD_SIGCACHE_H
+#define MXD_SIGCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Default number of cached verifications
+#define MXD_SIGCACHE_DEFAULT_ENTRIES 65536
+
+// Size of a cache key (salted SHA-256 of public key, message and signature)
+#define MXD_SIGCACHE_KEY_SIZE 32
+
+// Signature cache statistics
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t insertions;
+  uint64_t evictions;
+  size_t entries;
+  size_t capacity;
+} mxd_sigcache_stats_t;
+
+// (Re)initialize the cache with room for max_entries verifications. Cached
+// entries are dropped and the statistics reset. The cache initializes itself
+// with the default size on first use if this is never called.
+int mxd_sigcache_init(size_t max_entries);
+
+// Release the cache
+void mxd_sigcache_cleanup(void);
+
+// Drop all cached verifications
+void mxd_sigcache_clear(void);
+
+// Derive the cache key for a (public key, message, signature) tuple
+int mxd_sigcache_compute_key(const uint8_t *public_key, size_t public_key_length,
+                             const uint8_t *message, size_t message_length,
+                             const uint8_t *signature, size_t signature_length,
+                             uint8_t key[MXD_SIGCACHE_KEY_SIZE]);
+
+// Returns 1 if key was recorded as a successful verification, 0 otherwise
+int mxd_sigcache_contains(const uint8_t key[MXD_SIGCACHE_KEY_SIZE]);
+
+// Record a successful verification
+void mxd_sigcache_insert(const uint8_t key[MXD_SIGCACHE_KEY_SIZE]);
+
+// Get cache statistics
+void mxd_sigcache_get_stats(mxd_sigcache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MXD_SIGCACHE_H
@@ -7,7 +7,7 @@ extern "C" {
 
 #include <stddef.h>
 #include <stdint.h>
-#include "mxd_utxo.h"
+#include "mxd_arena.h"
 
 // Initialize transaction validation system
 int mxd_init_transaction_validation(void);
@@ -46,8 +46,21 @@ typedef struct {
   mxd_tx_output_t *outputs; // Array of outputs
   uint8_t tx_hash[64];      // Transaction hash (SHA-512)
   uint8_t is_coinbase;      // Flag indicating if this is a coinbase transaction
+  uint8_t arena_allocated;  // Inputs/outputs live in an mxd_arena_t
 } mxd_transaction_t;
 
+// Builds a transaction in arena memory. Input and output arrays are sized
+// once in mxd_tx_builder_begin, so appends never reallocate; the arrays are
+// released by resetting the arena, and mxd_free_transaction leaves them be.
+typedef struct {
+  mxd_transaction_t *tx;
+  uint32_t input_capacity;
+  uint32_t output_capacity;
+} mxd_tx_builder_t;
+
+// Included after the types above, which mxd_utxo.h refers to
+#include "mxd_utxo.h"
+
 // Create a new transaction
 int mxd_create_transaction(mxd_transaction_t *tx);
 
@@ -63,6 +76,10 @@ int mxd_add_tx_output(mxd_transaction_t *tx, const uint8_t recipient_key[256],
 int mxd_sign_tx_input(mxd_transaction_t *tx, uint32_t input_index,
                       const uint8_t private_key[128]);
 
+// Sign every input, input i with private_keys[i]. All inputs sign the same
+// transaction digest, so it is computed once for the whole call.
+int mxd_sign_tx_inputs(mxd_transaction_t *tx, const uint8_t *const private_keys[]);
+
 // Verify transaction input signature
 int mxd_verify_tx_input(const mxd_transaction_t *tx, uint32_t input_index);
 
@@ -75,6 +92,11 @@ int mxd_validate_transaction(const mxd_transaction_t *tx);
 // Validate transaction inputs against UTXO database
 int mxd_validate_transaction_inputs(const mxd_transaction_t *tx);
 
+// Fill in the cached amount of every input from the UTXO set, e.g. after
+// decoding a transaction received from the network. Inputs whose UTXO is not
+// found are left at 0.
+int mxd_load_tx_input_amounts(mxd_transaction_t *tx);
+
 // Verify transaction input UTXO exists and has sufficient funds
 int mxd_verify_tx_input_utxo(const mxd_tx_input_t *input, double *amount);
 
@@ -100,6 +122,19 @@ double mxd_get_voluntary_tip(const mxd_transaction_t *tx);
 int mxd_create_coinbase_transaction(mxd_transaction_t *tx, const uint8_t recipient_key[256],
                                    double reward_amount);
 
+// Start building tx with room for max_inputs/max_outputs from arena
+int mxd_tx_builder_begin(mxd_tx_builder_t *builder, mxd_arena_t *arena,
+                         mxd_transaction_t *tx, uint32_t max_inputs,
+                         uint32_t max_outputs);
+
+// Append an input or output to the transaction being built
+int mxd_tx_builder_add_input(mxd_tx_builder_t *builder,
+                             const uint8_t prev_tx_hash[64],
+                             uint32_t output_index,
+                             const uint8_t public_key[256]);
+int mxd_tx_builder_add_output(mxd_tx_builder_t *builder,
+                              const uint8_t recipient_key[256], double amount);
+
 // Free transaction resources
 void mxd_free_transaction(mxd_transaction_t *tx);
 
@@ -0,0 +1,137 @@
+#ifndef MXD_TX_WIRE_H
+#define MXD_TX_WIRE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "mxd_transaction.h"
+
+// Canonical transaction wire format, version 1:
+//
+//   u8      wire version (MXD_TX_WIRE_VERSION)
+//   varint  transaction version
+//   u8      flags (bit 0: coinbase, other bits must be zero)
+//   varint  timestamp
+//   varint  voluntary tip in base units
+//   varint  input count
+//     per input:  prev_tx_hash[64], varint output_index,
+//                 varint key length + key, varint signature length + signature
+//   varint  output count
+//     per output: varint key length + key, varint amount in base units
+//
+// Varints are unsigned LEB128 and must use the shortest encoding. Keys and
+// signatures occupy fixed 256-byte fields in mxd_transaction_t; on the wire
+// their zero padding is dropped, so a non-empty field must not end in a zero
+// byte. Amounts are fixed-point with MXD_TX_WIRE_AMOUNT_SCALE units per coin,
+// and transaction hashes cover them in that form.
+// The cached input amount, output pubkey hash and tx_hash are derived data
+// and are not encoded; decoding looks the input amounts up in the UTXO set.
+#define MXD_TX_WIRE_VERSION 1
+#define MXD_TX_WIRE_AMOUNT_SCALE 100000000ULL
+#define MXD_TX_WIRE_FLAG_COINBASE 0x01
+
+// Largest possible encoding of a single transaction
+#define MXD_TX_WIRE_MAX_SIZE                                                   \
+  (1 + 5 + 1 + 10 + 10 + 2 + MXD_MAX_TX_INPUTS * (64 + 5 + 2 + 256 + 2 + 256) + \
+   2 + MXD_MAX_TX_OUTPUTS * (2 + 256 + 10))
+
+// Input fields pointing into a received buffer
+typedef struct {
+  const uint8_t *prev_tx_hash; // 64 bytes
+  uint32_t output_index;
+  const uint8_t *public_key;
+  size_t public_key_length;
+  const uint8_t *signature;
+  size_t signature_length;
+} mxd_tx_input_view_t;
+
+// Output fields pointing into a received buffer
+typedef struct {
+  const uint8_t *recipient_key;
+  size_t recipient_key_length;
+  uint64_t amount_units;
+} mxd_tx_output_view_t;
+
+// Zero-copy view of an encoded transaction. The view borrows the buffer it
+// was parsed from, which must outlive it.
+typedef struct {
+  const uint8_t *data;
+  size_t length;            // Encoded size of this transaction
+  uint32_t version;
+  uint8_t is_coinbase;
+  uint64_t timestamp;
+  uint64_t tip_units;
+  uint32_t input_count;
+  uint32_t output_count;
+  size_t inputs_offset;     // Offset of the first input within data
+  size_t outputs_offset;    // Offset of the first output within data
+} mxd_tx_view_t;
+
+// Unsigned LEB128 varints, also used by the UTXO record format.
+// mxd_varint_read only accepts the shortest encoding of a value <= max.
+size_t mxd_varint_size(uint64_t value);
+size_t mxd_varint_write(uint8_t *out, uint64_t value);
+int mxd_varint_read(const uint8_t *data, size_t length, size_t *offset,
+                    uint64_t max, uint64_t *value);
+
+// Convert between coin amounts and fixed-point base units. Amounts are rounded
+// to the nearest unit; negative, non-finite and out-of-range amounts fail.
+int mxd_tx_amount_to_units(double amount, uint64_t *units);
+double mxd_tx_units_to_amount(uint64_t units);
+
+// Size of the canonical encoding of tx, or 0 if it cannot be encoded
+size_t mxd_tx_encoded_size(const mxd_transaction_t *tx);
+
+// Encode tx into buffer; written receives the number of bytes used
+int mxd_tx_encode(const mxd_transaction_t *tx, uint8_t *buffer, size_t capacity,
+                  size_t *written);
+
+// Decode one transaction from the start of buffer into a freshly
+// initialized tx (free with mxd_free_transaction), filling in input amounts
+// with mxd_load_tx_input_amounts. consumed may be NULL.
+int mxd_tx_decode(const uint8_t *buffer, size_t length, mxd_transaction_t *tx,
+                  size_t *consumed);
+
+// Validate the encoding at the start of buffer and fill view without
+// allocating. view->length is the number of bytes the transaction occupies.
+int mxd_tx_view_parse(mxd_tx_view_t *view, const uint8_t *buffer, size_t length);
+
+// Read an input or output of a parsed view
+int mxd_tx_view_get_input(const mxd_tx_view_t *view, uint32_t index,
+                          mxd_tx_input_view_t *input);
+int mxd_tx_view_get_output(const mxd_tx_view_t *view, uint32_t index,
+                           mxd_tx_output_view_t *output);
+
+// Transaction hash computed straight from the view; equals
+// mxd_calculate_tx_hash() of the decoded transaction
+int mxd_tx_view_hash(const mxd_tx_view_t *view, uint8_t hash[64]);
+
+// Materialize a view into a transaction (free with mxd_free_transaction)
+int mxd_tx_view_to_transaction(const mxd_tx_view_t *view, mxd_transaction_t *tx);
+
+// Materialize a view with its input/output arrays allocated from arena, for
+// decoding many transactions (e.g. a block body) without heap allocations
+int mxd_tx_view_to_transaction_arena(const mxd_tx_view_t *view, mxd_arena_t *arena,
+                                     mxd_transaction_t *tx);
+
+// Transaction lists (MXD_MSG_TRANSACTIONS payloads):
+// varint count followed by that many encoded transactions.
+int mxd_tx_list_encode(const mxd_transaction_t *txs, size_t count,
+                       uint8_t **buffer, size_t *length);
+
+// Validate a transaction list, returning the number of transactions in count
+int mxd_tx_list_validate(const uint8_t *buffer, size_t length, uint32_t *count);
+
+// Parse the next transaction of a list; offset starts at 0 and is advanced
+// past the count prefix and each transaction
+int mxd_tx_list_next(const uint8_t *buffer, size_t length, size_t *offset,
+                     mxd_tx_view_t *view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MXD_TX_WIRE_H
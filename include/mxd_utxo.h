@@ -5,6 +5,7 @@
 extern "C" {
 #endif
 
+#include "mxd_blockchain.h"
 #include "mxd_transaction.h"
 #include <stdint.h>
 #include <rocksdb/c.h>
@@ -22,9 +23,30 @@ typedef struct {
   uint8_t is_spent;             // Flag indicating if UTXO is spent
 } mxd_utxo_t;
 
-// Initialize UTXO database with persistent storage
+// Reference to a transaction output
+typedef struct {
+  uint8_t tx_hash[64];
+  uint32_t output_index;
+} mxd_utxo_outpoint_t;
+
+// Open the UTXO database, keeping the stored set. If the last block was not
+// applied completely the set is cleared so it can be replayed.
 int mxd_init_utxo_db(const char *db_path);
 
+// Set the UTXO cache memory budget in bytes (0 selects the default). Takes
+// effect immediately if the database is open, otherwise on the next open.
+int mxd_set_utxo_cache_size(size_t byte_budget);
+
+// Blocks committed between WAL syncs in memory mode
+#define MXD_UTXO_DEFAULT_FLUSH_INTERVAL 16
+
+// Keep the whole UTXO set resident in memory so lookups never read the
+// database. Blocks are then committed without an fsync and the write-ahead
+// log is synced in the background every flush_interval_blocks blocks (0
+// selects the default); after a crash the blocks since the last sync are
+// replayed. Must be set while the database is closed.
+int mxd_set_utxo_memory_mode(int enabled, uint32_t flush_interval_blocks);
+
 // Add UTXO to database
 int mxd_add_utxo(const mxd_utxo_t *utxo);
 
@@ -35,6 +57,13 @@ int mxd_remove_utxo(const uint8_t tx_hash[64], uint32_t output_index);
 int mxd_find_utxo(const uint8_t tx_hash[64], uint32_t output_index,
                   mxd_utxo_t *utxo);
 
+// Find several UTXOs at once: cache hits are served directly and all misses
+// are read with a single MultiGet. status[i] is 0 if out[i] was found and -1
+// otherwise; found entries must be released with mxd_free_utxo. Returns -1 on
+// invalid arguments or a database error.
+int mxd_find_utxos(const mxd_utxo_outpoint_t *keys, size_t n, mxd_utxo_t *out,
+                   int *status);
+
 // Get UTXO by transaction hash and output index (wrapper for mxd_find_utxo)
 int mxd_get_utxo(const uint8_t tx_hash[64], uint32_t output_index,
                  mxd_utxo_t *utxo);
@@ -42,6 +71,11 @@ int mxd_get_utxo(const uint8_t tx_hash[64], uint32_t output_index,
 // Get total balance for a public key
 double mxd_get_balance(const uint8_t public_key[256]);
 
+// Get the unspent total and UTXO count of an address from the balance index
+// in a single lookup. utxo_count may be NULL. Unknown addresses report zero.
+int mxd_get_address_balance(const uint8_t pubkey_hash[20], double *balance,
+                            uint64_t *utxo_count);
+
 // Verify UTXO exists and is spendable
 int mxd_verify_utxo(const uint8_t tx_hash[64], uint32_t output_index,
                     const uint8_t public_key[256]);
@@ -69,15 +103,26 @@ int mxd_verify_utxo_funds(const uint8_t tx_hash[64], uint32_t output_index, doub
 // Get UTXOs by public key hash (for address balance queries)
 int mxd_get_utxos_by_pubkey_hash(const uint8_t pubkey_hash[20], mxd_utxo_t **utxos, size_t *utxo_count);
 
-// Prune spent UTXOs from database
+// Prune spent UTXOs from database in batched deletes
 int mxd_prune_spent_utxos(void);
 
 // Get total UTXO count
 int mxd_get_utxo_count(size_t *count);
 
-// Get UTXO database statistics
+// Get UTXO database statistics: stored records, spent records awaiting
+// pruning and unspent value. Kept up to date on every change, so this does
+// not touch the database.
 int mxd_get_utxo_stats(size_t *total_count, size_t *pruned_count, double *total_value);
 
+// Digest of the current unspent set. Maintained incrementally as a
+// multiset hash, so it depends only on the set's contents, never on the
+// order outputs were added or spent, and costs no database access.
+int mxd_get_utxo_commitment(uint8_t commitment[64]);
+
+// Set commitment recorded when the block at height was applied. Returns -1
+// if no block has been applied at that height.
+int mxd_get_utxo_commitment_at(uint32_t height, uint8_t commitment[64]);
+
 // Mark UTXO as spent
 int mxd_mark_utxo_spent(const uint8_t tx_hash[64], uint32_t output_index);
 
@@ -87,6 +132,51 @@ int mxd_flush_utxo_db(void);
 // Compact UTXO database (optimize storage)
 int mxd_compact_utxo_db(void);
 
+// Get the block the UTXO set was last applied up to. Returns -1 if no block
+// has been applied yet.
+int mxd_get_utxo_tip(uint32_t *height, uint8_t block_hash[64]);
+
+// Blocks below the tip whose undo data is kept
+#define MXD_UTXO_UNDO_DEPTH 100
+
+// Apply a block's transactions and advance the tip to it. The block must
+// extend the current tip (any block is accepted when there is none). All
+// changes, together with the block's undo data, are committed in one synced
+// write; on failure none are.
+int mxd_apply_block_to_utxo(const mxd_block_t *block, const mxd_transaction_t *txs, size_t tx_count);
+
+// Roll the tip block back out of the UTXO set, e.g. when a fork is resolved
+// in favour of a competing block: outputs it spent are restored, outputs it
+// created are removed and the tip moves to its parent. Cost is proportional
+// to the block's size. Only the last MXD_UTXO_UNDO_DEPTH blocks can be
+// disconnected; deeper reorganizations need a reset and replay.
+int mxd_disconnect_block_from_utxo(const mxd_block_t *block);
+
+// A block together with its transactions, for mxd_reorganize_utxo
+typedef struct {
+  const mxd_block_t *block;
+  const mxd_transaction_t *txs;
+  size_t tx_count;
+} mxd_utxo_block_t;
+
+// Switch the UTXO set from the current branch to a competing one.
+// old_branch holds the blocks back to the fork point, tip first; they are
+// disconnected in that order. new_branch holds the competing blocks in
+// height order, starting at the fork point; they are then applied. If a step
+// fails, the applied blocks are disconnected again and old_branch is
+// re-applied, so the set ends up at its previous tip.
+int mxd_reorganize_utxo(const mxd_utxo_block_t *old_branch, size_t old_count,
+                        const mxd_utxo_block_t *new_branch, size_t new_count);
+
+// Loads the block at height and applies it with mxd_apply_block_to_utxo
+typedef int (*mxd_utxo_replay_fn)(uint32_t height, void *user_data);
+
+// Apply the blocks after the current tip up to target_height
+int mxd_replay_utxo_blocks(uint32_t target_height, mxd_utxo_replay_fn apply_block, void *user_data);
+
+// Remove all UTXOs and the tip, e.g. before a full replay
+int mxd_reset_utxo_db(void);
+
 #ifdef __cplusplus
 }
 #endif
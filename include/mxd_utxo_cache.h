@@ -0,0 +1,54 @@
+#ifndef MXD_UTXO_CACHE_H
+#define MXD_UTXO_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "mxd_utxo.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Default memory budget for cached UTXOs
+#define MXD_UTXO_CACHE_DEFAULT_BYTES (16 * 1024 * 1024)
+
+// UTXO cache statistics
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t insertions;
+    uint64_t evictions;
+    size_t entries;
+    size_t bytes;        // Slot tables plus cosigner keys
+    size_t byte_budget;
+} mxd_utxo_cache_stats_t;
+
+// (Re)initialize the cache within byte_budget bytes (0 selects the default).
+// Cached entries are dropped and the statistics reset.
+int mxd_utxo_cache_init(size_t byte_budget);
+
+// Release the cache; lookups miss until it is initialized again
+void mxd_utxo_cache_cleanup(void);
+
+// Drop all cached UTXOs
+void mxd_utxo_cache_clear(void);
+
+// Copy the cached UTXO for (tx_hash, output_index) into utxo. The caller owns
+// the copied cosigner keys. Returns 0 on a hit, -1 on a miss.
+int mxd_utxo_cache_lookup(const uint8_t tx_hash[64], uint32_t output_index,
+                          mxd_utxo_t *utxo);
+
+// Insert or replace a UTXO, evicting cold entries if over budget
+void mxd_utxo_cache_insert(const mxd_utxo_t *utxo);
+
+// Remove a UTXO if cached
+void mxd_utxo_cache_remove(const uint8_t tx_hash[64], uint32_t output_index);
+
+// Get cache statistics
+void mxd_utxo_cache_get_stats(mxd_utxo_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MXD_UTXO_CACHE_H
@@ -0,0 +1,55 @@
+#ifndef MXD_UTXO_RESIDENT_H
+#define MXD_UTXO_RESIDENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Resident UTXO table: the whole UTXO set kept in memory as compact records
+// keyed by outpoint, used by mxd_utxo in memory mode. Records are opaque
+// here; mxd_utxo encodes and decodes them.
+
+// Decodes a record found by mxd_utxo_resident_get; called with the table
+// locked, so it must not call back into the table
+typedef int (*mxd_utxo_resident_decode_fn)(const uint8_t tx_hash[64], uint32_t output_index,
+                                           const uint8_t *record, size_t record_len,
+                                           void *user_data);
+
+// Resident table statistics
+typedef struct {
+    size_t entries;
+    size_t bytes;        // Slot table plus records
+} mxd_utxo_resident_stats_t;
+
+// (Re)initialize an empty table
+int mxd_utxo_resident_init(void);
+
+// Release the table and all records
+void mxd_utxo_resident_cleanup(void);
+
+// Drop all records
+void mxd_utxo_resident_clear(void);
+
+// Insert or replace the record for (tx_hash, output_index)
+int mxd_utxo_resident_put(const uint8_t tx_hash[64], uint32_t output_index,
+                          const uint8_t *record, size_t record_len);
+
+// Decode the record for (tx_hash, output_index). Returns the decoder's
+// result, or -1 if there is no such record.
+int mxd_utxo_resident_get(const uint8_t tx_hash[64], uint32_t output_index,
+                          mxd_utxo_resident_decode_fn decode, void *user_data);
+
+// Remove the record for (tx_hash, output_index) if present
+void mxd_utxo_resident_remove(const uint8_t tx_hash[64], uint32_t output_index);
+
+// Get table statistics
+void mxd_utxo_resident_get_stats(mxd_utxo_resident_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MXD_UTXO_RESIDENT_H
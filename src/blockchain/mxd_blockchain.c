@@ -174,37 +174,22 @@ int mxd_calculate_membership_digest(const mxd_block_t *block, uint8_t digest[64]
     return -1; // Transaction set must be frozen before calculating digest
   }
   
-  // Create buffer for digest calculation
-  size_t buffer_size = sizeof(uint32_t) + 64 + 64 + 20 + sizeof(uint32_t) + sizeof(uint32_t);
-  uint8_t *buffer = malloc(buffer_size);
-  if (!buffer) {
+  // Stream immutable fields into the digest
+  mxd_hash_ctx_t ctx;
+  if (mxd_hash_init(&ctx, MXD_HASH_SHA512) != 0) {
     return -1;
   }
-  
-  size_t offset = 0;
-  
-  // Serialize immutable fields
-  memcpy(buffer + offset, &block->version, sizeof(uint32_t));
-  offset += sizeof(uint32_t);
-  
-  memcpy(buffer + offset, block->prev_block_hash, 64);
-  offset += 64;
-  
-  memcpy(buffer + offset, block->merkle_root, 64);
-  offset += 64;
-  
-  memcpy(buffer + offset, block->proposer_id, 20);
-  offset += 20;
-  
-  memcpy(buffer + offset, &block->height, sizeof(uint32_t));
-  offset += sizeof(uint32_t);
-  
-  memcpy(buffer + offset, &block->difficulty, sizeof(uint32_t));
-  offset += sizeof(uint32_t);
-  
-  // Calculate SHA-512 hash
-  int result = mxd_sha512(buffer, buffer_size, digest);
-  free(buffer);
+
+  if (mxd_hash_update(&ctx, &block->version, sizeof(uint32_t)) != 0 ||
+      mxd_hash_update(&ctx, block->prev_block_hash, 64) != 0 ||
+      mxd_hash_update(&ctx, block->merkle_root, 64) != 0 ||
+      mxd_hash_update(&ctx, block->proposer_id, 20) != 0 ||
+      mxd_hash_update(&ctx, &block->height, sizeof(uint32_t)) != 0 ||
+      mxd_hash_update(&ctx, &block->difficulty, sizeof(uint32_t)) != 0) {
+    return -1;
+  }
+
+  int result = mxd_hash_final(&ctx, digest);
   
   return result;
 }
@@ -8,6 +8,9 @@
 #include <string.h>
 #include <time.h>
 
+#define MXD_VALIDATION_MSG_LEN (64 + 20 + 8)
+#define MXD_VALIDATION_PUBKEY_MAX 4096
+
 int mxd_init_block_with_validation(mxd_block_t *block, const uint8_t prev_hash[64], 
                                   const uint8_t proposer_id[20], uint32_t height) {
     if (!block || !prev_hash || !proposer_id) {
@@ -65,10 +68,12 @@ int mxd_add_validator_signature(mxd_block_t *block, const uint8_t validator_id[2
     return 0;
 }
 
-int mxd_verify_validation_chain(const mxd_block_t *block) {
-    if (!block || !block->validation_chain || block->validation_count == 0) {
-        return -1;
-    }
+// Structural checks and message assembly for every link in the chain, so the
+// signatures can then be verified in a single batch
+static int prepare_validation_batch(const mxd_block_t *block,
+                                    uint8_t (*msgs)[MXD_VALIDATION_MSG_LEN],
+                                    uint8_t *pubkeys, mxd_sig_verify_item_t *items) {
+    time_t now = time(NULL);
 
     for (uint32_t i = 0; i < block->validation_count; i++) {
         const mxd_validator_signature_t *sig_i = &block->validation_chain[i];
@@ -77,7 +82,6 @@ int mxd_verify_validation_chain(const mxd_block_t *block) {
             return -1;
         }
 
-        time_t now = time(NULL);
         if (sig_i->timestamp > (uint64_t)(now + 60) || sig_i->timestamp + 60 < (uint64_t)now) {
             return -1;
         }
@@ -89,7 +93,7 @@ int mxd_verify_validation_chain(const mxd_block_t *block) {
             }
         }
 
-        uint8_t msg[64 + 20 + 8];
+        uint8_t *msg = msgs[i];
         memcpy(msg, block->block_hash, 64);
         if (i == 0) {
             memset(msg + 64, 0, 20);
@@ -101,20 +105,46 @@ int mxd_verify_validation_chain(const mxd_block_t *block) {
             msg[64 + 20 + b] = (uint8_t)((ts >> (8 * b)) & 0xFF);
         }
 
-        uint8_t pubbuf[4096];
+        uint8_t *pubbuf = pubkeys + (size_t)i * MXD_VALIDATION_PUBKEY_MAX;
         size_t publen = 0;
-        if (mxd_get_validator_public_key(sig_i->validator_id, pubbuf, sizeof(pubbuf), &publen) != 0) {
+        if (mxd_get_validator_public_key(sig_i->validator_id, pubbuf, MXD_VALIDATION_PUBKEY_MAX, &publen) != 0) {
             return -1;
         }
 
-        if (mxd_dilithium_verify(sig_i->signature, (size_t)sig_i->signature_length, msg, sizeof(msg), pubbuf) != 0) {
-            return -1;
-        }
+        items[i].signature = sig_i->signature;
+        items[i].signature_length = (size_t)sig_i->signature_length;
+        items[i].message = msg;
+        items[i].message_length = MXD_VALIDATION_MSG_LEN;
+        items[i].public_key = pubbuf;
     }
 
     return 0;
 }
 
+int mxd_verify_validation_chain(const mxd_block_t *block) {
+    if (!block || !block->validation_chain || block->validation_count == 0) {
+        return -1;
+    }
+
+    uint32_t count = block->validation_count;
+    uint8_t (*msgs)[MXD_VALIDATION_MSG_LEN] = malloc(count * sizeof(*msgs));
+    uint8_t *pubkeys = malloc((size_t)count * MXD_VALIDATION_PUBKEY_MAX);
+    mxd_sig_verify_item_t *items = malloc(count * sizeof(*items));
+    int *results = malloc(count * sizeof(*results));
+
+    int rc = -1;
+    if (msgs && pubkeys && items && results &&
+        prepare_validation_batch(block, msgs, pubkeys, items) == 0) {
+        rc = mxd_dilithium_verify_batch(items, count, results);
+    }
+
+    free(msgs);
+    free(pubkeys);
+    free(items);
+    free(results);
+    return rc;
+}
+
 int mxd_block_has_quorum(const mxd_block_t *block) {
     if (!block || !block->validation_chain) {
         return 0;
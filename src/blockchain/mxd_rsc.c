@@ -636,8 +636,8 @@ int mxd_blacklist_validator(const uint8_t validator_id[20], uint32_t duration) {
     }
     
     char *err = NULL;
-    rocksdb_put(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)key, sizeof(key), 
-               value, strlen(value), &err);
+    rocksdb_put_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), mxd_get_rocksdb_cf(MXD_CF_BLACKLIST),
+                   (char *)key, sizeof(key), value, strlen(value), &err);
     
     if (err) {
         MXD_LOG_ERROR("rsc", "Failed to blacklist validator: %s", err);
@@ -672,7 +672,8 @@ int mxd_is_validator_blacklisted(const uint8_t validator_id[20]) {
     char *value = NULL;
     size_t value_len = 0;
     
-    value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), (char *)key, sizeof(key), &value_len, &err);
+    value = rocksdb_get_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), mxd_get_rocksdb_cf(MXD_CF_BLACKLIST),
+                           (char *)key, sizeof(key), &value_len, &err);
     
     if (err) {
         MXD_LOG_ERROR("rsc", "Failed to check blacklist status: %s", err);
@@ -26,8 +26,25 @@ int mxd_init_checkpoints(mxd_checkpoint_manager_t *manager,
 int mxd_create_checkpoint(mxd_checkpoint_manager_t *manager,
                           const uint8_t *state_data, size_t state_size,
                           uint64_t block_height, uint64_t timestamp) {
-  if (!manager || !state_data || state_size == 0 ||
-      block_height <= manager->last_height) {
+  if (!state_data || state_size == 0) {
+    return -1;
+  }
+
+  // Calculate state hash
+  uint8_t state_hash[64];
+  if (mxd_sha512(state_data, state_size, state_hash) != 0) {
+    return -1;
+  }
+
+  return mxd_create_checkpoint_from_hash(manager, state_hash, block_height,
+                                         timestamp);
+}
+
+// Create a checkpoint from a precomputed state hash
+int mxd_create_checkpoint_from_hash(mxd_checkpoint_manager_t *manager,
+                                    const uint8_t state_hash[64],
+                                    uint64_t block_height, uint64_t timestamp) {
+  if (!manager || !state_hash || block_height <= manager->last_height) {
     return -1;
   }
 
@@ -45,9 +62,7 @@ int mxd_create_checkpoint(mxd_checkpoint_manager_t *manager,
 
   // Create new checkpoint
   mxd_checkpoint_t *checkpoint = &manager->checkpoints[manager->count];
-
-  // Calculate state hash
-  mxd_sha512(state_data, state_size, checkpoint->state_hash);
+  memcpy(checkpoint->state_hash, state_hash, 64);
 
   checkpoint->block_height = block_height;
   checkpoint->timestamp = timestamp;
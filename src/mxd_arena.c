@@ -0,0 +1,65 @@
+#include "../include/mxd_arena.h"
+#include <stdalign.h>
+#include <string.h>
+
+#define MXD_ARENA_DEFAULT_ALIGN alignof(max_align_t)
+
+int mxd_arena_init(mxd_arena_t *arena, void *buffer, size_t capacity) {
+  if (!arena || (!buffer && capacity > 0)) {
+    return -1;
+  }
+
+  arena->base = buffer;
+  arena->capacity = capacity;
+  arena->used = 0;
+  arena->high_water = 0;
+  return 0;
+}
+
+void *mxd_arena_alloc(mxd_arena_t *arena, size_t size, size_t align) {
+  if (!arena || size == 0) {
+    return NULL;
+  }
+  if (align == 0) {
+    align = MXD_ARENA_DEFAULT_ALIGN;
+  }
+  if (align & (align - 1)) {
+    return NULL;
+  }
+
+  // Align the address rather than the offset so any buffer works
+  uintptr_t start = (uintptr_t)arena->base + arena->used;
+  size_t padding = (size_t)(-start & (align - 1));
+  if (padding > arena->capacity - arena->used ||
+      size > arena->capacity - arena->used - padding) {
+    return NULL;
+  }
+
+  void *ptr = arena->base + arena->used + padding;
+  arena->used += padding + size;
+  if (arena->used > arena->high_water) {
+    arena->high_water = arena->used;
+  }
+  return ptr;
+}
+
+void *mxd_arena_calloc(mxd_arena_t *arena, size_t count, size_t size) {
+  if (count > 0 && size > SIZE_MAX / count) {
+    return NULL;
+  }
+  void *ptr = mxd_arena_alloc(arena, count * size, 0);
+  if (ptr) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+void mxd_arena_reset(mxd_arena_t *arena) {
+  if (arena) {
+    arena->used = 0;
+  }
+}
+
+size_t mxd_arena_remaining(const mxd_arena_t *arena) {
+  return arena ? arena->capacity - arena->used : 0;
+}
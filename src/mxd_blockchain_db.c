@@ -111,23 +111,27 @@ int mxd_init_blockchain_db(const char *db_path) {
                  write_buffer_size / (1024*1024), max_write_buffer_number, block_cache_size / (1024*1024),
                  (write_buffer_size * max_write_buffer_number + block_cache_size) / (1024*1024));
     
-    rocksdb_cache_t *cache = rocksdb_cache_create_lru(block_cache_size);
-    rocksdb_block_based_table_options_t *table_options = rocksdb_block_based_options_create();
-    rocksdb_block_based_options_set_block_cache(table_options, cache);
-    rocksdb_options_set_block_based_table_factory(options, table_options);
-    
     rocksdb_readoptions_set_verify_checksums(mxd_get_rocksdb_readoptions(), 1);
     
     rocksdb_writeoptions_set_sync(mxd_get_rocksdb_writeoptions(), 1);
     
     char *err = NULL;
-    mxd_set_rocksdb_db(rocksdb_open(options, db_path, &err));
+    mxd_set_rocksdb_db(mxd_rocksdb_open(options, db_path, block_cache_size, &err));
     if (err) {
         MXD_LOG_ERROR("db", "Failed to open blockchain database: %s", err);
         free(err);
         return -1;
     }
     
+    // Databases from before column families keep everything in default
+    if (mxd_rocksdb_migrate_prefix("block:", MXD_CF_BLOCKS) != 0 ||
+        mxd_rocksdb_migrate_prefix("sig:", MXD_CF_SIGNATURES) != 0 ||
+        mxd_rocksdb_migrate_prefix("validator:", MXD_CF_SIGNATURES) != 0 ||
+        mxd_rocksdb_migrate_prefix("blacklist:", MXD_CF_BLACKLIST) != 0) {
+        mxd_close_blockchain_db();
+        return -1;
+    }
+    
     mxd_get_blockchain_height(&current_height);
     
     return 0;
@@ -138,7 +142,7 @@ int mxd_close_blockchain_db(void) {
         return -1;
     }
     
-    rocksdb_close(mxd_get_rocksdb_db());
+    mxd_rocksdb_close(mxd_get_rocksdb_db());
     mxd_set_rocksdb_db(NULL);
     
     rocksdb_options_destroy(options);
@@ -174,7 +178,8 @@ int mxd_store_block(const mxd_block_t *block) {
     }
     
     char *err = NULL;
-    rocksdb_put(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)height_key, height_key_len, (char *)data, data_len, &err);
+    rocksdb_put_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), mxd_get_rocksdb_cf(MXD_CF_BLOCKS),
+                   (char *)height_key, height_key_len, (char *)data, data_len, &err);
     if (err) {
         MXD_LOG_ERROR("db", "Failed to store block by height: %s", err);
         free(err);
@@ -182,7 +187,8 @@ int mxd_store_block(const mxd_block_t *block) {
         return -1;
     }
     
-    rocksdb_put(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)hash_key, hash_key_len, (char *)data, data_len, &err);
+    rocksdb_put_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), mxd_get_rocksdb_cf(MXD_CF_BLOCKS),
+                   (char *)hash_key, hash_key_len, (char *)data, data_len, &err);
     if (err) {
         MXD_LOG_ERROR("db", "Failed to store block by hash: %s", err);
         free(err);
@@ -225,7 +231,8 @@ int mxd_retrieve_block_by_height(uint32_t height, mxd_block_t *block) {
     char *err = NULL;
     char *value = NULL;
     size_t value_len = 0;
-    value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), (char *)key, key_len, &value_len, &err);
+    value = rocksdb_get_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), mxd_get_rocksdb_cf(MXD_CF_BLOCKS),
+                           (char *)key, key_len, &value_len, &err);
     if (err) {
         MXD_LOG_ERROR("db", "Failed to retrieve block by height: %s", err);
         free(err);
@@ -254,7 +261,8 @@ int mxd_retrieve_block_by_hash(const uint8_t hash[64], mxd_block_t *block) {
     char *err = NULL;
     char *value = NULL;
     size_t value_len = 0;
-    value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), (char *)key, key_len, &value_len, &err);
+    value = rocksdb_get_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), mxd_get_rocksdb_cf(MXD_CF_BLOCKS),
+                           (char *)key, key_len, &value_len, &err);
     if (err) {
         MXD_LOG_ERROR("db", "Failed to retrieve block by hash: %s", err);
         free(err);
@@ -311,7 +319,8 @@ int mxd_store_signature(uint32_t height, const uint8_t validator_id[20], const u
     create_signature_key(height, validator_id, sig_key, &sig_key_len);
     
     char *err = NULL;
-    rocksdb_put(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)sig_key, sig_key_len, (char *)signature, signature_length, &err);
+    rocksdb_put_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), mxd_get_rocksdb_cf(MXD_CF_SIGNATURES),
+                   (char *)sig_key, sig_key_len, (char *)signature, signature_length, &err);
     if (err) {
         MXD_LOG_ERROR("db", "Failed to store signature: %s", err);
         free(err);
@@ -324,7 +333,8 @@ int mxd_store_signature(uint32_t height, const uint8_t validator_id[20], const u
     memcpy(validator_key + validator_key_len, &height, sizeof(uint32_t));
     validator_key_len += sizeof(uint32_t);
     
-    rocksdb_put(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)validator_key, validator_key_len, "", 0, &err);
+    rocksdb_put_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), mxd_get_rocksdb_cf(MXD_CF_SIGNATURES),
+                   (char *)validator_key, validator_key_len, "", 0, &err);
     if (err) {
         MXD_LOG_ERROR("db", "Failed to store validator signature index: %s", err);
         free(err);
@@ -346,7 +356,8 @@ int mxd_signature_exists(uint32_t height, const uint8_t validator_id[20], const
     char *err = NULL;
     char *value = NULL;
     size_t value_len = 0;
-    value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), (char *)key, key_len, &value_len, &err);
+    value = rocksdb_get_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), mxd_get_rocksdb_cf(MXD_CF_SIGNATURES),
+                           (char *)key, key_len, &value_len, &err);
     if (err) {
         MXD_LOG_ERROR("db", "Failed to check signature: %s", err);
         free(err);
@@ -370,7 +381,8 @@ int mxd_prune_expired_signatures(uint32_t current_height) {
     
     uint32_t expiry_height = current_height - 5;
     
-    rocksdb_iterator_t *iter = rocksdb_create_iterator(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions());
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(),
+                                                          mxd_get_rocksdb_cf(MXD_CF_SIGNATURES));
     rocksdb_iter_seek(iter, "sig:", 4);
     
     size_t pruned = 0;
@@ -394,13 +406,15 @@ int mxd_prune_expired_signatures(uint32_t current_height) {
                 validator_key_len += sizeof(uint32_t);
                 
                 char *err = NULL;
-                rocksdb_delete(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)validator_key, validator_key_len, &err);
+                rocksdb_delete_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), mxd_get_rocksdb_cf(MXD_CF_SIGNATURES),
+                                  (char *)validator_key, validator_key_len, &err);
                 if (err) {
                     MXD_LOG_ERROR("db", "Failed to remove validator signature index: %s", err);
                     free(err);
                 }
                 
-                rocksdb_delete(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), key, key_len, &err);
+                rocksdb_delete_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), mxd_get_rocksdb_cf(MXD_CF_SIGNATURES),
+                                  key, key_len, &err);
                 if (err) {
                     MXD_LOG_ERROR("db", "Failed to remove signature: %s", err);
                     free(err);
@@ -430,7 +444,8 @@ int mxd_get_signatures_by_height(uint32_t height, mxd_validator_signature_t **si
     memcpy(prefix_key + 4, &height, sizeof(uint32_t));
     size_t prefix_key_len = 4 + sizeof(uint32_t);
     
-    rocksdb_iterator_t *iter = rocksdb_create_iterator(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions());
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(),
+                                                          mxd_get_rocksdb_cf(MXD_CF_SIGNATURES));
     rocksdb_iter_seek(iter, (char *)prefix_key, prefix_key_len);
     
     size_t count = 0;
@@ -504,7 +519,8 @@ int mxd_get_signatures_by_validator(const uint8_t validator_id[20], mxd_validato
     size_t prefix_key_len;
     create_validator_key(validator_id, prefix_key, &prefix_key_len);
     
-    rocksdb_iterator_t *iter = rocksdb_create_iterator(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions());
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(),
+                                                          mxd_get_rocksdb_cf(MXD_CF_SIGNATURES));
     rocksdb_iter_seek(iter, (char *)prefix_key, prefix_key_len);
     
     size_t count = 0;
@@ -567,7 +583,8 @@ int mxd_get_signatures_by_validator(const uint8_t validator_id[20], mxd_validato
         char *err = NULL;
         char *value = NULL;
         size_t value_len = 0;
-        value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), (char *)sig_key, sig_key_len, &value_len, &err);
+        value = rocksdb_get_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), mxd_get_rocksdb_cf(MXD_CF_SIGNATURES),
+                               (char *)sig_key, sig_key_len, &value_len, &err);
         if (err) {
             MXD_LOG_ERROR("db", "Failed to retrieve signature: %s", err);
             free(err);
@@ -613,7 +630,9 @@ int mxd_flush_blockchain_db(void) {
     rocksdb_flushoptions_t *flushoptions = rocksdb_flushoptions_create();
     rocksdb_flushoptions_set_wait(flushoptions, 1);
     
-    rocksdb_flush(mxd_get_rocksdb_db(), flushoptions, &err);
+    for (int cf = 0; cf < MXD_CF_COUNT && !err; cf++) {
+        rocksdb_flush_cf(mxd_get_rocksdb_db(), flushoptions, mxd_get_rocksdb_cf((mxd_rocksdb_cf_t)cf), &err);
+    }
     rocksdb_flushoptions_destroy(flushoptions);
     
     if (err) {
@@ -630,7 +649,9 @@ int mxd_compact_blockchain_db(void) {
         return -1;
     }
     
-    rocksdb_compact_range(mxd_get_rocksdb_db(), NULL, 0, NULL, 0);
+    for (int cf = 0; cf < MXD_CF_COUNT; cf++) {
+        rocksdb_compact_range_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_cf((mxd_rocksdb_cf_t)cf), NULL, 0, NULL, 0);
+    }
     
     MXD_LOG_INFO("db", "Blockchain database compaction completed");
     return 0;
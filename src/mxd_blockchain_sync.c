@@ -5,6 +5,8 @@
 #include "../include/mxd_blockchain_db.h"
 #include "../include/mxd_rsc.h"
 #include "../include/mxd_logging.h"
+#include "../include/mxd_crypto.h"
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdio.h>
@@ -12,6 +14,7 @@
 #define MXD_VALIDATION_EXPIRY_BLOCKS 5
 #define MXD_MIN_RELAY_SIGNATURES 3
 #define MXD_MAX_TIMESTAMP_DRIFT 60
+#define MXD_SYNC_PUBKEY_MAX 4096
 
 int mxd_sync_blockchain(void) {
     // For testing purposes, simulate successful sync
@@ -70,15 +73,70 @@ int mxd_process_incoming_validation_chain(const uint8_t block_hash[64],
         return -1;
     }
     
+    // Verify every incoming link in one batch before touching the chain. Each
+    // link signs block_hash || previous validator id || LE timestamp, where the
+    // previous validator is the preceding incoming link or the current tail.
+    uint8_t (*msgs)[64 + 20 + 8] = malloc(signature_count * sizeof(*msgs));
+    uint8_t *pubkeys = malloc((size_t)signature_count * MXD_SYNC_PUBKEY_MAX);
+    mxd_sig_verify_item_t *items = malloc(signature_count * sizeof(*items));
+    int *verified = malloc(signature_count * sizeof(*verified));
+    if (!msgs || !pubkeys || !items || !verified) {
+        free(msgs);
+        free(pubkeys);
+        free(items);
+        free(verified);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < signature_count; i++) {
+        uint8_t *msg = msgs[i];
+        memcpy(msg, block_hash, 64);
+        if (i > 0) {
+            memcpy(msg + 64, signatures[i - 1].validator_id, 20);
+        } else if (block.validation_count > 0 && block.validation_chain) {
+            memcpy(msg + 64, block.validation_chain[block.validation_count - 1].validator_id, 20);
+        } else {
+            memset(msg + 64, 0, 20);
+        }
+        for (int b = 0; b < 8; b++) {
+            msg[64 + 20 + b] = (uint8_t)((signatures[i].timestamp >> (8 * b)) & 0xFF);
+        }
+
+        uint8_t *pubbuf = pubkeys + (size_t)i * MXD_SYNC_PUBKEY_MAX;
+        size_t publen = 0;
+        if (mxd_get_validator_public_key(signatures[i].validator_id, pubbuf,
+                                         MXD_SYNC_PUBKEY_MAX, &publen) != 0) {
+            // Unknown validator: an all-zero key never verifies
+            memset(pubbuf, 0, MXD_SYNC_PUBKEY_MAX);
+        }
+
+        items[i].signature = signatures[i].signature;
+        items[i].signature_length = signatures[i].signature_length;
+        items[i].message = msg;
+        items[i].message_length = 64 + 20 + 8;
+        items[i].public_key = pubbuf;
+    }
+    mxd_dilithium_verify_batch(items, signature_count, verified);
+
+    // Each link was verified against the incoming link before it, so the
+    // chain is only extended up to the first link that is rejected
     for (uint32_t i = 0; i < signature_count; i++) {
-        if (mxd_verify_and_add_validation_signature(&block,
+        if (verified[i] != 0 ||
+            mxd_verify_and_add_validation_signature(&block,
                                                   signatures[i].validator_id,
                                                   signatures[i].signature,
                                                   signatures[i].signature_length,
                                                   signatures[i].timestamp) != 0) {
-            MXD_LOG_WARN("sync", "Failed to verify signature %u of %u", i + 1, signature_count);
+            MXD_LOG_WARN("sync", "Failed to verify signature %u of %u, dropping the rest",
+                         i + 1, signature_count);
+            break;
         }
     }
+
+    free(msgs);
+    free(pubkeys);
+    free(items);
+    free(verified);
     
     if (mxd_store_block(&block) != 0) {
         MXD_LOG_ERROR("sync", "Failed to store block with updated validation chain");
@@ -1,5 +1,8 @@
 #include "mxd_logging.h"
 #include "../include/mxd_crypto.h"
+#include "mxd_crypto_simd.h"
+#include "../include/mxd_sigcache.h"
+#include <openssl/bn.h>
 #include <openssl/crypto.h>
 #include <openssl/evp.h>
 #include <openssl/ripemd.h>
@@ -8,7 +11,10 @@
 #ifdef MXD_PQC_DILITHIUM
 #include <oqs/oqs.h>
 #endif
+#include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 // Initialize OpenSSL and libsodium
 static int ensure_crypto_init(void) {
@@ -29,108 +35,337 @@ static int ensure_crypto_init(void) {
   return 0;
 }
 
-// SHA-1 hashing implementation using OpenSSL 3.0 EVP interface
-int mxd_sha1(const uint8_t *input, size_t length, uint8_t output[20]) {
-  if (ensure_crypto_init() < 0) {
-    MXD_LOG_ERROR("crypto", "SHA-1: Failed to initialize crypto");
-    return -1;
+// Per-thread pool of digest contexts, one free list per algorithm. Contexts
+// are never reset on release so EVP_DigestInit_ex can reuse their internal
+// state on the next init with the same digest.
+#define MXD_HASH_POOL_DEPTH 4
+#define MXD_HASH_ALG_COUNT 3
+
+typedef struct {
+  EVP_MD_CTX *free_ctx[MXD_HASH_ALG_COUNT][MXD_HASH_POOL_DEPTH];
+  size_t free_count[MXD_HASH_ALG_COUNT];
+} mxd_hash_pool_t;
+
+static pthread_key_t hash_pool_key;
+static pthread_once_t hash_pool_once = PTHREAD_ONCE_INIT;
+
+static void hash_pool_destroy(void *arg) {
+  mxd_hash_pool_t *pool = (mxd_hash_pool_t *)arg;
+  if (!pool) {
+    return;
   }
+  for (size_t alg = 0; alg < MXD_HASH_ALG_COUNT; alg++) {
+    for (size_t i = 0; i < pool->free_count[alg]; i++) {
+      EVP_MD_CTX_free(pool->free_ctx[alg][i]);
+    }
+  }
+  free(pool);
+}
 
-  EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+static void hash_pool_key_create(void) {
+  pthread_key_create(&hash_pool_key, hash_pool_destroy);
+}
+
+static mxd_hash_pool_t *get_hash_pool(void) {
+  pthread_once(&hash_pool_once, hash_pool_key_create);
+  mxd_hash_pool_t *pool = pthread_getspecific(hash_pool_key);
+  if (!pool) {
+    pool = calloc(1, sizeof(mxd_hash_pool_t));
+    if (pool && pthread_setspecific(hash_pool_key, pool) != 0) {
+      free(pool);
+      pool = NULL;
+    }
+  }
+  return pool;
+}
+
+static const EVP_MD *hash_alg_to_md(mxd_hash_alg_t alg) {
+  switch (alg) {
+  case MXD_HASH_SHA1:
+    return EVP_sha1();
+  case MXD_HASH_SHA256:
+    return EVP_sha256();
+  case MXD_HASH_SHA512:
+    return EVP_sha512();
+  default:
+    return NULL;
+  }
+}
+
+static EVP_MD_CTX *acquire_md_ctx(mxd_hash_alg_t alg) {
+  mxd_hash_pool_t *pool = get_hash_pool();
+  if (pool && pool->free_count[alg] > 0) {
+    return pool->free_ctx[alg][--pool->free_count[alg]];
+  }
+  return EVP_MD_CTX_new();
+}
+
+static void release_md_ctx(mxd_hash_alg_t alg, EVP_MD_CTX *md_ctx) {
+  if (!md_ctx) {
+    return;
+  }
+  mxd_hash_pool_t *pool = get_hash_pool();
+  if (pool && pool->free_count[alg] < MXD_HASH_POOL_DEPTH) {
+    pool->free_ctx[alg][pool->free_count[alg]++] = md_ctx;
+    return;
+  }
+  EVP_MD_CTX_free(md_ctx);
+}
+
+size_t mxd_hash_digest_length(mxd_hash_alg_t alg) {
+  switch (alg) {
+  case MXD_HASH_SHA1:
+    return 20;
+  case MXD_HASH_SHA256:
+    return 32;
+  case MXD_HASH_SHA512:
+    return 64;
+  default:
+    return 0;
+  }
+}
+
+int mxd_hash_init(mxd_hash_ctx_t *ctx, mxd_hash_alg_t alg) {
   if (!ctx) {
-    MXD_LOG_ERROR("crypto", "SHA-1: Failed to create context");
     return -1;
   }
+  ctx->md_ctx = NULL;
 
-  if (!EVP_DigestInit_ex(ctx, EVP_sha1(), NULL)) {
-    MXD_LOG_ERROR("crypto", "SHA-1: Failed to initialize digest");
-    EVP_MD_CTX_free(ctx);
+  const EVP_MD *md = hash_alg_to_md(alg);
+  if (!md) {
+    MXD_LOG_ERROR("crypto", "Hash: Unknown algorithm %d", (int)alg);
     return -1;
   }
 
-  if (!EVP_DigestUpdate(ctx, input, length)) {
-    MXD_LOG_ERROR("crypto", "SHA-1: Failed to update digest");
-    EVP_MD_CTX_free(ctx);
+  if (ensure_crypto_init() < 0) {
+    MXD_LOG_ERROR("crypto", "Hash: Failed to initialize crypto");
     return -1;
   }
 
-  if (!EVP_DigestFinal_ex(ctx, output, NULL)) {
-    MXD_LOG_ERROR("crypto", "SHA-1: Failed to finalize digest");
-    EVP_MD_CTX_free(ctx);
+  EVP_MD_CTX *md_ctx = acquire_md_ctx(alg);
+  if (!md_ctx) {
+    MXD_LOG_ERROR("crypto", "Hash: Failed to create context");
     return -1;
   }
 
-  EVP_MD_CTX_free(ctx);
+  if (!EVP_DigestInit_ex(md_ctx, md, NULL)) {
+    MXD_LOG_ERROR("crypto", "Hash: Failed to initialize digest");
+    EVP_MD_CTX_free(md_ctx);
+    return -1;
+  }
+
+  ctx->md_ctx = md_ctx;
+  ctx->alg = alg;
   return 0;
 }
 
-// SHA-256 hashing implementation using OpenSSL 3.0 EVP interface
-int mxd_sha256(const uint8_t *input, size_t length, uint8_t output[32]) {
-  if (ensure_crypto_init() < 0) {
-    MXD_LOG_ERROR("crypto", "SHA-256: Failed to initialize crypto");
+int mxd_hash_update(mxd_hash_ctx_t *ctx, const void *data, size_t length) {
+  if (!ctx || !ctx->md_ctx || (!data && length > 0)) {
     return -1;
   }
+  if (length == 0) {
+    return 0;
+  }
 
-  EVP_MD_CTX *ctx = EVP_MD_CTX_new();
-  if (!ctx) {
-    MXD_LOG_ERROR("crypto", "SHA-256: Failed to create context");
+  if (!EVP_DigestUpdate((EVP_MD_CTX *)ctx->md_ctx, data, length)) {
+    MXD_LOG_ERROR("crypto", "Hash: Failed to update digest");
+    mxd_hash_abort(ctx);
     return -1;
   }
+  return 0;
+}
 
-  if (!EVP_DigestInit_ex(ctx, EVP_sha256(), NULL)) {
-    MXD_LOG_ERROR("crypto", "SHA-256: Failed to initialize digest");
-    EVP_MD_CTX_free(ctx);
+int mxd_hash_final(mxd_hash_ctx_t *ctx, uint8_t *output) {
+  if (!ctx || !ctx->md_ctx || !output) {
+    mxd_hash_abort(ctx);
     return -1;
   }
 
-  if (!EVP_DigestUpdate(ctx, input, length)) {
-    MXD_LOG_ERROR("crypto", "SHA-256: Failed to update digest");
-    EVP_MD_CTX_free(ctx);
+  EVP_MD_CTX *md_ctx = (EVP_MD_CTX *)ctx->md_ctx;
+  ctx->md_ctx = NULL;
+
+  if (!EVP_DigestFinal_ex(md_ctx, output, NULL)) {
+    MXD_LOG_ERROR("crypto", "Hash: Failed to finalize digest");
+    EVP_MD_CTX_free(md_ctx);
     return -1;
   }
 
-  if (!EVP_DigestFinal_ex(ctx, output, NULL)) {
-    MXD_LOG_ERROR("crypto", "SHA-256: Failed to finalize digest");
-    EVP_MD_CTX_free(ctx);
+  release_md_ctx(ctx->alg, md_ctx);
+  return 0;
+}
+
+void mxd_hash_abort(mxd_hash_ctx_t *ctx) {
+  if (ctx && ctx->md_ctx) {
+    // State is mid-stream, drop it rather than returning it to the pool
+    EVP_MD_CTX_free((EVP_MD_CTX *)ctx->md_ctx);
+    ctx->md_ctx = NULL;
+  }
+}
+
+static int hash_oneshot(mxd_hash_alg_t alg, const uint8_t *input,
+                        size_t length, uint8_t *output) {
+  mxd_hash_ctx_t ctx;
+  if (mxd_hash_init(&ctx, alg) != 0) {
     return -1;
   }
+  if (mxd_hash_update(&ctx, input, length) != 0) {
+    return -1;
+  }
+  return mxd_hash_final(&ctx, output);
+}
 
-  EVP_MD_CTX_free(ctx);
-  return 0;
+// SHA-1 hashing implementation using pooled OpenSSL 3.0 EVP contexts
+int mxd_sha1(const uint8_t *input, size_t length, uint8_t output[20]) {
+  return hash_oneshot(MXD_HASH_SHA1, input, length, output);
+}
+
+// SHA-256 hashing implementation using pooled OpenSSL 3.0 EVP contexts
+int mxd_sha256(const uint8_t *input, size_t length, uint8_t output[32]) {
+  return hash_oneshot(MXD_HASH_SHA256, input, length, output);
 }
 
-// SHA-512 hashing implementation using OpenSSL 3.0 EVP interface
+// SHA-512 hashing implementation using pooled OpenSSL 3.0 EVP contexts
 int mxd_sha512(const uint8_t *input, size_t length, uint8_t output[64]) {
-  if (ensure_crypto_init() < 0) {
-    MXD_LOG_ERROR("crypto", "SHA-512: Failed to initialize crypto");
-    return -1;
+  return hash_oneshot(MXD_HASH_SHA512, input, length, output);
+}
+
+// Hashing backends, probed and self-tested once per process. Single-message
+// SHA-256/512 go through OpenSSL, whose own dispatch (which OPENSSL_ia32cap
+// can override) picks the code path, so their labels only note the CPU
+// feature available to it; batch SHA-512 uses our multi-lane kernels. Every
+// candidate must reproduce known answers before it is enabled.
+static mxd_crypto_backend_info_t backend_info = {0, "openssl", "openssl", "scalar", 0};
+static mxd_sha512_mb_backend_t sha512_mb_backend = MXD_SHA512_MB_SCALAR;
+static pthread_once_t backend_once = PTHREAD_ONCE_INIT;
+
+static const uint8_t kat_sha256_abc[32] = {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40,
+    0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17,
+    0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad};
+
+static const uint8_t kat_sha512_abc[64] = {
+    0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba, 0xcc, 0x41, 0x73,
+    0x49, 0xae, 0x20, 0x41, 0x31, 0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9,
+    0x7e, 0xa2, 0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55, 0xd3, 0x9a, 0x21,
+    0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8, 0x36, 0xba, 0x3c, 0x23,
+    0xa3, 0xfe, 0xeb, 0xbd, 0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8,
+    0x0e, 0x2a, 0x9a, 0xc9, 0x4f, 0xa5, 0x4c, 0xa4, 0x9f};
+
+#define MXD_KAT_BATCH 9
+
+// Batch kernel self-test: "abc" against its published digest, plus messages
+// straddling the padding boundaries against the (already verified) one-shot
+// implementation
+static int sha512_mb_self_test(mxd_sha512_mb_backend_t backend) {
+  static const size_t lengths[MXD_KAT_BATCH] = {3, 0, 1, 111, 112, 127, 128, 129, 300};
+  uint8_t data[MXD_KAT_BATCH][300];
+  const uint8_t *inputs[MXD_KAT_BATCH];
+  uint8_t outputs[MXD_KAT_BATCH][64];
+  uint8_t expected[64];
+
+  memcpy(data[0], "abc", 3);
+  inputs[0] = data[0];
+  for (size_t i = 1; i < MXD_KAT_BATCH; i++) {
+    for (size_t j = 0; j < lengths[i]; j++) {
+      data[i][j] = (uint8_t)(i * 31 + j * 7);
+    }
+    inputs[i] = data[i];
   }
 
-  EVP_MD_CTX *ctx = EVP_MD_CTX_new();
-  if (!ctx) {
-    MXD_LOG_ERROR("crypto", "SHA-512: Failed to create context");
+  if (mxd_sha512_mb_hash(backend, inputs, lengths, outputs, MXD_KAT_BATCH) != 0 ||
+      memcmp(outputs[0], kat_sha512_abc, 64) != 0) {
     return -1;
   }
+  for (size_t i = 1; i < MXD_KAT_BATCH; i++) {
+    if (mxd_sha512(inputs[i], lengths[i], expected) != 0 ||
+        memcmp(outputs[i], expected, 64) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
 
-  if (!EVP_DigestInit_ex(ctx, EVP_sha512(), NULL)) {
-    MXD_LOG_ERROR("crypto", "SHA-512: Failed to initialize digest");
-    EVP_MD_CTX_free(ctx);
-    return -1;
+static void crypto_backend_select(void) {
+  uint32_t features = mxd_cpu_detect_features();
+  uint8_t digest[64];
+  int passed = 1;
+
+  backend_info.cpu_features = features;
+  backend_info.sha256_backend = (features & MXD_CPU_FEATURE_SHA_NI) ? "openssl (cpu: sha-ni)" : "openssl";
+  backend_info.sha512_backend = (features & MXD_CPU_FEATURE_AVX2) ? "openssl (cpu: avx2)" : "openssl";
+
+  if (mxd_sha256((const uint8_t *)"abc", 3, digest) != 0 ||
+      memcmp(digest, kat_sha256_abc, 32) != 0) {
+    MXD_LOG_ERROR("crypto", "SHA-256 known-answer self-test failed (%s)", backend_info.sha256_backend);
+    passed = 0;
+  }
+  if (mxd_sha512((const uint8_t *)"abc", 3, digest) != 0 ||
+      memcmp(digest, kat_sha512_abc, 64) != 0) {
+    MXD_LOG_ERROR("crypto", "SHA-512 known-answer self-test failed (%s)", backend_info.sha512_backend);
+    passed = 0;
+  }
+
+  // Walk down from the fastest supported batch kernel until one passes; the
+  // scalar path is the one-shot implementation tested above
+  sha512_mb_backend = MXD_SHA512_MB_SCALAR;
+  for (int b = (int)mxd_sha512_mb_detect(); passed && b > MXD_SHA512_MB_SCALAR; b--) {
+    if (sha512_mb_self_test((mxd_sha512_mb_backend_t)b) == 0) {
+      sha512_mb_backend = (mxd_sha512_mb_backend_t)b;
+      break;
+    }
+    MXD_LOG_ERROR("crypto", "SHA-512 batch kernel %d failed its self-test, disabling it", b);
+  }
+  backend_info.sha512_batch_backend =
+      sha512_mb_backend == MXD_SHA512_MB_AVX512 ? "avx512" :
+      sha512_mb_backend == MXD_SHA512_MB_AVX2 ? "avx2" : "scalar";
+  backend_info.self_test_passed = passed;
+
+  MXD_LOG_INFO("crypto", "Hash backends: sha256=%s sha512=%s sha512_batch=%s (cpu: sha_ni=%d avx2=%d avx512f=%d)",
+               backend_info.sha256_backend, backend_info.sha512_backend,
+               backend_info.sha512_batch_backend,
+               (features & MXD_CPU_FEATURE_SHA_NI) != 0,
+               (features & MXD_CPU_FEATURE_AVX2) != 0,
+               (features & MXD_CPU_FEATURE_AVX512F) != 0);
+}
+
+int mxd_crypto_init_backends(void) {
+  pthread_once(&backend_once, crypto_backend_select);
+  return backend_info.self_test_passed ? 0 : -1;
+}
+
+void mxd_crypto_get_backend_info(mxd_crypto_backend_info_t *info) {
+  if (!info) {
+    return;
   }
+  pthread_once(&backend_once, crypto_backend_select);
+  *info = backend_info;
+}
 
-  if (!EVP_DigestUpdate(ctx, input, length)) {
-    MXD_LOG_ERROR("crypto", "SHA-512: Failed to update digest");
-    EVP_MD_CTX_free(ctx);
+// Batch SHA-512: below two messages there is nothing to interleave, so only
+// real batches go through the multi-lane kernels
+int mxd_sha512_batch(const uint8_t *const inputs[], const size_t lengths[],
+                     uint8_t outputs[][64], size_t count) {
+  if ((!inputs || !lengths || !outputs) && count > 0) {
     return -1;
   }
+  for (size_t i = 0; i < count; i++) {
+    if (!inputs[i] && lengths[i] > 0) {
+      return -1;
+    }
+  }
 
-  if (!EVP_DigestFinal_ex(ctx, output, NULL)) {
-    MXD_LOG_ERROR("crypto", "SHA-512: Failed to finalize digest");
-    EVP_MD_CTX_free(ctx);
-    return -1;
+  pthread_once(&backend_once, crypto_backend_select);
+  if (count >= 2 && sha512_mb_backend != MXD_SHA512_MB_SCALAR &&
+      mxd_sha512_mb_hash(sha512_mb_backend, inputs, lengths, outputs,
+                         count) == 0) {
+    return 0;
   }
 
-  EVP_MD_CTX_free(ctx);
+  for (size_t i = 0; i < count; i++) {
+    if (mxd_sha512(inputs[i], lengths[i], outputs[i]) != 0) {
+      return -1;
+    }
+  }
   return 0;
 }
 
@@ -161,39 +396,135 @@ int mxd_ripemd160(const uint8_t *input, size_t length, uint8_t output[20]) {
 }
 
 int mxd_hash160(const uint8_t *input, size_t length, uint8_t output[20]) {
-  if (ensure_crypto_init() < 0) {
-    MXD_LOG_ERROR("crypto", "HASH160: Failed to initialize crypto");
+  uint8_t sha256_output[32];
+  if (mxd_sha256(input, length, sha256_output) != 0) {
+    MXD_LOG_ERROR("crypto", "HASH160: Failed to compute SHA-256 digest");
     return -1;
   }
-  
-  uint8_t sha256_output[32];
-  EVP_MD_CTX *ctx = EVP_MD_CTX_new();
-  if (!ctx) {
-    MXD_LOG_ERROR("crypto", "HASH160: Failed to create SHA-256 context");
+
+  return mxd_ripemd160(sha256_output, 32, output);
+}
+
+// MuHash modulus p = 2^3072 - 1103717, the largest safe prime below 2^3072
+#define MXD_MUHASH_PRIME_OFFSET 1103717
+
+static BIGNUM *muhash_prime = NULL;
+static pthread_once_t muhash_prime_once = PTHREAD_ONCE_INIT;
+
+static void muhash_prime_create(void) {
+  BIGNUM *p = BN_new();
+  if (p && BN_set_bit(p, MXD_MUHASH_ELEMENT_SIZE * 8) &&
+      BN_sub_word(p, MXD_MUHASH_PRIME_OFFSET)) {
+    muhash_prime = p;
+    return;
+  }
+  BN_free(p);
+}
+
+static const BIGNUM *get_muhash_prime(void) {
+  pthread_once(&muhash_prime_once, muhash_prime_create);
+  return muhash_prime;
+}
+
+static void muhash_set_one(uint8_t value[MXD_MUHASH_ELEMENT_SIZE]) {
+  memset(value, 0, MXD_MUHASH_ELEMENT_SIZE);
+  value[MXD_MUHASH_ELEMENT_SIZE - 1] = 1;
+}
+
+// Map an element to a group member: its SHA-512 digest expanded to 3072 bits
+// in counter mode, reduced mod p (zero is practically unreachable)
+static int muhash_element(const uint8_t *data, size_t length,
+                          uint8_t value[MXD_MUHASH_ELEMENT_SIZE]) {
+  uint8_t seed[65];
+  if (mxd_sha512(data, length, seed + 1) != 0) {
     return -1;
   }
-  
-  if (!EVP_DigestInit_ex(ctx, EVP_sha256(), NULL)) {
-    MXD_LOG_ERROR("crypto", "HASH160: Failed to initialize SHA-256 digest");
-    EVP_MD_CTX_free(ctx);
+  for (uint8_t i = 0; i < MXD_MUHASH_ELEMENT_SIZE / 64; i++) {
+    seed[0] = i;
+    if (mxd_sha512(seed, sizeof(seed), value + (size_t)i * 64) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// target = target * factor mod p, both big-endian
+static int muhash_multiply(uint8_t target[MXD_MUHASH_ELEMENT_SIZE],
+                           const uint8_t factor[MXD_MUHASH_ELEMENT_SIZE]) {
+  const BIGNUM *p = get_muhash_prime();
+  BN_CTX *ctx = BN_CTX_new();
+  BIGNUM *a = BN_bin2bn(target, MXD_MUHASH_ELEMENT_SIZE, NULL);
+  BIGNUM *b = BN_bin2bn(factor, MXD_MUHASH_ELEMENT_SIZE, NULL);
+  int ok = p && ctx && a && b && BN_mod_mul(a, a, b, p, ctx) &&
+           BN_bn2binpad(a, target, MXD_MUHASH_ELEMENT_SIZE) == MXD_MUHASH_ELEMENT_SIZE;
+  BN_free(a);
+  BN_free(b);
+  BN_CTX_free(ctx);
+  if (!ok) {
+    MXD_LOG_ERROR("crypto", "MuHash: modular multiplication failed");
     return -1;
   }
-  
-  if (!EVP_DigestUpdate(ctx, input, length)) {
-    MXD_LOG_ERROR("crypto", "HASH160: Failed to update SHA-256 digest");
-    EVP_MD_CTX_free(ctx);
+  return 0;
+}
+
+void mxd_muhash_init(mxd_muhash_t *muhash) {
+  if (!muhash) {
+    return;
+  }
+  muhash_set_one(muhash->numerator);
+  muhash_set_one(muhash->denominator);
+}
+
+int mxd_muhash_insert(mxd_muhash_t *muhash, const uint8_t *data, size_t length) {
+  uint8_t value[MXD_MUHASH_ELEMENT_SIZE];
+  if (!muhash || (!data && length > 0) || muhash_element(data, length, value) != 0) {
     return -1;
   }
-  
-  if (!EVP_DigestFinal_ex(ctx, sha256_output, NULL)) {
-    MXD_LOG_ERROR("crypto", "HASH160: Failed to finalize SHA-256 digest");
-    EVP_MD_CTX_free(ctx);
+  return muhash_multiply(muhash->numerator, value);
+}
+
+int mxd_muhash_remove(mxd_muhash_t *muhash, const uint8_t *data, size_t length) {
+  uint8_t value[MXD_MUHASH_ELEMENT_SIZE];
+  if (!muhash || (!data && length > 0) || muhash_element(data, length, value) != 0) {
     return -1;
   }
-  
-  EVP_MD_CTX_free(ctx);
-  
-  return mxd_ripemd160(sha256_output, 32, output);
+  return muhash_multiply(muhash->denominator, value);
+}
+
+int mxd_muhash_combine(mxd_muhash_t *muhash, const mxd_muhash_t *other) {
+  if (!muhash || !other) {
+    return -1;
+  }
+  mxd_muhash_t merged = *muhash;
+  if (muhash_multiply(merged.numerator, other->numerator) != 0 ||
+      muhash_multiply(merged.denominator, other->denominator) != 0) {
+    return -1;
+  }
+  *muhash = merged;
+  return 0;
+}
+
+int mxd_muhash_final(const mxd_muhash_t *muhash, uint8_t output[64]) {
+  if (!muhash || !output) {
+    return -1;
+  }
+
+  const BIGNUM *p = get_muhash_prime();
+  BN_CTX *ctx = BN_CTX_new();
+  BIGNUM *num = BN_bin2bn(muhash->numerator, MXD_MUHASH_ELEMENT_SIZE, NULL);
+  BIGNUM *den = BN_bin2bn(muhash->denominator, MXD_MUHASH_ELEMENT_SIZE, NULL);
+  uint8_t value[MXD_MUHASH_ELEMENT_SIZE];
+  int ok = p && ctx && num && den && BN_mod_inverse(den, den, p, ctx) &&
+           BN_mod_mul(num, num, den, p, ctx) &&
+           BN_bn2binpad(num, value, MXD_MUHASH_ELEMENT_SIZE) == MXD_MUHASH_ELEMENT_SIZE;
+  BN_free(num);
+  BN_free(den);
+  BN_CTX_free(ctx);
+  if (!ok) {
+    MXD_LOG_ERROR("crypto", "MuHash: failed to finalize");
+    return -1;
+  }
+  return mxd_sha512(value, sizeof(value), output);
 }
 
 // Argon2 key derivation implementation (SENSITIVE: ~1GB memory)
@@ -234,18 +565,42 @@ int mxd_argon2_lowmem(const char *input, const uint8_t *salt, uint8_t *output,
   return 0;
 }
 
+#ifdef MXD_PQC_DILITHIUM
+#define MXD_SIG_PUBLIC_KEY_BYTES OQS_SIG_dilithium_5_length_public_key
+#else
+#define MXD_SIG_PUBLIC_KEY_BYTES crypto_sign_PUBLICKEYBYTES
+#endif
+
+#ifdef MXD_PQC_DILITHIUM
+// The OQS_SIG descriptor is immutable once created, so one instance is shared
+// by every thread instead of being allocated around each sign/verify call
+static OQS_SIG *oqs_sig = NULL;
+static pthread_once_t oqs_sig_once = PTHREAD_ONCE_INIT;
+
+static void oqs_sig_create(void) {
+  oqs_sig = OQS_SIG_new(OQS_SIG_alg_dilithium_5);
+  if (!oqs_sig) {
+    MXD_LOG_ERROR("crypto", "Failed to create Dilithium5 signature context");
+  }
+}
+
+static OQS_SIG *get_oqs_sig(void) {
+  pthread_once(&oqs_sig_once, oqs_sig_create);
+  return oqs_sig;
+}
+#endif
+
 // Dilithium5 key generation
 int mxd_dilithium_keygen(uint8_t *public_key, uint8_t *secret_key) {
   if (ensure_crypto_init() < 0) {
     return -1;
   }
 #ifdef MXD_PQC_DILITHIUM
-  OQS_SIG *sig = OQS_SIG_new(OQS_SIG_alg_dilithium_5);
+  OQS_SIG *sig = get_oqs_sig();
   if (!sig) {
     return -1;
   }
   int rc = OQS_SIG_keypair(sig, public_key, secret_key);
-  OQS_SIG_free(sig);
   return rc == OQS_SUCCESS ? 0 : -1;
 #else
   return crypto_sign_keypair(public_key, secret_key);
@@ -257,13 +612,12 @@ int mxd_dilithium_sign(uint8_t *signature, size_t *signature_length,
                        const uint8_t *message, size_t message_length,
                        const uint8_t *secret_key) {
 #ifdef MXD_PQC_DILITHIUM
-  OQS_SIG *sig = OQS_SIG_new(OQS_SIG_alg_dilithium_5);
+  OQS_SIG *sig = get_oqs_sig();
   if (!sig) {
     return -1;
   }
   size_t sig_len = 0;
   int rc = OQS_SIG_sign(sig, signature, &sig_len, message, message_length, secret_key);
-  OQS_SIG_free(sig);
   if (rc != OQS_SUCCESS) return -1;
   *signature_length = sig_len;
   return 0;
@@ -281,15 +635,185 @@ int mxd_dilithium_verify(const uint8_t *signature, size_t signature_length,
                          const uint8_t *message, size_t message_length,
                          const uint8_t *public_key) {
 #ifdef MXD_PQC_DILITHIUM
-  OQS_SIG *sig = OQS_SIG_new(OQS_SIG_alg_dilithium_5);
+  OQS_SIG *sig = get_oqs_sig();
   if (!sig) {
     return -1;
   }
   int rc = OQS_SIG_verify(sig, message, message_length, signature, signature_length, public_key);
-  OQS_SIG_free(sig);
   return rc == OQS_SUCCESS ? 0 : -1;
 #else
   return crypto_sign_verify_detached(signature, message, message_length,
                                      public_key);
 #endif
 }
+
+// Verification backed by the signature cache: a tuple that verified before is
+// accepted without repeating the signature check, and successes are recorded
+int mxd_dilithium_verify_cached(const uint8_t *signature, size_t signature_length,
+                                const uint8_t *message, size_t message_length,
+                                const uint8_t *public_key) {
+  uint8_t key[MXD_SIGCACHE_KEY_SIZE];
+  int have_key = mxd_sigcache_compute_key(public_key, MXD_SIG_PUBLIC_KEY_BYTES,
+                                          message, message_length, signature,
+                                          signature_length, key) == 0;
+  if (have_key && mxd_sigcache_contains(key)) {
+    return 0;
+  }
+
+  if (mxd_dilithium_verify(signature, signature_length, message, message_length,
+                           public_key) != 0) {
+    return -1;
+  }
+
+  if (have_key) {
+    mxd_sigcache_insert(key);
+  }
+  return 0;
+}
+
+// Parallel batch verification. A fixed pool of workers is started on first
+// use; each batch is split by an atomic cursor so the calling thread and the
+// workers pull items until the batch is drained. Only one batch runs on the
+// pool at a time; a concurrent caller verifies its own batch inline rather
+// than queueing behind it.
+#define MXD_VERIFY_MAX_WORKERS 16
+#define MXD_VERIFY_MIN_PARALLEL 4
+
+typedef struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t work_cond;
+  pthread_cond_t done_cond;
+  pthread_mutex_t submit_mutex;
+  pthread_t threads[MXD_VERIFY_MAX_WORKERS];
+  size_t worker_count;
+  uint64_t generation;
+  size_t active;
+  const mxd_sig_verify_item_t *items;
+  int *results;
+  size_t count;
+  size_t cursor;
+  size_t failures;
+} mxd_verify_pool_t;
+
+static mxd_verify_pool_t verify_pool = {
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+  .work_cond = PTHREAD_COND_INITIALIZER,
+  .done_cond = PTHREAD_COND_INITIALIZER,
+  .submit_mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+static pthread_once_t verify_pool_once = PTHREAD_ONCE_INIT;
+
+static void verify_pool_drain(void) {
+  size_t failures = 0;
+  for (;;) {
+    size_t i = __atomic_fetch_add(&verify_pool.cursor, 1, __ATOMIC_RELAXED);
+    if (i >= verify_pool.count) {
+      break;
+    }
+    const mxd_sig_verify_item_t *item = &verify_pool.items[i];
+    int rc = mxd_dilithium_verify_cached(item->signature, item->signature_length,
+                                         item->message, item->message_length,
+                                         item->public_key);
+    verify_pool.results[i] = rc == 0 ? 0 : -1;
+    if (rc != 0) {
+      failures++;
+    }
+  }
+  if (failures > 0) {
+    __atomic_fetch_add(&verify_pool.failures, failures, __ATOMIC_RELAXED);
+  }
+}
+
+static void *verify_pool_worker(void *arg) {
+  (void)arg;
+  uint64_t seen = 0;
+  pthread_mutex_lock(&verify_pool.mutex);
+  for (;;) {
+    while (verify_pool.generation == seen) {
+      pthread_cond_wait(&verify_pool.work_cond, &verify_pool.mutex);
+    }
+    seen = verify_pool.generation;
+    pthread_mutex_unlock(&verify_pool.mutex);
+
+    verify_pool_drain();
+
+    pthread_mutex_lock(&verify_pool.mutex);
+    if (--verify_pool.active == 0) {
+      pthread_cond_signal(&verify_pool.done_cond);
+    }
+  }
+  return NULL;
+}
+
+static void verify_pool_start(void) {
+  long cpus = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  // The calling thread takes part in every batch, so start one fewer worker
+  size_t wanted = cpus > 1 ? (size_t)(cpus - 1) : 0;
+  if (wanted > MXD_VERIFY_MAX_WORKERS) {
+    wanted = MXD_VERIFY_MAX_WORKERS;
+  }
+
+  for (size_t i = 0; i < wanted; i++) {
+    if (pthread_create(&verify_pool.threads[i], NULL, verify_pool_worker, NULL) != 0) {
+      MXD_LOG_WARN("crypto", "Started %zu of %zu signature verification workers", i, wanted);
+      break;
+    }
+    pthread_detach(verify_pool.threads[i]);
+    verify_pool.worker_count++;
+  }
+}
+
+int mxd_dilithium_verify_batch(const mxd_sig_verify_item_t *items, size_t count,
+                               int *results) {
+  if ((!items || !results) && count > 0) {
+    return -1;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  pthread_once(&verify_pool_once, verify_pool_start);
+
+  if (count < MXD_VERIFY_MIN_PARALLEL || verify_pool.worker_count == 0 ||
+      pthread_mutex_trylock(&verify_pool.submit_mutex) != 0) {
+    int rc = 0;
+    for (size_t i = 0; i < count; i++) {
+      results[i] = mxd_dilithium_verify_cached(items[i].signature, items[i].signature_length,
+                                               items[i].message, items[i].message_length,
+                                               items[i].public_key) == 0 ? 0 : -1;
+      if (results[i] != 0) {
+        rc = -1;
+      }
+    }
+    return rc;
+  }
+
+  pthread_mutex_lock(&verify_pool.mutex);
+  verify_pool.items = items;
+  verify_pool.results = results;
+  verify_pool.count = count;
+  verify_pool.cursor = 0;
+  verify_pool.failures = 0;
+  verify_pool.active = verify_pool.worker_count;
+  verify_pool.generation++;
+  pthread_cond_broadcast(&verify_pool.work_cond);
+  pthread_mutex_unlock(&verify_pool.mutex);
+
+  verify_pool_drain();
+
+  pthread_mutex_lock(&verify_pool.mutex);
+  while (verify_pool.active > 0) {
+    pthread_cond_wait(&verify_pool.done_cond, &verify_pool.mutex);
+  }
+  size_t failures = verify_pool.failures;
+  verify_pool.items = NULL;
+  verify_pool.results = NULL;
+  verify_pool.count = 0;
+  pthread_mutex_unlock(&verify_pool.mutex);
+
+  pthread_mutex_unlock(&verify_pool.submit_mutex);
+  return failures == 0 ? 0 : -1;
+}
@@ -0,0 +1,396 @@
+#include "mxd_crypto_simd.h"
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__))
+#define MXD_SHA512_MB_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#ifdef MXD_SHA512_MB_X86
+
+#define MXD_SHA512_MB_MAX_LANES 8
+#define MXD_SHA512_BLOCK_SIZE 128
+
+static const uint64_t sha512_k[80] = {
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
+    0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+    0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
+    0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+    0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+    0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, 0x2de92c6f592b0275ULL,
+    0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL,
+    0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+    0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL,
+    0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL,
+    0x92722c851482353bULL, 0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+    0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+    0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL,
+    0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+    0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL,
+    0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL,
+    0xc67178f2e372532bULL, 0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+    0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL,
+    0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+    0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+    0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL};
+
+static const uint64_t sha512_iv[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+    0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL};
+
+static const uint8_t sha512_zero_block[MXD_SHA512_BLOCK_SIZE];
+
+// Lane state is kept transposed (word-major) so each SHA-512 state word for
+// all lanes can be loaded into one vector register
+typedef uint64_t mxd_sha512_mb_state_t[8][MXD_SHA512_MB_MAX_LANES];
+
+typedef void (*mxd_sha512_mb_kernel_t)(
+    mxd_sha512_mb_state_t state,
+    const uint8_t *const blocks[MXD_SHA512_MB_MAX_LANES]);
+
+static inline uint64_t load_be64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return __builtin_bswap64(v);
+}
+
+static inline void store_be64(uint8_t *p, uint64_t v) {
+  v = __builtin_bswap64(v);
+  memcpy(p, &v, sizeof(v));
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 kernel: 4 lanes per 256-bit register
+// ---------------------------------------------------------------------------
+
+#define ROR256(x, n)                                                           \
+  _mm256_or_si256(_mm256_srli_epi64((x), (n)), _mm256_slli_epi64((x), 64 - (n)))
+
+__attribute__((target("avx2"))) static void
+sha512_x4_avx2(mxd_sha512_mb_state_t state,
+               const uint8_t *const blocks[MXD_SHA512_MB_MAX_LANES]) {
+  __m256i a = _mm256_loadu_si256((const __m256i *)state[0]);
+  __m256i b = _mm256_loadu_si256((const __m256i *)state[1]);
+  __m256i c = _mm256_loadu_si256((const __m256i *)state[2]);
+  __m256i d = _mm256_loadu_si256((const __m256i *)state[3]);
+  __m256i e = _mm256_loadu_si256((const __m256i *)state[4]);
+  __m256i f = _mm256_loadu_si256((const __m256i *)state[5]);
+  __m256i g = _mm256_loadu_si256((const __m256i *)state[6]);
+  __m256i h = _mm256_loadu_si256((const __m256i *)state[7]);
+  __m256i w[16];
+
+  for (int t = 0; t < 16; t++) {
+    w[t] = _mm256_set_epi64x(
+        (long long)load_be64(blocks[3] + 8 * t),
+        (long long)load_be64(blocks[2] + 8 * t),
+        (long long)load_be64(blocks[1] + 8 * t),
+        (long long)load_be64(blocks[0] + 8 * t));
+  }
+
+  for (int t = 0; t < 80; t++) {
+    if (t >= 16) {
+      __m256i w2 = w[(t - 2) & 15];
+      __m256i w15 = w[(t - 15) & 15];
+      __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ROR256(w15, 1),
+                                                     ROR256(w15, 8)),
+                                    _mm256_srli_epi64(w15, 7));
+      __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ROR256(w2, 19),
+                                                     ROR256(w2, 61)),
+                                    _mm256_srli_epi64(w2, 6));
+      w[t & 15] = _mm256_add_epi64(
+          _mm256_add_epi64(w[t & 15], s0),
+          _mm256_add_epi64(w[(t - 7) & 15], s1));
+    }
+
+    __m256i big_s1 = _mm256_xor_si256(
+        _mm256_xor_si256(ROR256(e, 14), ROR256(e, 18)), ROR256(e, 41));
+    __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f),
+                                  _mm256_andnot_si256(e, g));
+    __m256i t1 = _mm256_add_epi64(
+        _mm256_add_epi64(h, big_s1),
+        _mm256_add_epi64(
+            _mm256_add_epi64(ch, _mm256_set1_epi64x((long long)sha512_k[t])),
+            w[t & 15]));
+    __m256i big_s0 = _mm256_xor_si256(
+        _mm256_xor_si256(ROR256(a, 28), ROR256(a, 34)), ROR256(a, 39));
+    __m256i maj = _mm256_xor_si256(
+        _mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+        _mm256_and_si256(b, c));
+    __m256i t2 = _mm256_add_epi64(big_s0, maj);
+
+    h = g;
+    g = f;
+    f = e;
+    e = _mm256_add_epi64(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = _mm256_add_epi64(t1, t2);
+  }
+
+  __m256i words[8] = {a, b, c, d, e, f, g, h};
+  for (int i = 0; i < 8; i++) {
+    __m256i prev = _mm256_loadu_si256((const __m256i *)state[i]);
+    _mm256_storeu_si256((__m256i *)state[i], _mm256_add_epi64(prev, words[i]));
+  }
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 kernel: 8 lanes per 512-bit register, native rotates and ternary
+// logic for Ch/Maj
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx512f"))) static void
+sha512_x8_avx512(mxd_sha512_mb_state_t state,
+                 const uint8_t *const blocks[MXD_SHA512_MB_MAX_LANES]) {
+  __m512i a = _mm512_loadu_si512((const void *)state[0]);
+  __m512i b = _mm512_loadu_si512((const void *)state[1]);
+  __m512i c = _mm512_loadu_si512((const void *)state[2]);
+  __m512i d = _mm512_loadu_si512((const void *)state[3]);
+  __m512i e = _mm512_loadu_si512((const void *)state[4]);
+  __m512i f = _mm512_loadu_si512((const void *)state[5]);
+  __m512i g = _mm512_loadu_si512((const void *)state[6]);
+  __m512i h = _mm512_loadu_si512((const void *)state[7]);
+  __m512i w[16];
+
+  for (int t = 0; t < 16; t++) {
+    w[t] = _mm512_set_epi64(
+        (long long)load_be64(blocks[7] + 8 * t),
+        (long long)load_be64(blocks[6] + 8 * t),
+        (long long)load_be64(blocks[5] + 8 * t),
+        (long long)load_be64(blocks[4] + 8 * t),
+        (long long)load_be64(blocks[3] + 8 * t),
+        (long long)load_be64(blocks[2] + 8 * t),
+        (long long)load_be64(blocks[1] + 8 * t),
+        (long long)load_be64(blocks[0] + 8 * t));
+  }
+
+  for (int t = 0; t < 80; t++) {
+    if (t >= 16) {
+      __m512i w2 = w[(t - 2) & 15];
+      __m512i w15 = w[(t - 15) & 15];
+      __m512i s0 = _mm512_ternarylogic_epi64(_mm512_ror_epi64(w15, 1),
+                                             _mm512_ror_epi64(w15, 8),
+                                             _mm512_srli_epi64(w15, 7), 0x96);
+      __m512i s1 = _mm512_ternarylogic_epi64(_mm512_ror_epi64(w2, 19),
+                                             _mm512_ror_epi64(w2, 61),
+                                             _mm512_srli_epi64(w2, 6), 0x96);
+      w[t & 15] = _mm512_add_epi64(
+          _mm512_add_epi64(w[t & 15], s0),
+          _mm512_add_epi64(w[(t - 7) & 15], s1));
+    }
+
+    __m512i big_s1 = _mm512_ternarylogic_epi64(
+        _mm512_ror_epi64(e, 14), _mm512_ror_epi64(e, 18),
+        _mm512_ror_epi64(e, 41), 0x96);
+    __m512i ch = _mm512_ternarylogic_epi64(e, f, g, 0xCA);
+    __m512i t1 = _mm512_add_epi64(
+        _mm512_add_epi64(h, big_s1),
+        _mm512_add_epi64(
+            _mm512_add_epi64(ch, _mm512_set1_epi64((long long)sha512_k[t])),
+            w[t & 15]));
+    __m512i big_s0 = _mm512_ternarylogic_epi64(
+        _mm512_ror_epi64(a, 28), _mm512_ror_epi64(a, 34),
+        _mm512_ror_epi64(a, 39), 0x96);
+    __m512i maj = _mm512_ternarylogic_epi64(a, b, c, 0xE8);
+    __m512i t2 = _mm512_add_epi64(big_s0, maj);
+
+    h = g;
+    g = f;
+    f = e;
+    e = _mm512_add_epi64(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = _mm512_add_epi64(t1, t2);
+  }
+
+  __m512i words[8] = {a, b, c, d, e, f, g, h};
+  for (int i = 0; i < 8; i++) {
+    __m512i prev = _mm512_loadu_si512((const void *)state[i]);
+    _mm512_storeu_si512((void *)state[i], _mm512_add_epi64(prev, words[i]));
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Lane scheduler: every lane walks its own message block by block; when a
+// lane finishes it is immediately refilled with the next pending message so
+// messages of different lengths keep all lanes busy
+// ---------------------------------------------------------------------------
+
+typedef struct {
+  const uint8_t *data;
+  size_t length;
+  uint64_t total_blocks;
+  uint64_t next_block;
+  size_t job;
+  int active;
+} mxd_sha512_lane_t;
+
+static uint64_t sha512_block_count(size_t length) {
+  // Message + 0x80 terminator + 128-bit length, rounded up to whole blocks
+  return ((uint64_t)length + 1 + 16 + MXD_SHA512_BLOCK_SIZE - 1) /
+         MXD_SHA512_BLOCK_SIZE;
+}
+
+// Returns a pointer to block `index` of the padded message; whole blocks are
+// read in place, only the tail is copied into `scratch`
+static const uint8_t *sha512_lane_block(const mxd_sha512_lane_t *lane,
+                                        uint8_t scratch[MXD_SHA512_BLOCK_SIZE]) {
+  uint64_t offset = lane->next_block * MXD_SHA512_BLOCK_SIZE;
+  if (offset + MXD_SHA512_BLOCK_SIZE <= lane->length) {
+    return lane->data + offset;
+  }
+
+  memset(scratch, 0, MXD_SHA512_BLOCK_SIZE);
+  if (offset < lane->length) {
+    memcpy(scratch, lane->data + offset, lane->length - offset);
+  }
+  if (offset <= lane->length) {
+    scratch[lane->length - offset] = 0x80;
+  }
+  if (lane->next_block == lane->total_blocks - 1) {
+    uint64_t length = (uint64_t)lane->length;
+    store_be64(scratch + 112, length >> 61);
+    store_be64(scratch + 120, length << 3);
+  }
+  return scratch;
+}
+
+static void sha512_lane_start(mxd_sha512_lane_t *lane, mxd_sha512_mb_state_t state,
+                              size_t lane_index, size_t job,
+                              const uint8_t *const inputs[],
+                              const size_t lengths[]) {
+  lane->data = inputs[job];
+  lane->length = lengths[job];
+  lane->total_blocks = sha512_block_count(lengths[job]);
+  lane->next_block = 0;
+  lane->job = job;
+  lane->active = 1;
+  for (int i = 0; i < 8; i++) {
+    state[i][lane_index] = sha512_iv[i];
+  }
+}
+
+static void sha512_mb_run(mxd_sha512_mb_kernel_t kernel, size_t lanes,
+                          const uint8_t *const inputs[], const size_t lengths[],
+                          uint8_t outputs[][64], size_t count) {
+  mxd_sha512_mb_state_t state;
+  mxd_sha512_lane_t lane[MXD_SHA512_MB_MAX_LANES];
+  uint8_t scratch[MXD_SHA512_MB_MAX_LANES][MXD_SHA512_BLOCK_SIZE];
+  const uint8_t *blocks[MXD_SHA512_MB_MAX_LANES];
+  size_t next_job = 0;
+  size_t active = 0;
+
+  memset(state, 0, sizeof(state));
+  memset(lane, 0, sizeof(lane));
+  for (size_t l = 0; l < MXD_SHA512_MB_MAX_LANES; l++) {
+    blocks[l] = sha512_zero_block;
+  }
+
+  for (size_t l = 0; l < lanes && next_job < count; l++) {
+    sha512_lane_start(&lane[l], state, l, next_job++, inputs, lengths);
+    active++;
+  }
+
+  while (active > 0) {
+    for (size_t l = 0; l < lanes; l++) {
+      blocks[l] = lane[l].active ? sha512_lane_block(&lane[l], scratch[l])
+                                 : sha512_zero_block;
+    }
+
+    kernel(state, blocks);
+
+    for (size_t l = 0; l < lanes; l++) {
+      if (!lane[l].active || ++lane[l].next_block < lane[l].total_blocks) {
+        continue;
+      }
+
+      for (int i = 0; i < 8; i++) {
+        store_be64(outputs[lane[l].job] + 8 * i, state[i][l]);
+      }
+      lane[l].active = 0;
+      active--;
+
+      if (next_job < count) {
+        sha512_lane_start(&lane[l], state, l, next_job++, inputs, lengths);
+        active++;
+      }
+    }
+  }
+}
+
+uint32_t mxd_cpu_detect_features(void) {
+  uint32_t features = 0;
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    features |= MXD_CPU_FEATURE_AVX2;
+  }
+  if (__builtin_cpu_supports("avx512f")) {
+    features |= MXD_CPU_FEATURE_AVX512F;
+  }
+  // SHA extensions: CPUID.(EAX=7,ECX=0):EBX bit 29
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1u << 29))) {
+    features |= MXD_CPU_FEATURE_SHA_NI;
+  }
+  return features;
+}
+
+mxd_sha512_mb_backend_t mxd_sha512_mb_detect(void) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return MXD_SHA512_MB_AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return MXD_SHA512_MB_AVX2;
+  }
+  return MXD_SHA512_MB_SCALAR;
+}
+
+int mxd_sha512_mb_hash(mxd_sha512_mb_backend_t backend,
+                       const uint8_t *const inputs[], const size_t lengths[],
+                       uint8_t outputs[][64], size_t count) {
+  switch (backend) {
+  case MXD_SHA512_MB_AVX512:
+    sha512_mb_run(sha512_x8_avx512, 8, inputs, lengths, outputs, count);
+    return 0;
+  case MXD_SHA512_MB_AVX2:
+    sha512_mb_run(sha512_x4_avx2, 4, inputs, lengths, outputs, count);
+    return 0;
+  default:
+    return -1;
+  }
+}
+
+#else // !MXD_SHA512_MB_X86
+
+uint32_t mxd_cpu_detect_features(void) {
+  return 0;
+}
+
+mxd_sha512_mb_backend_t mxd_sha512_mb_detect(void) {
+  return MXD_SHA512_MB_SCALAR;
+}
+
+int mxd_sha512_mb_hash(mxd_sha512_mb_backend_t backend,
+                       const uint8_t *const inputs[], const size_t lengths[],
+                       uint8_t outputs[][64], size_t count) {
+  (void)backend;
+  (void)inputs;
+  (void)lengths;
+  (void)outputs;
+  (void)count;
+  return -1;
+}
+
+#endif // MXD_SHA512_MB_X86
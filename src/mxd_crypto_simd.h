@@ -0,0 +1,28 @@
+#ifndef MXD_CRYPTO_SIMD_H
+#define MXD_CRYPTO_SIMD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../include/mxd_crypto.h"
+
+// Multi-buffer SHA-512 backends, fastest last
+typedef enum {
+  MXD_SHA512_MB_SCALAR = 0,
+  MXD_SHA512_MB_AVX2 = 1,
+  MXD_SHA512_MB_AVX512 = 2
+} mxd_sha512_mb_backend_t;
+
+// CPU features relevant to hashing (MXD_CPU_FEATURE_* bits from mxd_crypto.h)
+uint32_t mxd_cpu_detect_features(void);
+
+// Best multi-buffer backend supported by the running CPU
+mxd_sha512_mb_backend_t mxd_sha512_mb_detect(void);
+
+// Hash count independent messages with the given SIMD backend. Returns -1 if
+// the backend is not compiled in; MXD_SHA512_MB_SCALAR is handled by the
+// caller.
+int mxd_sha512_mb_hash(mxd_sha512_mb_backend_t backend,
+                       const uint8_t *const inputs[], const size_t lengths[],
+                       uint8_t outputs[][64], size_t count);
+
+#endif // MXD_CRYPTO_SIMD_H
@@ -56,13 +56,23 @@ int mxd_run_transaction_load_test(const mxd_load_test_config_t *config, mxd_load
     uint64_t end_time = start_time + (config->duration_seconds * 1000);
     uint64_t interval_ms = 1000 / config->target_tps;
     
+    // Requests build their transaction in one arena that is reset each time
+    uint8_t arena_buffer[sizeof(mxd_tx_output_t) + 64];
+    mxd_arena_t arena;
+    mxd_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+    uint8_t recipient_key[256] = {1};
+    
     while (get_timestamp_ms() < end_time) {
         double request_start = get_timestamp_us();
         
+        // Only building the transaction is timed
         mxd_transaction_t tx;
-        int success = (mxd_create_transaction(&tx) == 0);
+        mxd_tx_builder_t builder;
+        int success = (mxd_tx_builder_begin(&builder, &arena, &tx, 0, 1) == 0 &&
+                       mxd_tx_builder_add_output(&builder, recipient_key, 1.0) == 0);
         
         double request_end = get_timestamp_us();
+        mxd_arena_reset(&arena);
         double response_time = (request_end - request_start) / 1000.0;
         
         results->total_requests++;
@@ -1,292 +1,1048 @@
 #include "../include/mxd_mempool.h"
 #include "../include/mxd_crypto.h"
+#include <math.h>
+#include <openssl/rand.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-// Mempool storage
+// Entries are kept densely in mempool[0..mempool_size). Three structures
+// refer to them by slot:
+//  - a hash index (open addressing, linear probing, backward-shift
+//    deletion) from tx hash to slot, for O(1) lookup and duplicate checks;
+//  - a binary heap of slots with the lowest fee rate first, tracking every
+//    slot's position so any entry is removed in O(log n);
+//  - a spent-outpoint index, built the same way as the hash index, from
+//    each outpoint a pooled transaction spends to its (slot, input), so
+//    conflicts and descendants are found without scanning the pool.
+// Removing an entry moves the last slot into its place.
+//
+// All of it is guarded by mempool_lock. Submitting threads hash and copy
+// their transaction before taking the write lock, so the exclusive section
+// is just the index and heap updates. Block assembly does not hold the lock
+// while it selects and copies transactions: it reads an immutable snapshot
+// of the pool, taken under the read lock and then sorted best first
+// (compare_tx_entries) outside it, rebuilt only after the pool has changed.
+// Each entry keeps its inputs and outputs in one refcounted body, so a
+// snapshot shares them rather than copying, and they outlive eviction for
+// as long as a snapshot refers to them.
+#define MXD_MEMPOOL_INDEX_SLOTS 32768 // Power of two, over 3x MXD_MAX_MEMPOOL_SIZE
+#define MXD_MEMPOOL_SPENT_MIN_SLOTS 4096 // Power of two; doubles at half load
+
+// Coins per byte the minimum fee rate is set above the best rate evicted,
+// and the half-life in seconds over which it decays back to zero
+#define MXD_MEMPOOL_FEE_RATE_STEP 1e-9
+#define MXD_MEMPOOL_MIN_FEE_HALF_LIFE 600
+
+typedef struct {
+  uint32_t slot;  // Slot + 1, 0 marks an empty bucket
+  uint32_t input; // Input of that transaction spending the outpoint
+} mxd_mempool_spent_ref_t;
+
+typedef struct {
+  uint64_t refs;
+  // Followed by the inputs, then the outputs
+} mxd_mempool_body_t;
+
+typedef struct {
+  uint64_t refs;
+  uint64_t version;               // mempool_version it was taken at
+  size_t count;
+  mxd_mempool_entry_t *entries;   // Best first; each holds a body reference
+} mxd_mempool_snapshot_t;
+
+typedef struct {
+  uint32_t *order; // Slots in heap order
+  uint32_t *pos;   // Heap position of each slot
+  int (*before)(const mxd_mempool_entry_t *a, const mxd_mempool_entry_t *b);
+} mxd_mempool_heap_t;
+
+static pthread_rwlock_t mempool_lock = PTHREAD_RWLOCK_INITIALIZER;
 static mxd_mempool_entry_t *mempool = NULL;
 static size_t mempool_size = 0;
+static uint32_t *index_table = NULL; // Slot + 1, 0 marks an empty bucket
+static int evict_before(const mxd_mempool_entry_t *a, const mxd_mempool_entry_t *b);
+static mxd_mempool_heap_t evict_heap = {NULL, NULL, evict_before};
+static uint32_t *evict_set = NULL; // Scratch for slots removed by one admission
+static uint32_t *evict_mark = NULL; // evict_generation for slots in evict_set
+static uint32_t evict_generation = 0;
+static size_t *evict_frontier = NULL; // Scratch for walks over evict_heap
+static uint64_t index_seed = 0;
+static mxd_mempool_spent_ref_t *spent_index = NULL;
+static size_t spent_mask = 0;
+static size_t spent_count = 0;
+static size_t mempool_bytes = 0;
+static size_t mempool_max_bytes = MXD_MEMPOOL_DEFAULT_MAX_BYTES;
+static double min_fee_rate = 0.0;
+static time_t min_fee_rate_time = 0;
+static uint64_t mempool_version = 0; // Bumped on every change to the pool
+static pthread_mutex_t snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static mxd_mempool_snapshot_t *snapshot = NULL; // Latest, under snapshot_mutex
 
-// Initialize mempool
-int mxd_init_mempool(void) {
+static void retain_body(mxd_mempool_body_t *body) {
+  __atomic_add_fetch(&body->refs, 1, __ATOMIC_RELAXED);
+}
+
+static void release_body(mxd_mempool_body_t *body) {
+  if (body && __atomic_sub_fetch(&body->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+    free(body);
+  }
+}
+
+static void free_entry_tx(mxd_mempool_entry_t *entry) {
+  release_body(entry->body);
+  entry->body = NULL;
+  entry->tx.inputs = NULL;
+  entry->tx.outputs = NULL;
+}
+
+static void mark_changed(void) {
+  __atomic_add_fetch(&mempool_version, 1, __ATOMIC_RELEASE);
+}
+
+static void release_mempool(void) {
   if (mempool) {
-    // Clean up existing entries
     for (size_t i = 0; i < mempool_size; i++) {
-      free(mempool[i].tx.inputs);
-      free(mempool[i].tx.outputs);
+      free_entry_tx(&mempool[i]);
     }
-    free(mempool);
   }
-  mempool = malloc(MXD_MAX_MEMPOOL_SIZE * sizeof(mxd_mempool_entry_t));
-  if (!mempool) {
+  free(mempool);
+  free(index_table);
+  free(evict_heap.order);
+  free(evict_heap.pos);
+  free(evict_set);
+  free(evict_mark);
+  free(evict_frontier);
+  free(spent_index);
+  mempool = NULL;
+  index_table = NULL;
+  evict_heap.order = NULL;
+  evict_heap.pos = NULL;
+  evict_set = NULL;
+  evict_mark = NULL;
+  evict_frontier = NULL;
+  spent_index = NULL;
+  mempool_size = 0;
+  spent_mask = 0;
+  spent_count = 0;
+  mempool_bytes = 0;
+  min_fee_rate = 0.0;
+  mark_changed();
+}
+
+// Initialize mempool
+int mxd_init_mempool(void) {
+  pthread_rwlock_wrlock(&mempool_lock);
+  release_mempool();
+
+  mempool = calloc(MXD_MAX_MEMPOOL_SIZE, sizeof(mxd_mempool_entry_t));
+  index_table = calloc(MXD_MEMPOOL_INDEX_SLOTS, sizeof(uint32_t));
+  evict_heap.order = calloc(MXD_MAX_MEMPOOL_SIZE, sizeof(uint32_t));
+  evict_heap.pos = calloc(MXD_MAX_MEMPOOL_SIZE, sizeof(uint32_t));
+  evict_set = calloc(MXD_MAX_MEMPOOL_SIZE, sizeof(uint32_t));
+  evict_mark = calloc(MXD_MAX_MEMPOOL_SIZE, sizeof(uint32_t));
+  evict_frontier = calloc(MXD_MAX_MEMPOOL_SIZE + 1, sizeof(size_t));
+  spent_index = calloc(MXD_MEMPOOL_SPENT_MIN_SLOTS, sizeof(mxd_mempool_spent_ref_t));
+  if (!mempool || !index_table || !evict_heap.order || !evict_heap.pos || !evict_set || !evict_mark || !evict_frontier || !spent_index ||
+      RAND_bytes((unsigned char *)&index_seed, sizeof(index_seed)) != 1) {
+    release_mempool();
+    pthread_rwlock_unlock(&mempool_lock);
     return -1;
   }
-  memset(mempool, 0, MXD_MAX_MEMPOOL_SIZE * sizeof(mxd_mempool_entry_t));
-  mempool_size = 0;
+  spent_mask = MXD_MEMPOOL_SPENT_MIN_SLOTS - 1;
+  pthread_rwlock_unlock(&mempool_lock);
   return 0;
 }
 
-// Compare function for transaction sorting
-static int compare_tx_entries(const void *a, const void *b) {
-  const mxd_mempool_entry_t *entry_a = (const mxd_mempool_entry_t *)a;
-  const mxd_mempool_entry_t *entry_b = (const mxd_mempool_entry_t *)b;
+// Sign of fee_a / size_a - fee_b / size_b, without dividing
+static int compare_fee_rates(const mxd_mempool_entry_t *entry_a,
+                             const mxd_mempool_entry_t *entry_b) {
+  double rate_a = entry_a->fee * (double)entry_b->size;
+  double rate_b = entry_b->fee * (double)entry_a->size;
+  return (rate_a > rate_b) - (rate_a < rate_b);
+}
+
+static double fee_rate(const mxd_mempool_entry_t *entry) {
+  return entry->fee / (double)entry->size;
+}
 
+// Compare function for transaction ordering: positive if a goes before b
+static int compare_tx_entries(const mxd_mempool_entry_t *entry_a,
+                              const mxd_mempool_entry_t *entry_b) {
   // First compare by priority
   if (entry_a->priority != entry_b->priority) {
-    return entry_b->priority - entry_a->priority;
+    return entry_a->priority > entry_b->priority ? 1 : -1;
   }
 
-  // Then by fee (higher fee first)
-  if (entry_a->fee > entry_b->fee)
-    return -1;
-  if (entry_a->fee < entry_b->fee)
-    return 1;
+  // Then by fee rate (higher first)
+  int rate = compare_fee_rates(entry_a, entry_b);
+  if (rate != 0)
+    return rate;
 
   // Finally by timestamp (older first)
   if (entry_a->timestamp < entry_b->timestamp)
-    return -1;
-  if (entry_a->timestamp > entry_b->timestamp)
     return 1;
+  if (entry_a->timestamp > entry_b->timestamp)
+    return -1;
 
   return 0;
 }
 
-// Add transaction to mempool
-int mxd_add_to_mempool(const mxd_transaction_t *tx,
-                       mxd_tx_priority_t priority) {
-  if (!tx || !mempool || priority < MXD_PRIORITY_LOW ||
-      priority > MXD_PRIORITY_HIGH) {
-    return -1;
+// Eviction order: lowest fee rate, then newest, then by hash so the order
+// is total and does not depend on slots
+static int evict_before(const mxd_mempool_entry_t *a, const mxd_mempool_entry_t *b) {
+  int rate = compare_fee_rates(a, b);
+  if (rate != 0) {
+    return rate < 0;
+  }
+  if (a->timestamp != b->timestamp) {
+    return a->timestamp > b->timestamp;
+  }
+  return memcmp(a->tx_hash, b->tx_hash, 64) < 0;
+}
+
+// Tx hashes are attacker-influenced, so buckets depend on a random seed
+static size_t index_bucket(const uint8_t tx_hash[64]) {
+  uint64_t h;
+  memcpy(&h, tx_hash, sizeof(h));
+  h ^= index_seed;
+  h ^= h >> 30;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  h ^= h >> 27;
+  h *= 0x94D049BB133111EBULL;
+  h ^= h >> 31;
+  return (size_t)h & (MXD_MEMPOOL_INDEX_SLOTS - 1);
+}
+
+// Bucket holding tx_hash, or -1
+static long index_find(const uint8_t tx_hash[64]) {
+  for (size_t i = index_bucket(tx_hash); index_table[i];
+       i = (i + 1) & (MXD_MEMPOOL_INDEX_SLOTS - 1)) {
+    if (memcmp(mempool[index_table[i] - 1].tx_hash, tx_hash, 64) == 0) {
+      return (long)i;
+    }
+  }
+  return -1;
+}
+
+static void index_insert(const uint8_t tx_hash[64], uint32_t slot) {
+  size_t i = index_bucket(tx_hash);
+  while (index_table[i]) {
+    i = (i + 1) & (MXD_MEMPOOL_INDEX_SLOTS - 1);
+  }
+  index_table[i] = slot + 1;
+}
+
+// Empty bucket i, shifting later members of its probe run back
+static void index_delete(size_t i) {
+  size_t j = i;
+  for (;;) {
+    j = (j + 1) & (MXD_MEMPOOL_INDEX_SLOTS - 1);
+    if (!index_table[j]) {
+      break;
+    }
+    size_t home = index_bucket(mempool[index_table[j] - 1].tx_hash);
+    int stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+    if (stays) {
+      continue;
+    }
+    index_table[i] = index_table[j];
+    i = j;
+  }
+  index_table[i] = 0;
+}
+
+static size_t spent_bucket(const uint8_t prev_tx_hash[64], uint32_t output_index) {
+  uint64_t h;
+  memcpy(&h, prev_tx_hash, sizeof(h));
+  h ^= index_seed ^ ((uint64_t)output_index * 0x9E3779B97F4A7C15ULL);
+  h ^= h >> 30;
+  h *= 0xBF58476D1CE4E5B9ULL;
+  h ^= h >> 27;
+  h *= 0x94D049BB133111EBULL;
+  h ^= h >> 31;
+  return (size_t)h & spent_mask;
+}
+
+static const mxd_tx_input_t *spent_input(mxd_mempool_spent_ref_t ref) {
+  return &mempool[ref.slot - 1].tx.inputs[ref.input];
+}
+
+// Bucket recording who spends (prev_tx_hash, output_index), or -1
+static long spent_find(const uint8_t prev_tx_hash[64], uint32_t output_index) {
+  for (size_t i = spent_bucket(prev_tx_hash, output_index); spent_index[i].slot;
+       i = (i + 1) & spent_mask) {
+    const mxd_tx_input_t *input = spent_input(spent_index[i]);
+    if (input->output_index == output_index &&
+        memcmp(input->prev_tx_hash, prev_tx_hash, 64) == 0) {
+      return (long)i;
+    }
+  }
+  return -1;
+}
+
+static void spent_place(mxd_mempool_spent_ref_t ref) {
+  const mxd_tx_input_t *input = spent_input(ref);
+  size_t i = spent_bucket(input->prev_tx_hash, input->output_index);
+  while (spent_index[i].slot) {
+    i = (i + 1) & spent_mask;
+  }
+  spent_index[i] = ref;
+}
+
+// Make room for n more references at under half load
+static int spent_reserve(size_t n) {
+  size_t slot_count = spent_mask + 1;
+  while ((spent_count + n) * 2 > slot_count) {
+    slot_count *= 2;
+  }
+  if (slot_count == spent_mask + 1) {
+    return 0;
   }
 
-  // Check if mempool is full
-  if (mempool_size >= MXD_MAX_MEMPOOL_SIZE) {
+  mxd_mempool_spent_ref_t *old = spent_index;
+  size_t old_count = spent_mask + 1;
+  spent_index = calloc(slot_count, sizeof(mxd_mempool_spent_ref_t));
+  if (!spent_index) {
+    spent_index = old;
     return -1;
   }
+  spent_mask = slot_count - 1;
+  for (size_t i = 0; i < old_count; i++) {
+    if (old[i].slot) {
+      spent_place(old[i]);
+    }
+  }
+  free(old);
+  return 0;
+}
 
-  // Calculate transaction hash
-  uint8_t tx_hash[64];
-  if (mxd_calculate_tx_hash(tx, tx_hash) != 0) {
+// Empty bucket i, shifting later members of its probe run back
+static void spent_delete(size_t i) {
+  size_t j = i;
+  for (;;) {
+    j = (j + 1) & spent_mask;
+    if (!spent_index[j].slot) {
+      break;
+    }
+    const mxd_tx_input_t *input = spent_input(spent_index[j]);
+    size_t home = spent_bucket(input->prev_tx_hash, input->output_index);
+    int stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+    if (stays) {
+      continue;
+    }
+    spent_index[i] = spent_index[j];
+    i = j;
+  }
+  memset(&spent_index[i], 0, sizeof(mxd_mempool_spent_ref_t));
+  spent_count--;
+}
+
+static int heap_before(const mxd_mempool_heap_t *h, size_t a, size_t b) {
+  return h->before(&mempool[h->order[a]], &mempool[h->order[b]]);
+}
+
+static void heap_swap(mxd_mempool_heap_t *h, size_t a, size_t b) {
+  uint32_t slot = h->order[a];
+  h->order[a] = h->order[b];
+  h->order[b] = slot;
+  h->pos[h->order[a]] = (uint32_t)a;
+  h->pos[h->order[b]] = (uint32_t)b;
+}
+
+static void heap_sift_up(mxd_mempool_heap_t *h, size_t i) {
+  while (i > 0 && heap_before(h, i, (i - 1) / 2)) {
+    heap_swap(h, i, (i - 1) / 2);
+    i = (i - 1) / 2;
+  }
+}
+
+static void heap_sift_down(mxd_mempool_heap_t *h, size_t i, size_t count) {
+  for (;;) {
+    size_t best = i;
+    size_t left = 2 * i + 1;
+    if (left < count && heap_before(h, left, best)) {
+      best = left;
+    }
+    if (left + 1 < count && heap_before(h, left + 1, best)) {
+      best = left + 1;
+    }
+    if (best == i) {
+      return;
+    }
+    heap_swap(h, i, best);
+    i = best;
+  }
+}
+
+// Add the newest entry, whose slot is the next free heap position
+static void heap_push(mxd_mempool_heap_t *h, uint32_t slot) {
+  h->order[slot] = slot;
+  h->pos[slot] = slot;
+  heap_sift_up(h, slot);
+}
+
+// Take slot out of a heap of count entries, refilling its position from
+// the end
+static void heap_erase(mxd_mempool_heap_t *h, uint32_t slot, size_t count) {
+  size_t pos = h->pos[slot];
+  size_t last_pos = count - 1;
+  if (pos != last_pos) {
+    heap_swap(h, pos, last_pos);
+  }
+  if (pos < last_pos) {
+    uint32_t moved = h->order[pos];
+    heap_sift_up(h, pos);
+    heap_sift_down(h, h->pos[moved], last_pos);
+  }
+}
+
+// Record that the entry in slot from now lives in slot to
+static void heap_relabel(mxd_mempool_heap_t *h, uint32_t from, uint32_t to) {
+  h->pos[to] = h->pos[from];
+  h->order[h->pos[to]] = to;
+}
+
+// Best-first walk over a heap without modifying it: a frontier of heap
+// positions, itself a small heap, starts at the root and gains the
+// children of each entry taken. Taking k entries costs O(k log k).
+typedef struct {
+  const mxd_mempool_heap_t *heap;
+  size_t *frontier;
+  size_t size;
+} mxd_mempool_walk_t;
+
+// The frontier must hold one more position than the number of entries taken
+static void walk_begin(mxd_mempool_walk_t *walk, const mxd_mempool_heap_t *h, size_t *frontier) {
+  walk->heap = h;
+  walk->frontier = frontier;
+  walk->size = 0;
+  if (mempool_size > 0) {
+    walk->frontier[walk->size++] = 0;
+  }
+}
+
+// Next slot in heap order, or -1 once the heap is exhausted
+static long walk_next(mxd_mempool_walk_t *walk) {
+  const mxd_mempool_heap_t *h = walk->heap;
+  size_t *frontier = walk->frontier;
+  if (walk->size == 0) {
     return -1;
   }
 
-  // Check if transaction already exists
-  for (size_t i = 0; i < mempool_size; i++) {
-    uint8_t existing_hash[64];
-    if (mxd_calculate_tx_hash(&mempool[i].tx, existing_hash) == 0 &&
-        memcmp(existing_hash, tx_hash, 64) == 0) {
-      return -1;
+  size_t pos = frontier[0];
+  frontier[0] = frontier[--walk->size];
+  for (size_t i = 0;;) {
+    size_t best = i;
+    size_t left = 2 * i + 1;
+    if (left < walk->size && heap_before(h, frontier[left], frontier[best])) {
+      best = left;
+    }
+    if (left + 1 < walk->size && heap_before(h, frontier[left + 1], frontier[best])) {
+      best = left + 1;
     }
+    if (best == i) {
+      break;
+    }
+    size_t tmp = frontier[i];
+    frontier[i] = frontier[best];
+    frontier[best] = tmp;
+    i = best;
   }
 
-  // Initialize new entry
-  memset(&mempool[mempool_size], 0, sizeof(mxd_mempool_entry_t));
+  for (size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < mempool_size; child++) {
+    size_t i = walk->size++;
+    frontier[i] = child;
+    while (i > 0 && heap_before(h, frontier[i], frontier[(i - 1) / 2])) {
+      size_t tmp = frontier[i];
+      frontier[i] = frontier[(i - 1) / 2];
+      frontier[(i - 1) / 2] = tmp;
+      i = (i - 1) / 2;
+    }
+  }
+
+  return (long)h->order[pos];
+}
+
+// Drop the entry in slot, keeping all structures consistent
+static void remove_slot(uint32_t slot) {
+  const mxd_transaction_t *tx = &mempool[slot].tx;
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    spent_delete((size_t)spent_find(tx->inputs[i].prev_tx_hash, tx->inputs[i].output_index));
+  }
+  index_delete((size_t)index_find(mempool[slot].tx_hash));
+  heap_erase(&evict_heap, slot, mempool_size);
+  mempool_bytes -= mempool[slot].size;
+  free_entry_tx(&mempool[slot]);
+  mempool_size--;
+  mark_changed();
+
+  // Keep the slots dense by moving the last entry into the freed one
+  uint32_t last = (uint32_t)mempool_size;
+  if (slot != last) {
+    long bucket = index_find(mempool[last].tx_hash);
+    mempool[slot] = mempool[last];
+    index_table[bucket] = slot + 1;
+    heap_relabel(&evict_heap, last, slot);
+    const mxd_transaction_t *moved = &mempool[slot].tx;
+    for (uint32_t i = 0; i < moved->input_count; i++) {
+      spent_index[spent_find(moved->inputs[i].prev_tx_hash, moved->inputs[i].output_index)].slot = slot + 1;
+    }
+  }
+  memset(&mempool[last], 0, sizeof(mxd_mempool_entry_t));
+}
 
-  // Copy basic transaction fields
-  memcpy(&mempool[mempool_size].tx, tx, sizeof(mxd_transaction_t));
-  mempool[mempool_size].tx.inputs = NULL;
-  mempool[mempool_size].tx.outputs = NULL;
+// Deep copy of a transaction's inputs and outputs onto the heap
+static int copy_transaction(mxd_transaction_t *dst, const mxd_transaction_t *src) {
+  memcpy(dst, src, sizeof(mxd_transaction_t));
+  dst->inputs = NULL;
+  dst->outputs = NULL;
+  dst->arena_allocated = 0; // Copies below live on the heap
 
   // Copy inputs if present
-  if (tx->inputs && tx->input_count > 0) {
-    mempool[mempool_size].tx.inputs =
-        malloc(tx->input_count * sizeof(mxd_tx_input_t));
-    if (!mempool[mempool_size].tx.inputs) {
+  if (src->inputs && src->input_count > 0) {
+    dst->inputs = malloc(src->input_count * sizeof(mxd_tx_input_t));
+    if (!dst->inputs) {
       return -1;
     }
-    memcpy(mempool[mempool_size].tx.inputs, tx->inputs,
-           tx->input_count * sizeof(mxd_tx_input_t));
+    memcpy(dst->inputs, src->inputs, src->input_count * sizeof(mxd_tx_input_t));
   }
 
   // Copy outputs if present
-  if (tx->outputs && tx->output_count > 0) {
-    mempool[mempool_size].tx.outputs =
-        malloc(tx->output_count * sizeof(mxd_tx_output_t));
-    if (!mempool[mempool_size].tx.outputs) {
-      free(mempool[mempool_size].tx.inputs);
+  if (src->outputs && src->output_count > 0) {
+    dst->outputs = malloc(src->output_count * sizeof(mxd_tx_output_t));
+    if (!dst->outputs) {
+      free(dst->inputs);
+      dst->inputs = NULL;
       return -1;
     }
-    memcpy(mempool[mempool_size].tx.outputs, tx->outputs,
-           tx->output_count * sizeof(mxd_tx_output_t));
+    memcpy(dst->outputs, src->outputs, src->output_count * sizeof(mxd_tx_output_t));
   }
 
-  mempool[mempool_size].priority = priority;
-  mempool[mempool_size].timestamp = time(NULL);
-  mempool[mempool_size].fee = mxd_get_voluntary_tip(tx);
+  return 0;
+}
 
-  mempool_size++;
+// Copy a transaction into an entry, placing its inputs and outputs in a
+// new refcounted body
+static int share_transaction(mxd_mempool_entry_t *entry, const mxd_transaction_t *src) {
+  size_t inputs_size = src->inputs ? src->input_count * sizeof(mxd_tx_input_t) : 0;
+  size_t outputs_size = src->outputs ? src->output_count * sizeof(mxd_tx_output_t) : 0;
+  mxd_mempool_body_t *body = malloc(sizeof(mxd_mempool_body_t) + inputs_size + outputs_size);
+  if (!body) {
+    return -1;
+  }
+  body->refs = 1;
+
+  uint8_t *data = (uint8_t *)(body + 1);
+  memcpy(&entry->tx, src, sizeof(mxd_transaction_t));
+  entry->tx.arena_allocated = 0;
+  entry->tx.inputs = inputs_size ? (mxd_tx_input_t *)data : NULL;
+  entry->tx.outputs = outputs_size ? (mxd_tx_output_t *)(data + inputs_size) : NULL;
+  if (inputs_size) {
+    memcpy(entry->tx.inputs, src->inputs, inputs_size);
+  }
+  if (outputs_size) {
+    memcpy(entry->tx.outputs, src->outputs, outputs_size);
+  }
+  entry->body = body;
+  return 0;
+}
+
+// Start a new set in evict_set
+static void evict_set_begin(void) {
+  if (++evict_generation == 0) {
+    memset(evict_mark, 0, MXD_MAX_MEMPOOL_SIZE * sizeof(uint32_t));
+    evict_generation = 1;
+  }
+}
+
+static int in_evict_set(uint32_t slot) {
+  return evict_mark[slot] == evict_generation;
+}
+
+// Add slot and every pooled transaction spending its outputs, directly or
+// transitively, to evict_set. Fails once the set would exceed cap entries.
+// Membership is a mark per slot, so the cost is linear in what is added.
+static int collect_with_descendants(uint32_t slot, size_t *set_count, size_t cap) {
+  if (in_evict_set(slot)) {
+    return 0;
+  }
+  if (*set_count >= cap) {
+    return -1;
+  }
+
+  size_t next = *set_count;
+  evict_set[(*set_count)++] = slot;
+  evict_mark[slot] = evict_generation;
+  for (; next < *set_count; next++) {
+    const mxd_mempool_entry_t *parent = &mempool[evict_set[next]];
+    for (uint32_t out = 0; out < parent->tx.output_count; out++) {
+      long bucket = spent_find(parent->tx_hash, out);
+      if (bucket < 0) {
+        continue;
+      }
+      uint32_t child = spent_index[bucket].slot - 1;
+      if (in_evict_set(child)) {
+        continue;
+      }
+      if (*set_count >= cap) {
+        return -1;
+      }
+      evict_set[(*set_count)++] = child;
+      evict_mark[child] = evict_generation;
+    }
+  }
+  return 0;
+}
+
+static int compare_slots_desc(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x < y) - (x > y);
+}
+
+// Remove the given slots. Removal moves the last slot into the freed one,
+// so going from the highest slot down never moves a slot still to remove.
+static void remove_slots(uint32_t *slots, size_t count) {
+  qsort(slots, count, sizeof(uint32_t), compare_slots_desc);
+  for (size_t i = 0; i < count; i++) {
+    remove_slot(slots[i]);
+  }
+}
+
+// Minimum admission fee rate, decayed for the time since it was last raised
+static double current_min_fee_rate(time_t now) {
+  if (min_fee_rate <= 0.0) {
+    return 0.0;
+  }
+  double elapsed = now > min_fee_rate_time ? (double)(now - min_fee_rate_time) : 0.0;
+  double rate = min_fee_rate * pow(0.5, elapsed / MXD_MEMPOOL_MIN_FEE_HALF_LIFE);
+  return rate < MXD_MEMPOOL_FEE_RATE_STEP / 2 ? 0.0 : rate;
+}
+
+// After evicting for space, admission requires beating the best rate evicted
+static void raise_min_fee_rate(double evicted_rate) {
+  time_t now = time(NULL);
+  double rate = evicted_rate + MXD_MEMPOOL_FEE_RATE_STEP;
+  if (rate > current_min_fee_rate(now)) {
+    min_fee_rate = rate;
+    min_fee_rate_time = now;
+  }
+}
+
+// Evict the lowest fee-rate entries, with their descendants, until the pool
+// fits max_bytes
+static void trim_to_budget(size_t max_bytes) {
+  double evicted_rate = -1.0;
+  while (mempool_bytes > max_bytes && mempool_size > 0) {
+    uint32_t slot = evict_heap.order[0];
+    double rate = fee_rate(&mempool[slot]);
+    evicted_rate = rate > evicted_rate ? rate : evicted_rate;
+
+    size_t count = 0;
+    evict_set_begin();
+    collect_with_descendants(slot, &count, MXD_MAX_MEMPOOL_SIZE);
+    remove_slots(evict_set, count);
+  }
+  if (evicted_rate >= 0.0) {
+    raise_min_fee_rate(evicted_rate);
+  }
+}
+
+// Admit a prepared entry, taking ownership of its transaction on success.
+// Callers have already refused non-finite fees; the rate gate is written to
+// fail closed on NaN all the same.
+static int admit_entry_locked(mxd_mempool_entry_t *candidate) {
+  const mxd_transaction_t *tx = &candidate->tx;
+  if (!mempool || candidate->size > mempool_max_bytes ||
+      !(fee_rate(candidate) >= current_min_fee_rate(time(NULL)))) {
+    return -1;
+  }
+
+  // Check if transaction already exists
+  if (index_find(candidate->tx_hash) >= 0) {
+    return -1;
+  }
+
+  // Pooled transactions spending the same outpoints, with their
+  // descendants, are replaced only if the new tip beats all of theirs
+  size_t evict_count = 0;
+  evict_set_begin();
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    long bucket = spent_find(tx->inputs[i].prev_tx_hash, tx->inputs[i].output_index);
+    if (bucket >= 0 &&
+        collect_with_descendants(spent_index[bucket].slot - 1, &evict_count,
+                                 MXD_MEMPOOL_MAX_REPLACED) != 0) {
+      return -1;
+    }
+  }
+  size_t replaced_count = evict_count;
+  double replaced_fee = 0.0;
+  size_t freed_bytes = 0;
+  for (size_t i = 0; i < replaced_count; i++) {
+    replaced_fee += mempool[evict_set[i]].fee;
+    freed_bytes += mempool[evict_set[i]].size;
+  }
+  if (replaced_count > 0 && candidate->fee <= replaced_fee) {
+    return -1;
+  }
+
+  // When full, make room from the lowest fee rates up, evicting only
+  // entries paying a lower rate than the candidate. The set is planned on
+  // the unmodified pool so a failed admission leaves it untouched.
+  double evicted_rate = -1.0;
+  if (mempool_bytes - freed_bytes + candidate->size > mempool_max_bytes ||
+      mempool_size - evict_count >= MXD_MAX_MEMPOOL_SIZE) {
+    mxd_mempool_walk_t walk;
+    walk_begin(&walk, &evict_heap, evict_frontier);
+    int result = 0;
+    while (mempool_bytes - freed_bytes + candidate->size > mempool_max_bytes ||
+           mempool_size - evict_count >= MXD_MAX_MEMPOOL_SIZE) {
+      long slot = walk_next(&walk);
+      if (slot < 0) {
+        result = -1;
+        break;
+      }
+      if (in_evict_set((uint32_t)slot)) {
+        continue; // Already going as a replaced entry or descendant
+      }
+      if (compare_fee_rates(&mempool[slot], candidate) >= 0) {
+        result = -1;
+        break;
+      }
+      size_t before = evict_count;
+      collect_with_descendants((uint32_t)slot, &evict_count, MXD_MAX_MEMPOOL_SIZE);
+      for (size_t i = before; i < evict_count; i++) {
+        freed_bytes += mempool[evict_set[i]].size;
+      }
+      if (fee_rate(&mempool[slot]) > evicted_rate) {
+        evicted_rate = fee_rate(&mempool[slot]);
+      }
+    }
+    if (result != 0) {
+      return -1;
+    }
+  }
+
+  // The candidate cannot spend outputs of anything it displaces
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    long bucket = index_find(tx->inputs[i].prev_tx_hash);
+    if (bucket >= 0 && in_evict_set(index_table[bucket] - 1)) {
+      return -1;
+    }
+  }
 
-  // Sort mempool by priority and fee
-  qsort(mempool, mempool_size, sizeof(mxd_mempool_entry_t), compare_tx_entries);
+  if (spent_reserve(tx->input_count) != 0) {
+    return -1;
+  }
+  remove_slots(evict_set, evict_count);
+  if (evicted_rate >= 0.0) {
+    raise_min_fee_rate(evicted_rate);
+  }
+
+  uint32_t slot = (uint32_t)mempool_size;
+  mempool[slot] = *candidate;
+  mempool_size++;
+  mempool_bytes += candidate->size;
+  index_insert(candidate->tx_hash, slot);
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    mxd_mempool_spent_ref_t ref = {slot + 1, i};
+    spent_place(ref);
+    spent_count++;
+  }
+  heap_push(&evict_heap, slot);
+  mark_changed();
 
   return 0;
 }
 
+// Add transaction to mempool
+int mxd_add_to_mempool(const mxd_transaction_t *tx,
+                       mxd_tx_priority_t priority) {
+  if (!tx || priority < MXD_PRIORITY_LOW || priority > MXD_PRIORITY_HIGH) {
+    return -1;
+  }
+
+  // The tip is the fee: a NaN or infinite one would get past the fee rate,
+  // replacement and eviction comparisons, so it is refused before any of them
+  double fee = mxd_get_voluntary_tip(tx);
+  if (!isfinite(fee) || fee < 0.0) {
+    return -1;
+  }
+
+  // A transaction spending the same outpoint twice can never confirm
+  for (uint32_t i = 1; i < tx->input_count; i++) {
+    for (uint32_t j = 0; j < i; j++) {
+      if (tx->inputs[i].output_index == tx->inputs[j].output_index &&
+          memcmp(tx->inputs[i].prev_tx_hash, tx->inputs[j].prev_tx_hash, 64) == 0) {
+        return -1;
+      }
+    }
+  }
+
+  // Hash and copy before taking the lock, so submitting threads only
+  // serialize on the index updates
+  mxd_mempool_entry_t entry;
+  memset(&entry, 0, sizeof(entry));
+  if (mxd_calculate_tx_hash(tx, entry.tx_hash) != 0 ||
+      share_transaction(&entry, tx) != 0) {
+    return -1;
+  }
+  entry.priority = priority;
+  entry.timestamp = time(NULL);
+  entry.fee = fee;
+  entry.size = sizeof(mxd_mempool_entry_t) + tx->input_count * sizeof(mxd_tx_input_t) +
+               tx->output_count * sizeof(mxd_tx_output_t);
+
+  pthread_rwlock_wrlock(&mempool_lock);
+  int result = admit_entry_locked(&entry);
+  pthread_rwlock_unlock(&mempool_lock);
+
+  if (result != 0) {
+    free_entry_tx(&entry);
+  }
+  return result;
+}
+
 // Remove transaction from mempool
 int mxd_remove_from_mempool(const uint8_t tx_hash[64]) {
-  if (!tx_hash || !mempool) {
+  if (!tx_hash) {
     return -1;
   }
 
-  for (size_t i = 0; i < mempool_size; i++) {
-    uint8_t current_hash[64];
-    if (mxd_calculate_tx_hash(&mempool[i].tx, current_hash) == 0 &&
-        memcmp(current_hash, tx_hash, 64) == 0) {
-      // Free transaction resources
-      free(mempool[i].tx.inputs);
-      free(mempool[i].tx.outputs);
-
-      // Remove by shifting remaining entries
-      if (i < mempool_size - 1) {
-        memmove(&mempool[i], &mempool[i + 1],
-                (mempool_size - i - 1) * sizeof(mxd_mempool_entry_t));
-      }
-      mempool_size--;
-      return 0;
+  pthread_rwlock_wrlock(&mempool_lock);
+  long bucket = mempool ? index_find(tx_hash) : -1;
+  if (bucket >= 0) {
+    remove_slot(index_table[bucket] - 1);
+  }
+  pthread_rwlock_unlock(&mempool_lock);
+
+  return bucket >= 0 ? 0 : -1;
+}
+
+// Remove transactions conflicting with a confirmed one
+int mxd_remove_mempool_conflicts(const mxd_transaction_t *tx) {
+  if (!tx) {
+    return -1;
+  }
+
+  uint8_t tx_hash[64];
+  if (mxd_calculate_tx_hash(tx, tx_hash) != 0) {
+    return -1;
+  }
+
+  pthread_rwlock_wrlock(&mempool_lock);
+  if (!mempool) {
+    pthread_rwlock_unlock(&mempool_lock);
+    return -1;
+  }
+
+  int removed = 0;
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    long bucket = spent_find(tx->inputs[i].prev_tx_hash, tx->inputs[i].output_index);
+    if (bucket < 0 || memcmp(mempool[spent_index[bucket].slot - 1].tx_hash, tx_hash, 64) == 0) {
+      continue;
     }
+
+    size_t conflict_count = 0;
+    evict_set_begin();
+    collect_with_descendants(spent_index[bucket].slot - 1, &conflict_count, MXD_MAX_MEMPOOL_SIZE);
+    remove_slots(evict_set, conflict_count);
+    removed += (int)conflict_count;
+  }
+
+  pthread_rwlock_unlock(&mempool_lock);
+
+  return removed;
+}
+
+// Find the pooled transaction spending an outpoint
+int mxd_get_mempool_spender(const uint8_t prev_tx_hash[64], uint32_t output_index,
+                            uint8_t spender_hash[64]) {
+  if (!prev_tx_hash || !spender_hash) {
+    return -1;
+  }
+
+  pthread_rwlock_rdlock(&mempool_lock);
+  long bucket = mempool ? spent_find(prev_tx_hash, output_index) : -1;
+  if (bucket >= 0) {
+    memcpy(spender_hash, mempool[spent_index[bucket].slot - 1].tx_hash, 64);
   }
+  pthread_rwlock_unlock(&mempool_lock);
 
-  return -1; // Transaction not found
+  return bucket >= 0 ? 0 : -1;
 }
 
 // Get transaction from mempool
 int mxd_get_from_mempool(const uint8_t tx_hash[64], mxd_transaction_t *tx) {
-  if (!tx_hash || !tx || !mempool) {
+  if (!tx_hash || !tx) {
     return -1;
   }
 
+  pthread_rwlock_rdlock(&mempool_lock);
+  int result = -1;
+  long bucket = mempool ? index_find(tx_hash) : -1;
+  if (bucket >= 0) {
+    result = copy_transaction(tx, &mempool[index_table[bucket] - 1].tx);
+  }
+  pthread_rwlock_unlock(&mempool_lock);
+
+  return result;
+}
+
+static void release_snapshot(mxd_mempool_snapshot_t *snap) {
+  if (!snap || __atomic_sub_fetch(&snap->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+    return;
+  }
+  for (size_t i = 0; i < snap->count; i++) {
+    release_body(snap->entries[i].body);
+  }
+  free(snap->entries);
+  free(snap);
+}
+
+static int compare_snapshot_entries(const void *a, const void *b) {
+  return compare_tx_entries((const mxd_mempool_entry_t *)b, (const mxd_mempool_entry_t *)a);
+}
+
+// Copy the entries under the read lock, sharing their bodies, and sort them
+// once the lock is released
+static mxd_mempool_snapshot_t *build_snapshot(void) {
+  mxd_mempool_snapshot_t *snap = calloc(1, sizeof(mxd_mempool_snapshot_t));
+  if (!snap) {
+    return NULL;
+  }
+  snap->refs = 1;
+
+  pthread_rwlock_rdlock(&mempool_lock);
+  if (mempool) {
+    snap->entries = malloc((mempool_size ? mempool_size : 1) * sizeof(mxd_mempool_entry_t));
+  }
+  if (!snap->entries) {
+    pthread_rwlock_unlock(&mempool_lock);
+    free(snap);
+    return NULL;
+  }
+  memcpy(snap->entries, mempool, mempool_size * sizeof(mxd_mempool_entry_t));
   for (size_t i = 0; i < mempool_size; i++) {
-    uint8_t current_hash[64];
-    if (mxd_calculate_tx_hash(&mempool[i].tx, current_hash) == 0 &&
-        memcmp(current_hash, tx_hash, 64) == 0) {
-      // Copy basic fields
-      memcpy(tx, &mempool[i].tx, sizeof(mxd_transaction_t));
-      tx->inputs = NULL;
-      tx->outputs = NULL;
-
-      // Copy inputs if present
-      if (mempool[i].tx.inputs && tx->input_count > 0) {
-        tx->inputs = malloc(tx->input_count * sizeof(mxd_tx_input_t));
-        if (!tx->inputs) {
-          return -1;
-        }
-        memcpy(tx->inputs, mempool[i].tx.inputs,
-               tx->input_count * sizeof(mxd_tx_input_t));
-      }
+    retain_body(snap->entries[i].body);
+  }
+  snap->count = mempool_size;
+  snap->version = __atomic_load_n(&mempool_version, __ATOMIC_ACQUIRE);
+  pthread_rwlock_unlock(&mempool_lock);
 
-      // Copy outputs if present
-      if (mempool[i].tx.outputs && tx->output_count > 0) {
-        tx->outputs = malloc(tx->output_count * sizeof(mxd_tx_output_t));
-        if (!tx->outputs) {
-          free(tx->inputs);
-          return -1;
-        }
-        memcpy(tx->outputs, mempool[i].tx.outputs,
-               tx->output_count * sizeof(mxd_tx_output_t));
-      }
+  qsort(snap->entries, snap->count, sizeof(mxd_mempool_entry_t), compare_snapshot_entries);
+  return snap;
+}
 
-      return 0;
+// Reference to a snapshot of the current pool, building one if the latest
+// is out of date
+static mxd_mempool_snapshot_t *take_snapshot(void) {
+  pthread_mutex_lock(&snapshot_mutex);
+  if (!snapshot || snapshot->version != __atomic_load_n(&mempool_version, __ATOMIC_ACQUIRE)) {
+    mxd_mempool_snapshot_t *fresh = build_snapshot();
+    if (!fresh) {
+      pthread_mutex_unlock(&snapshot_mutex);
+      return NULL;
     }
+    release_snapshot(snapshot);
+    snapshot = fresh;
   }
-
-  return -1; // Transaction not found
+  mxd_mempool_snapshot_t *snap = snapshot;
+  __atomic_add_fetch(&snap->refs, 1, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&snapshot_mutex);
+  return snap;
 }
 
 // Get highest priority transactions
 int mxd_get_priority_transactions(mxd_transaction_t *txs, size_t *tx_count,
                                   mxd_tx_priority_t min_priority) {
-  if (!txs || !tx_count || !mempool || *tx_count == 0 ||
+  if (!txs || !tx_count || *tx_count == 0 ||
       min_priority < MXD_PRIORITY_LOW || min_priority > MXD_PRIORITY_HIGH) {
     return -1;
   }
 
-  size_t count = 0;
-  for (size_t i = 0; i < mempool_size && count < *tx_count; i++) {
-    if (mempool[i].priority >= min_priority) {
-      // Copy basic fields
-      memcpy(&txs[count], &mempool[i].tx, sizeof(mxd_transaction_t));
-      txs[count].inputs = NULL;
-      txs[count].outputs = NULL;
-
-      // Copy inputs if present
-      if (mempool[i].tx.inputs && txs[count].input_count > 0) {
-        txs[count].inputs =
-            malloc(txs[count].input_count * sizeof(mxd_tx_input_t));
-        if (!txs[count].inputs) {
-          // Clean up previous transactions
-          for (size_t j = 0; j < count; j++) {
-            free(txs[j].inputs);
-            free(txs[j].outputs);
-          }
-          return -1;
-        }
-        memcpy(txs[count].inputs, mempool[i].tx.inputs,
-               txs[count].input_count * sizeof(mxd_tx_input_t));
-      }
+  mxd_mempool_snapshot_t *snap = take_snapshot();
+  if (!snap) {
+    return -1;
+  }
 
-      // Copy outputs if present
-      if (mempool[i].tx.outputs && txs[count].output_count > 0) {
-        txs[count].outputs =
-            malloc(txs[count].output_count * sizeof(mxd_tx_output_t));
-        if (!txs[count].outputs) {
-          free(txs[count].inputs);
-          // Clean up previous transactions
-          for (size_t j = 0; j < count; j++) {
-            free(txs[j].inputs);
-            free(txs[j].outputs);
-          }
-          return -1;
-        }
-        memcpy(txs[count].outputs, mempool[i].tx.outputs,
-               txs[count].output_count * sizeof(mxd_tx_output_t));
+  // Priority orders first, so selection stops at the first entry below
+  // min_priority
+  size_t count = 0;
+  while (count < *tx_count && count < snap->count &&
+         snap->entries[count].priority >= min_priority) {
+    if (copy_transaction(&txs[count], &snap->entries[count].tx) != 0) {
+      // Clean up previous transactions
+      for (size_t j = 0; j < count; j++) {
+        free(txs[j].inputs);
+        free(txs[j].outputs);
       }
-
-      count++;
+      release_snapshot(snap);
+      return -1;
     }
+    count++;
   }
 
+  release_snapshot(snap);
   *tx_count = count;
   return 0;
 }
 
 // Clean expired transactions
 int mxd_clean_mempool(uint64_t max_age) {
+  uint64_t current_time = time(NULL);
+
+  pthread_rwlock_wrlock(&mempool_lock);
   if (!mempool) {
+    pthread_rwlock_unlock(&mempool_lock);
     return -1;
   }
 
-  uint64_t current_time = time(NULL);
-  size_t write_index = 0;
-
-  for (size_t i = 0; i < mempool_size; i++) {
-    if (current_time - mempool[i].timestamp <= max_age) {
-      if (i != write_index) {
-        // Free destination transaction resources
-        free(mempool[write_index].tx.inputs);
-        free(mempool[write_index].tx.outputs);
-
-        // Copy entry
-        memcpy(&mempool[write_index], &mempool[i], sizeof(mxd_mempool_entry_t));
-
-        // Clear source pointers to prevent double free
-        mempool[i].tx.inputs = NULL;
-        mempool[i].tx.outputs = NULL;
-      }
-      write_index++;
-    } else {
-      // Free expired transaction resources
-      free(mempool[i].tx.inputs);
-      free(mempool[i].tx.outputs);
-      mempool[i].tx.inputs = NULL;
-      mempool[i].tx.outputs = NULL;
+  // Removal moves the last entry into the freed slot, so walk backwards
+  for (size_t i = mempool_size; i-- > 0;) {
+    if (current_time - mempool[i].timestamp > max_age) {
+      remove_slot((uint32_t)i);
     }
   }
+  pthread_rwlock_unlock(&mempool_lock);
 
-  mempool_size = write_index;
   return 0;
 }
 
 // Get current mempool size
-size_t mxd_get_mempool_size(void) { return mempool_size; }
+size_t mxd_get_mempool_size(void) {
+  pthread_rwlock_rdlock(&mempool_lock);
+  size_t size = mempool_size;
+  pthread_rwlock_unlock(&mempool_lock);
+  return size;
+}
+
+// Set the memory budget in bytes
+int mxd_set_mempool_max_bytes(size_t max_bytes) {
+  pthread_rwlock_wrlock(&mempool_lock);
+  mempool_max_bytes = max_bytes ? max_bytes : MXD_MEMPOOL_DEFAULT_MAX_BYTES;
+  if (mempool) {
+    trim_to_budget(mempool_max_bytes);
+  }
+  pthread_rwlock_unlock(&mempool_lock);
+  return 0;
+}
+
+// Get bytes held by pooled transactions
+size_t mxd_get_mempool_bytes(void) {
+  pthread_rwlock_rdlock(&mempool_lock);
+  size_t bytes = mempool_bytes;
+  pthread_rwlock_unlock(&mempool_lock);
+  return bytes;
+}
+
+// Get the minimum fee rate for admission
+double mxd_get_mempool_min_fee_rate(void) {
+  pthread_rwlock_rdlock(&mempool_lock);
+  double rate = current_min_fee_rate(time(NULL));
+  pthread_rwlock_unlock(&mempool_lock);
+  return rate;
+}
@@ -3,6 +3,8 @@
 #include "../include/mxd_address.h"
 #include "../include/mxd_transaction.h"
 #include "../include/mxd_utxo.h"
+#include "../include/mxd_utxo_cache.h"
+#include "../include/mxd_crypto.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,7 +21,7 @@ static mxd_system_metrics_t current_metrics = {0};
 static mxd_health_status_t current_health = {0};
 static int monitoring_initialized = 0;
 static uint16_t metrics_port = 0;
-static char prometheus_buffer[4096];
+static char prometheus_buffer[8192];
 static char health_buffer[1024];
 static int server_socket = -1;
 static pthread_t server_thread;
@@ -95,7 +97,7 @@ const char* mxd_get_prometheus_metrics(void) {
         return NULL;
     }
     
-    snprintf(prometheus_buffer, sizeof(prometheus_buffer),
+    int offset = snprintf(prometheus_buffer, sizeof(prometheus_buffer),
         "# HELP mxd_transactions_total Total number of transactions processed\n"
         "# TYPE mxd_transactions_total counter\n"
         "mxd_transactions_total %lu\n"
@@ -147,6 +149,96 @@ const char* mxd_get_prometheus_metrics(void) {
         current_metrics.cpu_usage_percent
     );
     
+    mxd_crypto_backend_info_t crypto_info;
+    mxd_crypto_get_backend_info(&crypto_info);
+    if (offset > 0 && (size_t)offset < sizeof(prometheus_buffer)) {
+        offset += snprintf(prometheus_buffer + offset, sizeof(prometheus_buffer) - offset,
+            "\n"
+            "# HELP mxd_crypto_backend_info Hashing backends selected at startup\n"
+            "# TYPE mxd_crypto_backend_info gauge\n"
+            "mxd_crypto_backend_info{sha256=\"%s\",sha512=\"%s\",sha512_batch=\"%s\"} 1\n"
+            "\n"
+            "# HELP mxd_crypto_self_test_passed Whether the hashing known-answer self-tests passed\n"
+            "# TYPE mxd_crypto_self_test_passed gauge\n"
+            "mxd_crypto_self_test_passed %d\n"
+            "\n"
+            "# HELP mxd_crypto_cpu_feature CPU features available for hashing\n"
+            "# TYPE mxd_crypto_cpu_feature gauge\n"
+            "mxd_crypto_cpu_feature{feature=\"sha_ni\"} %d\n"
+            "mxd_crypto_cpu_feature{feature=\"avx2\"} %d\n"
+            "mxd_crypto_cpu_feature{feature=\"avx512f\"} %d\n",
+            crypto_info.sha256_backend,
+            crypto_info.sha512_backend,
+            crypto_info.sha512_batch_backend,
+            crypto_info.self_test_passed,
+            (crypto_info.cpu_features & MXD_CPU_FEATURE_SHA_NI) != 0,
+            (crypto_info.cpu_features & MXD_CPU_FEATURE_AVX2) != 0,
+            (crypto_info.cpu_features & MXD_CPU_FEATURE_AVX512F) != 0
+        );
+    }
+    
+    mxd_utxo_cache_stats_t cache_stats;
+    mxd_utxo_cache_get_stats(&cache_stats);
+    if (offset > 0 && (size_t)offset < sizeof(prometheus_buffer)) {
+        offset += snprintf(prometheus_buffer + offset, sizeof(prometheus_buffer) - offset,
+            "\n"
+            "# HELP mxd_utxo_cache_hits_total UTXO lookups served from the cache\n"
+            "# TYPE mxd_utxo_cache_hits_total counter\n"
+            "mxd_utxo_cache_hits_total %lu\n"
+            "\n"
+            "# HELP mxd_utxo_cache_misses_total UTXO lookups that went to the database\n"
+            "# TYPE mxd_utxo_cache_misses_total counter\n"
+            "mxd_utxo_cache_misses_total %lu\n"
+            "\n"
+            "# HELP mxd_utxo_cache_evictions_total UTXOs evicted from the cache\n"
+            "# TYPE mxd_utxo_cache_evictions_total counter\n"
+            "mxd_utxo_cache_evictions_total %lu\n"
+            "\n"
+            "# HELP mxd_utxo_cache_entries UTXOs currently cached\n"
+            "# TYPE mxd_utxo_cache_entries gauge\n"
+            "mxd_utxo_cache_entries %zu\n"
+            "\n"
+            "# HELP mxd_utxo_cache_bytes Memory used by the UTXO cache\n"
+            "# TYPE mxd_utxo_cache_bytes gauge\n"
+            "mxd_utxo_cache_bytes %zu\n"
+            "\n"
+            "# HELP mxd_utxo_cache_budget_bytes Memory budget of the UTXO cache\n"
+            "# TYPE mxd_utxo_cache_budget_bytes gauge\n"
+            "mxd_utxo_cache_budget_bytes %zu\n",
+            cache_stats.hits,
+            cache_stats.misses,
+            cache_stats.evictions,
+            cache_stats.entries,
+            cache_stats.bytes,
+            cache_stats.byte_budget
+        );
+    }
+    
+    // Running totals maintained by the UTXO set; no database scan
+    size_t utxo_entries = 0;
+    size_t utxo_spent = 0;
+    double utxo_value = 0.0;
+    if (offset > 0 && (size_t)offset < sizeof(prometheus_buffer) &&
+        mxd_get_utxo_stats(&utxo_entries, &utxo_spent, &utxo_value) == 0) {
+        offset += snprintf(prometheus_buffer + offset, sizeof(prometheus_buffer) - offset,
+            "\n"
+            "# HELP mxd_utxo_entries UTXO records stored, spent or not\n"
+            "# TYPE mxd_utxo_entries gauge\n"
+            "mxd_utxo_entries %zu\n"
+            "\n"
+            "# HELP mxd_utxo_spent_entries Spent UTXO records awaiting pruning\n"
+            "# TYPE mxd_utxo_spent_entries gauge\n"
+            "mxd_utxo_spent_entries %zu\n"
+            "\n"
+            "# HELP mxd_utxo_unspent_value Total value of unspent outputs\n"
+            "# TYPE mxd_utxo_unspent_value gauge\n"
+            "mxd_utxo_unspent_value %.8f\n",
+            utxo_entries,
+            utxo_spent,
+            utxo_value
+        );
+    }
+    
     return prometheus_buffer;
 }
 
@@ -544,14 +636,20 @@ const char* mxd_handle_wallet_send(const char* recipient, const char* amount) {
         return wallet_response_buffer;
     }
     
+    // The transaction only lives for this request, so build it on the stack
+    uint8_t arena_buffer[sizeof(mxd_tx_output_t) + 64];
+    mxd_arena_t arena;
+    mxd_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+    
     mxd_transaction_t tx;
-    if (mxd_create_transaction(&tx) != 0) {
+    mxd_tx_builder_t builder;
+    if (mxd_tx_builder_begin(&builder, &arena, &tx, 0, 1) != 0) {
         snprintf(wallet_response_buffer, sizeof(wallet_response_buffer),
             "{\"success\":false,\"error\":\"Failed to create transaction\"}");
         return wallet_response_buffer;
     }
     
-    if (mxd_add_tx_output(&tx, recipient_pubkey, amount_value) != 0) {
+    if (mxd_tx_builder_add_output(&builder, recipient_pubkey, amount_value) != 0) {
         mxd_free_transaction(&tx);
         snprintf(wallet_response_buffer, sizeof(wallet_response_buffer),
             "{\"success\":false,\"error\":\"Failed to add transaction output\"}");
@@ -20,6 +20,7 @@
 #include "mxd_logging.h"
 #include "mxd_secrets.h"
 #include "mxd_address.h"
+#include "mxd_tx_wire.h"
 
 static struct {
     char address[256];
@@ -827,6 +828,21 @@ static int handle_incoming_message(const char *address, uint16_t port,
         case MXD_MSG_PEERS:
             handle_peers_message(address, port, payload, header->length);
             break;
+        case MXD_MSG_TRANSACTIONS: {
+            // Reject malformed transaction lists before anyone decodes them
+            uint32_t tx_count = 0;
+            if (mxd_tx_list_validate(payload, header->length, &tx_count) != 0) {
+                MXD_LOG_WARN("p2p", "Malformed TRANSACTIONS payload from %s:%d (%u bytes)",
+                           address, port, header->length);
+                break;
+            }
+            MXD_LOG_DEBUG("p2p", "TRANSACTIONS from %s:%d carries %u transactions",
+                        address, port, tx_count);
+            if (message_handler) {
+                message_handler(address, port, header->type, payload, header->length);
+            }
+            break;
+        }
         default:
             if (message_handler) {
                 message_handler(address, port, header->type, payload, header->length);
@@ -1856,6 +1872,14 @@ int mxd_broadcast_message(mxd_message_type_t type, const void* payload, size_t p
         return -1;
     }
 
+    // Receivers drop transaction lists that are not canonically encoded
+    uint32_t tx_count;
+    if (type == MXD_MSG_TRANSACTIONS &&
+        mxd_tx_list_validate(payload, payload_length, &tx_count) != 0) {
+        MXD_LOG_WARN("p2p", "Refusing to broadcast malformed TRANSACTIONS payload");
+        return -1;
+    }
+
     consecutive_errors = 0;
 
     const mxd_secrets_t *secrets = mxd_get_secrets();
@@ -1908,6 +1932,23 @@ int mxd_broadcast_message(mxd_message_type_t type, const void* payload, size_t p
     return success_count > 0 ? 0 : -1;
 }
 
+int mxd_broadcast_transactions(const mxd_transaction_t *txs, size_t count) {
+    if (!txs || count == 0) {
+        return -1;
+    }
+    
+    uint8_t *payload = NULL;
+    size_t payload_length = 0;
+    if (mxd_tx_list_encode(txs, count, &payload, &payload_length) != 0) {
+        MXD_LOG_ERROR("p2p", "Failed to encode %zu transactions for broadcast", count);
+        return -1;
+    }
+    
+    int result = mxd_broadcast_message(MXD_MSG_TRANSACTIONS, payload, payload_length);
+    free(payload);
+    return result;
+}
+
 int mxd_start_peer_discovery(void) {
     if (!p2p_initialized) {
         MXD_LOG_ERROR("p2p", "P2P not initialized");
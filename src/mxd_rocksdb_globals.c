@@ -1,9 +1,25 @@
-#include <rocksdb/c.h>
+#include "mxd_logging.h"
+
+#include "../include/mxd_rocksdb_globals.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 rocksdb_t *g_rocksdb_db = NULL;
 rocksdb_readoptions_t *g_rocksdb_readoptions = NULL;
 rocksdb_writeoptions_t *g_rocksdb_writeoptions = NULL;
 
+// Length of "pubkey:" + pubkey hash, the unit of address index scans
+#define MXD_PUBKEY_INDEX_PREFIX_LEN (7 + 20)
+
+static const char *cf_names[MXD_CF_COUNT] = {
+    "default", "utxo", "utxo_pubkey", "utxo_balance", "blocks", "signatures", "blacklist"
+};
+
+static rocksdb_column_family_handle_t *cf_handles[MXD_CF_COUNT];
+static rocksdb_options_t *cf_options[MXD_CF_COUNT];
+static rocksdb_cache_t *shared_block_cache = NULL;
+
 rocksdb_t *mxd_get_rocksdb_db(void) {
     return g_rocksdb_db;
 }
@@ -27,3 +43,241 @@ void mxd_set_rocksdb_readoptions(rocksdb_readoptions_t *options) {
 void mxd_set_rocksdb_writeoptions(rocksdb_writeoptions_t *options) {
     g_rocksdb_writeoptions = options;
 }
+
+// Element-wise sum of int64 counter arrays; operands of a different
+// length than the first value are ignored
+static char *counter_merge(const char *existing, size_t existing_len, const char *const *operands,
+                           const size_t *operand_lens, int num_operands, unsigned char *success,
+                           size_t *new_len) {
+    int64_t sum[MXD_COUNTER_MERGE_MAX] = {0};
+    size_t len = existing ? existing_len : (num_operands > 0 ? operand_lens[0] : 0);
+    
+    *success = 0;
+    if (len == 0 || len % sizeof(int64_t) != 0 || len > sizeof(sum)) {
+        return NULL;
+    }
+    if (existing) {
+        memcpy(sum, existing, len);
+    }
+    for (int i = 0; i < num_operands; i++) {
+        if (operand_lens[i] != len) {
+            continue;
+        }
+        int64_t delta[MXD_COUNTER_MERGE_MAX];
+        memcpy(delta, operands[i], len);
+        for (size_t j = 0; j < len / sizeof(int64_t); j++) {
+            sum[j] += delta[j];
+        }
+    }
+    
+    char *result = malloc(len);
+    if (!result) {
+        return NULL;
+    }
+    memcpy(result, sum, len);
+    *new_len = len;
+    *success = 1;
+    return result;
+}
+
+static char *counter_full_merge(void *state, const char *key, size_t key_len, const char *existing,
+                                size_t existing_len, const char *const *operands,
+                                const size_t *operand_lens, int num_operands, unsigned char *success,
+                                size_t *new_len) {
+    (void)state;
+    (void)key;
+    (void)key_len;
+    return counter_merge(existing, existing_len, operands, operand_lens, num_operands, success, new_len);
+}
+
+static char *counter_partial_merge(void *state, const char *key, size_t key_len,
+                                   const char *const *operands, const size_t *operand_lens,
+                                   int num_operands, unsigned char *success, size_t *new_len) {
+    (void)state;
+    (void)key;
+    (void)key_len;
+    return counter_merge(NULL, 0, operands, operand_lens, num_operands, success, new_len);
+}
+
+static void counter_delete_value(void *state, const char *value, size_t value_len) {
+    (void)state;
+    (void)value_len;
+    free((char *)value);
+}
+
+static const char *counter_merge_name(void *state) {
+    (void)state;
+    return "mxd.counter_add";
+}
+
+static void free_cf_options(void) {
+    for (int i = 0; i < MXD_CF_COUNT; i++) {
+        if (cf_options[i]) {
+            rocksdb_options_destroy(cf_options[i]);
+            cf_options[i] = NULL;
+        }
+    }
+    if (shared_block_cache) {
+        rocksdb_cache_destroy(shared_block_cache);
+        shared_block_cache = NULL;
+    }
+}
+
+// Per-family tuning on top of the database-wide options
+static rocksdb_options_t *create_cf_options(const rocksdb_options_t *db_options, mxd_rocksdb_cf_t cf) {
+    rocksdb_options_t *options = rocksdb_options_create_copy((rocksdb_options_t *)db_options);
+    rocksdb_block_based_table_options_t *table_options = rocksdb_block_based_options_create();
+    rocksdb_block_based_options_set_block_cache(table_options, shared_block_cache);
+    rocksdb_block_based_options_set_cache_index_and_filter_blocks(table_options, 1);
+    
+    switch (cf) {
+    case MXD_CF_UTXO:
+        // Point lookups by outpoint: small blocks and a whole-key bloom
+        // filter so misses rarely touch disk
+        rocksdb_block_based_options_set_block_size(table_options, 4 * 1024);
+        rocksdb_block_based_options_set_filter_policy(table_options, rocksdb_filterpolicy_create_bloom_full(10));
+        rocksdb_block_based_options_set_whole_key_filtering(table_options, 1);
+        rocksdb_options_set_compression(options, rocksdb_lz4_compression);
+        break;
+    case MXD_CF_PUBKEY_INDEX:
+        // Scanned per address: bloom on the "pubkey:" + hash prefix
+        rocksdb_options_set_prefix_extractor(options,
+            rocksdb_slicetransform_create_fixed_prefix(MXD_PUBKEY_INDEX_PREFIX_LEN));
+        rocksdb_options_set_memtable_prefix_bloom_size_ratio(options, 0.1);
+        rocksdb_block_based_options_set_block_size(table_options, 4 * 1024);
+        rocksdb_block_based_options_set_filter_policy(table_options, rocksdb_filterpolicy_create_bloom_full(10));
+        rocksdb_block_based_options_set_whole_key_filtering(table_options, 0);
+        rocksdb_options_set_compression(options, rocksdb_lz4_compression);
+        break;
+    case MXD_CF_BALANCE:
+        // One small record per address, updated by merge
+        rocksdb_options_set_merge_operator(options,
+            rocksdb_mergeoperator_create(NULL, NULL, counter_full_merge, counter_partial_merge,
+                                         counter_delete_value, counter_merge_name));
+        rocksdb_block_based_options_set_block_size(table_options, 4 * 1024);
+        rocksdb_block_based_options_set_filter_policy(table_options, rocksdb_filterpolicy_create_bloom_full(10));
+        rocksdb_options_set_compression(options, rocksdb_lz4_compression);
+        break;
+    case MXD_CF_BLOCKS:
+        // Large, rarely read values: bigger blocks and stronger compression
+        rocksdb_block_based_options_set_block_size(table_options, 32 * 1024);
+        rocksdb_block_based_options_set_filter_policy(table_options, rocksdb_filterpolicy_create_bloom_full(10));
+        rocksdb_options_set_compression(options, rocksdb_zstd_compression);
+        break;
+    case MXD_CF_SIGNATURES:
+        rocksdb_block_based_options_set_block_size(table_options, 16 * 1024);
+        rocksdb_block_based_options_set_filter_policy(table_options, rocksdb_filterpolicy_create_bloom_full(10));
+        rocksdb_options_set_compression(options, rocksdb_lz4_compression);
+        break;
+    default:
+        rocksdb_block_based_options_set_block_size(table_options, 4 * 1024);
+        break;
+    }
+    
+    rocksdb_options_set_block_based_table_factory(options, table_options);
+    rocksdb_block_based_options_destroy(table_options);
+    return options;
+}
+
+rocksdb_t *mxd_rocksdb_open(const rocksdb_options_t *db_options, const char *db_path,
+                            size_t block_cache_size, char **err) {
+    if (!db_options || !db_path || !err) {
+        return NULL;
+    }
+    
+    free_cf_options();
+    shared_block_cache = rocksdb_cache_create_lru(block_cache_size);
+    for (int i = 0; i < MXD_CF_COUNT; i++) {
+        cf_options[i] = create_cf_options(db_options, (mxd_rocksdb_cf_t)i);
+    }
+    
+    rocksdb_options_t *open_options = rocksdb_options_create_copy((rocksdb_options_t *)db_options);
+    rocksdb_options_set_create_missing_column_families(open_options, 1);
+    
+    rocksdb_t *db = rocksdb_open_column_families(open_options, db_path, MXD_CF_COUNT, cf_names,
+                                                 (const rocksdb_options_t *const *)cf_options,
+                                                 cf_handles, err);
+    rocksdb_options_destroy(open_options);
+    
+    if (*err || !db) {
+        memset(cf_handles, 0, sizeof(cf_handles));
+        free_cf_options();
+        return NULL;
+    }
+    
+    return db;
+}
+
+void mxd_rocksdb_close(rocksdb_t *db) {
+    for (int i = 0; i < MXD_CF_COUNT; i++) {
+        if (cf_handles[i]) {
+            rocksdb_column_family_handle_destroy(cf_handles[i]);
+            cf_handles[i] = NULL;
+        }
+    }
+    if (db) {
+        rocksdb_close(db);
+    }
+    free_cf_options();
+}
+
+rocksdb_column_family_handle_t *mxd_get_rocksdb_cf(mxd_rocksdb_cf_t cf) {
+    if (cf < 0 || cf >= MXD_CF_COUNT) {
+        return NULL;
+    }
+    return cf_handles[cf];
+}
+
+int mxd_rocksdb_migrate_prefix(const char *prefix, mxd_rocksdb_cf_t cf) {
+    rocksdb_column_family_handle_t *target = mxd_get_rocksdb_cf(cf);
+    if (!prefix || !g_rocksdb_db || !target || cf == MXD_CF_DEFAULT) {
+        return -1;
+    }
+    
+    size_t prefix_len = strlen(prefix);
+    rocksdb_writebatch_t *batch = rocksdb_writebatch_create();
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(g_rocksdb_db, g_rocksdb_readoptions,
+                                                          cf_handles[MXD_CF_DEFAULT]);
+    size_t moved = 0;
+    char *err = NULL;
+    
+    rocksdb_iter_seek(iter, prefix, prefix_len);
+    while (rocksdb_iter_valid(iter)) {
+        size_t key_len, value_len;
+        const char *key = rocksdb_iter_key(iter, &key_len);
+        if (key_len < prefix_len || memcmp(key, prefix, prefix_len) != 0) {
+            break;
+        }
+        const char *value = rocksdb_iter_value(iter, &value_len);
+        rocksdb_writebatch_put_cf(batch, target, key, key_len, value, value_len);
+        rocksdb_writebatch_delete_cf(batch, cf_handles[MXD_CF_DEFAULT], key, key_len);
+        moved++;
+        
+        // Keep batches bounded on large databases
+        if (rocksdb_writebatch_count(batch) >= 8192) {
+            rocksdb_write(g_rocksdb_db, g_rocksdb_writeoptions, batch, &err);
+            rocksdb_writebatch_clear(batch);
+            if (err) {
+                break;
+            }
+        }
+        rocksdb_iter_next(iter);
+    }
+    rocksdb_iter_destroy(iter);
+    
+    if (!err && rocksdb_writebatch_count(batch) > 0) {
+        rocksdb_write(g_rocksdb_db, g_rocksdb_writeoptions, batch, &err);
+    }
+    rocksdb_writebatch_destroy(batch);
+    
+    if (err) {
+        MXD_LOG_ERROR("db", "Failed to move \"%s\" keys to column family %s: %s", prefix, cf_names[cf], err);
+        free(err);
+        return -1;
+    }
+    
+    if (moved > 0) {
+        MXD_LOG_INFO("db", "Moved %zu \"%s\" keys to column family %s", moved, prefix, cf_names[cf]);
+    }
+    return 0;
+}
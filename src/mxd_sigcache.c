@@ -0,0 +1,274 @@
+#include "../include/mxd_sigcache.h"
+#include "../include/mxd_crypto.h"
+#include "../include/mxd_logging.h"
+#include <openssl/rand.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Verified signatures are remembered in a sharded, 4-way set-associative
+// table. Only successful verifications are stored, so a hit can never turn an
+// invalid signature into a valid one; a lost entry just costs a re-verify.
+#define MXD_SIGCACHE_SHARDS 16
+#define MXD_SIGCACHE_WAYS 4
+
+typedef struct {
+  uint8_t key[MXD_SIGCACHE_KEY_SIZE];
+  uint8_t used;
+} mxd_sigcache_slot_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  mxd_sigcache_slot_t *slots;
+  size_t set_count;
+  size_t entries;
+  uint32_t evict_cursor;
+} mxd_sigcache_shard_t;
+
+static pthread_rwlock_t sigcache_lock = PTHREAD_RWLOCK_INITIALIZER;
+static mxd_sigcache_shard_t sigcache_shards[MXD_SIGCACHE_SHARDS];
+static uint8_t sigcache_salt[32];
+static size_t sigcache_capacity = 0;
+static int sigcache_initialized = 0;
+
+static uint64_t sigcache_hits = 0;
+static uint64_t sigcache_misses = 0;
+static uint64_t sigcache_insertions = 0;
+static uint64_t sigcache_evictions = 0;
+
+static void sigcache_free_locked(void) {
+  for (int i = 0; i < MXD_SIGCACHE_SHARDS; i++) {
+    free(sigcache_shards[i].slots);
+    sigcache_shards[i].slots = NULL;
+    sigcache_shards[i].set_count = 0;
+    sigcache_shards[i].entries = 0;
+    sigcache_shards[i].evict_cursor = 0;
+  }
+  sigcache_capacity = 0;
+  sigcache_initialized = 0;
+}
+
+static int sigcache_init_locked(size_t max_entries) {
+  sigcache_free_locked();
+
+  // Round each shard up to a power-of-two number of sets
+  size_t per_shard = (max_entries + MXD_SIGCACHE_SHARDS - 1) / MXD_SIGCACHE_SHARDS;
+  size_t sets = 1;
+  while (sets * MXD_SIGCACHE_WAYS < per_shard) {
+    sets <<= 1;
+  }
+
+  for (int i = 0; i < MXD_SIGCACHE_SHARDS; i++) {
+    mxd_sigcache_shard_t *shard = &sigcache_shards[i];
+    shard->slots = calloc(sets * MXD_SIGCACHE_WAYS, sizeof(mxd_sigcache_slot_t));
+    if (!shard->slots) {
+      MXD_LOG_ERROR("sigcache", "Failed to allocate signature cache shard");
+      sigcache_free_locked();
+      return -1;
+    }
+    shard->set_count = sets;
+  }
+
+  // Salt the keys so peers cannot aim entries at a single set
+  if (RAND_bytes(sigcache_salt, sizeof(sigcache_salt)) != 1) {
+    MXD_LOG_ERROR("sigcache", "Failed to generate signature cache salt");
+    sigcache_free_locked();
+    return -1;
+  }
+
+  __atomic_store_n(&sigcache_hits, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&sigcache_misses, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&sigcache_insertions, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&sigcache_evictions, 0, __ATOMIC_RELAXED);
+
+  sigcache_capacity = sets * MXD_SIGCACHE_WAYS * MXD_SIGCACHE_SHARDS;
+  sigcache_initialized = 1;
+  return 0;
+}
+
+static pthread_once_t sigcache_mutex_once = PTHREAD_ONCE_INIT;
+
+static void sigcache_init_mutexes(void) {
+  for (int i = 0; i < MXD_SIGCACHE_SHARDS; i++) {
+    pthread_mutex_init(&sigcache_shards[i].lock, NULL);
+  }
+}
+
+int mxd_sigcache_init(size_t max_entries) {
+  if (max_entries == 0) {
+    return -1;
+  }
+  pthread_once(&sigcache_mutex_once, sigcache_init_mutexes);
+  pthread_rwlock_wrlock(&sigcache_lock);
+  int rc = sigcache_init_locked(max_entries);
+  pthread_rwlock_unlock(&sigcache_lock);
+  if (rc == 0) {
+    MXD_LOG_INFO("sigcache", "Signature cache initialized with %zu entries", sigcache_capacity);
+  }
+  return rc;
+}
+
+void mxd_sigcache_cleanup(void) {
+  pthread_rwlock_wrlock(&sigcache_lock);
+  sigcache_free_locked();
+  pthread_rwlock_unlock(&sigcache_lock);
+}
+
+void mxd_sigcache_clear(void) {
+  pthread_rwlock_rdlock(&sigcache_lock);
+  for (int i = 0; sigcache_initialized && i < MXD_SIGCACHE_SHARDS; i++) {
+    mxd_sigcache_shard_t *shard = &sigcache_shards[i];
+    pthread_mutex_lock(&shard->lock);
+    memset(shard->slots, 0, shard->set_count * MXD_SIGCACHE_WAYS * sizeof(mxd_sigcache_slot_t));
+    shard->entries = 0;
+    pthread_mutex_unlock(&shard->lock);
+  }
+  pthread_rwlock_unlock(&sigcache_lock);
+}
+
+// Take the shared lock, initializing the cache with the default size if no
+// one has done so yet. Returns 0 with the read lock held.
+static int sigcache_acquire(void) {
+  pthread_rwlock_rdlock(&sigcache_lock);
+  if (sigcache_initialized) {
+    return 0;
+  }
+  pthread_rwlock_unlock(&sigcache_lock);
+
+  pthread_once(&sigcache_mutex_once, sigcache_init_mutexes);
+  pthread_rwlock_wrlock(&sigcache_lock);
+  if (!sigcache_initialized) {
+    sigcache_init_locked(MXD_SIGCACHE_DEFAULT_ENTRIES);
+  }
+  pthread_rwlock_unlock(&sigcache_lock);
+
+  pthread_rwlock_rdlock(&sigcache_lock);
+  if (!sigcache_initialized) {
+    pthread_rwlock_unlock(&sigcache_lock);
+    return -1;
+  }
+  return 0;
+}
+
+int mxd_sigcache_compute_key(const uint8_t *public_key, size_t public_key_length,
+                             const uint8_t *message, size_t message_length,
+                             const uint8_t *signature, size_t signature_length,
+                             uint8_t key[MXD_SIGCACHE_KEY_SIZE]) {
+  if (!public_key || !message || !signature || !key) {
+    return -1;
+  }
+
+  // Make sure the salt exists before it is hashed into a key
+  if (sigcache_acquire() != 0) {
+    return -1;
+  }
+
+  uint64_t lengths[3] = {public_key_length, message_length, signature_length};
+  mxd_hash_ctx_t ctx;
+  int rc = -1;
+  if (mxd_hash_init(&ctx, MXD_HASH_SHA256) == 0) {
+    if (mxd_hash_update(&ctx, sigcache_salt, sizeof(sigcache_salt)) == 0 &&
+        mxd_hash_update(&ctx, lengths, sizeof(lengths)) == 0 &&
+        mxd_hash_update(&ctx, public_key, public_key_length) == 0 &&
+        mxd_hash_update(&ctx, message, message_length) == 0 &&
+        mxd_hash_update(&ctx, signature, signature_length) == 0) {
+      rc = mxd_hash_final(&ctx, key);
+    }
+  }
+  pthread_rwlock_unlock(&sigcache_lock);
+  return rc;
+}
+
+static mxd_sigcache_shard_t *sigcache_locate(const uint8_t key[MXD_SIGCACHE_KEY_SIZE],
+                                             mxd_sigcache_slot_t **set) {
+  uint64_t h;
+  memcpy(&h, key, sizeof(h));
+  mxd_sigcache_shard_t *shard = &sigcache_shards[h % MXD_SIGCACHE_SHARDS];
+  size_t set_index = (size_t)(h / MXD_SIGCACHE_SHARDS) & (shard->set_count - 1);
+  *set = &shard->slots[set_index * MXD_SIGCACHE_WAYS];
+  return shard;
+}
+
+int mxd_sigcache_contains(const uint8_t key[MXD_SIGCACHE_KEY_SIZE]) {
+  if (!key || sigcache_acquire() != 0) {
+    return 0;
+  }
+
+  mxd_sigcache_slot_t *set;
+  mxd_sigcache_shard_t *shard = sigcache_locate(key, &set);
+  int found = 0;
+
+  pthread_mutex_lock(&shard->lock);
+  for (int w = 0; w < MXD_SIGCACHE_WAYS; w++) {
+    if (set[w].used && memcmp(set[w].key, key, MXD_SIGCACHE_KEY_SIZE) == 0) {
+      found = 1;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&shard->lock);
+  pthread_rwlock_unlock(&sigcache_lock);
+
+  __atomic_fetch_add(found ? &sigcache_hits : &sigcache_misses, 1, __ATOMIC_RELAXED);
+  return found;
+}
+
+void mxd_sigcache_insert(const uint8_t key[MXD_SIGCACHE_KEY_SIZE]) {
+  if (!key || sigcache_acquire() != 0) {
+    return;
+  }
+
+  mxd_sigcache_slot_t *set;
+  mxd_sigcache_shard_t *shard = sigcache_locate(key, &set);
+  mxd_sigcache_slot_t *target = NULL;
+  int evicted = 0;
+
+  pthread_mutex_lock(&shard->lock);
+  for (int w = 0; w < MXD_SIGCACHE_WAYS; w++) {
+    if (set[w].used && memcmp(set[w].key, key, MXD_SIGCACHE_KEY_SIZE) == 0) {
+      pthread_mutex_unlock(&shard->lock);
+      pthread_rwlock_unlock(&sigcache_lock);
+      return;
+    }
+    if (!target && !set[w].used) {
+      target = &set[w];
+    }
+  }
+  if (!target) {
+    // Set is full: replace ways round-robin
+    target = &set[shard->evict_cursor++ % MXD_SIGCACHE_WAYS];
+    evicted = 1;
+  } else {
+    shard->entries++;
+  }
+  memcpy(target->key, key, MXD_SIGCACHE_KEY_SIZE);
+  target->used = 1;
+  pthread_mutex_unlock(&shard->lock);
+  pthread_rwlock_unlock(&sigcache_lock);
+
+  __atomic_fetch_add(&sigcache_insertions, 1, __ATOMIC_RELAXED);
+  if (evicted) {
+    __atomic_fetch_add(&sigcache_evictions, 1, __ATOMIC_RELAXED);
+  }
+}
+
+void mxd_sigcache_get_stats(mxd_sigcache_stats_t *stats) {
+  if (!stats) {
+    return;
+  }
+  memset(stats, 0, sizeof(*stats));
+  stats->hits = __atomic_load_n(&sigcache_hits, __ATOMIC_RELAXED);
+  stats->misses = __atomic_load_n(&sigcache_misses, __ATOMIC_RELAXED);
+  stats->insertions = __atomic_load_n(&sigcache_insertions, __ATOMIC_RELAXED);
+  stats->evictions = __atomic_load_n(&sigcache_evictions, __ATOMIC_RELAXED);
+
+  pthread_rwlock_rdlock(&sigcache_lock);
+  if (sigcache_initialized) {
+    for (int i = 0; i < MXD_SIGCACHE_SHARDS; i++) {
+      pthread_mutex_lock(&sigcache_shards[i].lock);
+      stats->entries += sigcache_shards[i].entries;
+      pthread_mutex_unlock(&sigcache_shards[i].lock);
+    }
+    stats->capacity = sigcache_capacity;
+  }
+  pthread_rwlock_unlock(&sigcache_lock);
+}
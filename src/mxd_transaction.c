@@ -1,8 +1,10 @@
 #include "../include/mxd_logging.h"
 #include "../include/mxd_transaction.h"
 #include "../include/mxd_crypto.h"
+#include "../include/mxd_tx_wire.h"
 #include "../include/mxd_utxo.h"
 #include "../include/mxd_rocksdb_globals.h"
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -47,6 +49,36 @@ int mxd_create_transaction(mxd_transaction_t *tx) {
   return 0;
 }
 
+// Fill in a new input, looking up the amount of the UTXO it spends
+static void init_tx_input(const mxd_transaction_t *tx, mxd_tx_input_t *input,
+                          const uint8_t prev_tx_hash[64], uint32_t output_index,
+                          const uint8_t public_key[256]) {
+  memcpy(input->prev_tx_hash, prev_tx_hash, 64);
+  input->output_index = output_index;
+  memcpy(input->public_key, public_key, 256);
+  memset(input->signature, 0, 256); // Clear signature
+  input->amount = 0.0; // Will be populated during UTXO verification
+
+  // Verify UTXO exists and get amount
+  if (mxd_verify_tx_input_utxo(input, &input->amount) != 0) {
+    MXD_LOG_WARN("transaction", "UTXO not found or insufficient funds for input %u", tx->input_count);
+    // Don't fail here, will be caught during full validation
+  }
+}
+
+// Fill in a new output
+static void init_tx_output(const mxd_transaction_t *tx, mxd_tx_output_t *output,
+                           const uint8_t recipient_key[256], double amount) {
+  memcpy(output->recipient_key, recipient_key, 256);
+  output->amount = amount;
+
+  // Calculate public key hash for indexing
+  if (mxd_calculate_pubkey_hash(recipient_key, output->pubkey_hash) != 0) {
+    MXD_LOG_WARN("transaction", "Failed to calculate public key hash for output %u", tx->output_count);
+    // Don't fail here, will be caught during full validation
+  }
+}
+
 // Add input to transaction
 int mxd_add_tx_input(mxd_transaction_t *tx, const uint8_t prev_tx_hash[64],
                      uint32_t output_index, const uint8_t public_key[256]) {
@@ -55,6 +87,12 @@ int mxd_add_tx_input(mxd_transaction_t *tx, const uint8_t prev_tx_hash[64],
     return -1;
   }
 
+  // Arena-backed arrays cannot grow; use the builder for those
+  if (tx->arena_allocated) {
+    MXD_LOG_WARN("transaction", "Cannot append input to arena-backed transaction");
+    return -1;
+  }
+
   // Allocate or reallocate inputs array
   mxd_tx_input_t *new_inputs =
       realloc(tx->inputs, (tx->input_count + 1) * sizeof(mxd_tx_input_t));
@@ -63,20 +101,8 @@ int mxd_add_tx_input(mxd_transaction_t *tx, const uint8_t prev_tx_hash[64],
   }
   tx->inputs = new_inputs;
 
-  // Initialize new input
-  mxd_tx_input_t *input = &tx->inputs[tx->input_count];
-  memcpy(input->prev_tx_hash, prev_tx_hash, 64);
-  input->output_index = output_index;
-  memcpy(input->public_key, public_key, 256);
-  memset(input->signature, 0, 256); // Clear signature
-  input->amount = 0.0; // Will be populated during UTXO verification
-
-  // Verify UTXO exists and get amount
-  if (mxd_verify_tx_input_utxo(input, &input->amount) != 0) {
-    MXD_LOG_WARN("transaction", "UTXO not found or insufficient funds for input %u", tx->input_count);
-    // Don't fail here, will be caught during full validation
-  }
-
+  init_tx_input(tx, &tx->inputs[tx->input_count], prev_tx_hash, output_index,
+                public_key);
   tx->input_count++;
   return 0;
 }
@@ -89,6 +115,11 @@ int mxd_add_tx_output(mxd_transaction_t *tx, const uint8_t recipient_key[256],
     return -1;
   }
 
+  if (tx->arena_allocated) {
+    MXD_LOG_WARN("transaction", "Cannot append output to arena-backed transaction");
+    return -1;
+  }
+
   // Allocate or reallocate outputs array
   mxd_tx_output_t *new_outputs =
       realloc(tx->outputs, (tx->output_count + 1) * sizeof(mxd_tx_output_t));
@@ -97,17 +128,7 @@ int mxd_add_tx_output(mxd_transaction_t *tx, const uint8_t recipient_key[256],
   }
   tx->outputs = new_outputs;
 
-  // Initialize new output
-  mxd_tx_output_t *output = &tx->outputs[tx->output_count];
-  memcpy(output->recipient_key, recipient_key, 256);
-  output->amount = amount;
-  
-  // Calculate public key hash for indexing
-  if (mxd_calculate_pubkey_hash(recipient_key, output->pubkey_hash) != 0) {
-    MXD_LOG_WARN("transaction", "Failed to calculate public key hash for output %u", tx->output_count);
-    // Don't fail here, will be caught during full validation
-  }
-
+  init_tx_output(tx, &tx->outputs[tx->output_count], recipient_key, amount);
   tx->output_count++;
   return 0;
 }
@@ -118,60 +139,54 @@ int mxd_calculate_tx_hash(const mxd_transaction_t *tx, uint8_t hash[64]) {
     return -1;
   }
 
-  // Create buffer for transaction data
-  size_t buffer_size =
-      sizeof(uint32_t) * 3 +                            // version + counts
-      sizeof(double) +                                   // voluntary tip
-      sizeof(uint64_t) +                                // timestamp
-      tx->input_count * (64 + sizeof(uint32_t) + 256) + // inputs
-      tx->output_count * (256 + sizeof(double));        // outputs
+  // Amounts are hashed in base units, as they are encoded on the wire, so a
+  // decoded transaction hashes like the one that was sent
+  uint64_t tip_units;
+  if (mxd_tx_amount_to_units(tx->voluntary_tip, &tip_units) != 0) {
+    return -1;
+  }
 
-  uint8_t *buffer = malloc(buffer_size);
-  if (!buffer) {
+  // Stream the transaction fields straight into the digest instead of
+  // serializing them into a temporary buffer first
+  mxd_hash_ctx_t ctx;
+  if (mxd_hash_init(&ctx, MXD_HASH_SHA512) != 0) {
     return -1;
   }
 
-  // Serialize transaction data
-  size_t offset = 0;
-  memcpy(buffer + offset, &tx->version, sizeof(uint32_t));
-  offset += sizeof(uint32_t);
-  memcpy(buffer + offset, &tx->input_count, sizeof(uint32_t));
-  offset += sizeof(uint32_t);
-  memcpy(buffer + offset, &tx->output_count, sizeof(uint32_t));
-  offset += sizeof(uint32_t);
-  memcpy(buffer + offset, &tx->voluntary_tip, sizeof(double));
-  offset += sizeof(double);
-  memcpy(buffer + offset, &tx->timestamp, sizeof(uint64_t));
-  offset += sizeof(uint64_t);
+  if (mxd_hash_update(&ctx, &tx->version, sizeof(uint32_t)) != 0 ||
+      mxd_hash_update(&ctx, &tx->input_count, sizeof(uint32_t)) != 0 ||
+      mxd_hash_update(&ctx, &tx->output_count, sizeof(uint32_t)) != 0 ||
+      mxd_hash_update(&ctx, &tip_units, sizeof(uint64_t)) != 0 ||
+      mxd_hash_update(&ctx, &tx->timestamp, sizeof(uint64_t)) != 0) {
+    return -1;
+  }
 
-  // Serialize inputs (excluding signatures)
+  // Inputs (excluding signatures)
   for (uint32_t i = 0; i < tx->input_count; i++) {
-    memcpy(buffer + offset, tx->inputs[i].prev_tx_hash, 64);
-    offset += 64;
-    memcpy(buffer + offset, &tx->inputs[i].output_index, sizeof(uint32_t));
-    offset += sizeof(uint32_t);
-    memcpy(buffer + offset, tx->inputs[i].public_key, 256);
-    offset += 256;
+    if (mxd_hash_update(&ctx, tx->inputs[i].prev_tx_hash, 64) != 0 ||
+        mxd_hash_update(&ctx, &tx->inputs[i].output_index,
+                        sizeof(uint32_t)) != 0 ||
+        mxd_hash_update(&ctx, tx->inputs[i].public_key, 256) != 0) {
+      return -1;
+    }
   }
 
-  // Serialize outputs
+  // Outputs
   for (uint32_t i = 0; i < tx->output_count; i++) {
-    memcpy(buffer + offset, tx->outputs[i].recipient_key, 256);
-    offset += 256;
-    memcpy(buffer + offset, &tx->outputs[i].amount, sizeof(double));
-    offset += sizeof(double);
+    uint64_t units;
+    if (mxd_tx_amount_to_units(tx->outputs[i].amount, &units) != 0 ||
+        mxd_hash_update(&ctx, tx->outputs[i].recipient_key, 256) != 0 ||
+        mxd_hash_update(&ctx, &units, sizeof(uint64_t)) != 0) {
+      return -1;
+    }
   }
 
   // Calculate double SHA-512 hash
   uint8_t temp_hash[64];
-  int result = -1;
-  if (mxd_sha512(buffer, buffer_size, temp_hash) == 0 &&
-      mxd_sha512(temp_hash, 64, hash) == 0) {
-    result = 0;
+  if (mxd_hash_final(&ctx, temp_hash) != 0) {
+    return -1;
   }
-
-  free(buffer);
-  return result;
+  return mxd_sha512(temp_hash, 64, hash);
 }
 
 // Sign transaction input
@@ -193,6 +208,30 @@ int mxd_sign_tx_input(mxd_transaction_t *tx, uint32_t input_index,
                             &signature_length, tx_hash, 64, private_key);
 }
 
+// Sign every input with its own key
+int mxd_sign_tx_inputs(mxd_transaction_t *tx, const uint8_t *const private_keys[]) {
+  if (!tx || !private_keys || tx->input_count == 0) {
+    return -1;
+  }
+
+  // Signatures are not hashed, so the digest stays the same while the
+  // inputs are signed one after another
+  uint8_t tx_hash[64];
+  if (mxd_calculate_tx_hash(tx, tx_hash) != 0) {
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    size_t signature_length = 256;
+    if (!private_keys[i] ||
+        mxd_dilithium_sign(tx->inputs[i].signature, &signature_length, tx_hash, 64,
+                           private_keys[i]) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
 // Verify transaction input signature
 int mxd_verify_tx_input(const mxd_transaction_t *tx, uint32_t input_index) {
   if (!tx || input_index >= tx->input_count) {
@@ -206,8 +245,8 @@ int mxd_verify_tx_input(const mxd_transaction_t *tx, uint32_t input_index) {
   }
 
   // Verify the signature
-  return mxd_dilithium_verify(tx->inputs[input_index].signature, 256, tx_hash,
-                              64, tx->inputs[input_index].public_key);
+  return mxd_dilithium_verify_cached(tx->inputs[input_index].signature, 256, tx_hash,
+                                     64, tx->inputs[input_index].public_key);
 }
 
 // Validate entire transaction
@@ -222,10 +261,29 @@ int mxd_validate_transaction(const mxd_transaction_t *tx) {
   }
 
   if (!tx->is_coinbase) {
+    // Every input signs the same transaction hash, so hash once and verify
+    // all input signatures as one batch. Consensus validation always
+    // recomputes the digest rather than trusting a cached one.
+    uint8_t tx_hash[64];
+    if (mxd_calculate_tx_hash(tx, tx_hash) != 0) {
+      return -1;
+    }
+
+    mxd_sig_verify_item_t items[MXD_MAX_TX_INPUTS];
+    int results[MXD_MAX_TX_INPUTS];
+    for (uint32_t i = 0; i < tx->input_count; i++) {
+      items[i].signature = tx->inputs[i].signature;
+      items[i].signature_length = 256;
+      items[i].message = tx_hash;
+      items[i].message_length = 64;
+      items[i].public_key = tx->inputs[i].public_key;
+    }
+    mxd_dilithium_verify_batch(items, tx->input_count, results);
+
     // Verify all input signatures with error tracking
     int signature_errors = 0;
     for (uint32_t i = 0; i < tx->input_count; i++) {
-      if (mxd_verify_tx_input(tx, i) != 0) {
+      if (results[i] != 0) {
         signature_errors++;
         if (signature_errors > 10) {  // Allow some signature failures
           return -1;
@@ -240,25 +298,38 @@ int mxd_validate_transaction(const mxd_transaction_t *tx) {
     }
   }
 
+  // Amounts are checked in base units, the form they are hashed in. The
+  // tip is counted with the outputs.
+  uint64_t total_output = 0;
+  if (mxd_tx_amount_to_units(tx->voluntary_tip, &total_output) != 0) {
+    return -1;
+  }
+
   // Verify output amounts are positive
-  double total_output = 0;
   for (uint32_t i = 0; i < tx->output_count; i++) {
-    if (tx->outputs[i].amount <= 0) {
+    uint64_t units;
+    if (mxd_tx_amount_to_units(tx->outputs[i].amount, &units) != 0 || units == 0 ||
+        units > UINT64_MAX - total_output) {
       return -1;
     }
-    total_output += tx->outputs[i].amount;
+    total_output += units;
   }
 
   // For non-coinbase transactions, verify total output plus tip doesn't exceed input amount
   if (!tx->is_coinbase) {
-    double total_input = 0;
+    uint64_t total_input = 0;
     for (uint32_t i = 0; i < tx->input_count; i++) {
-      total_input += tx->inputs[i].amount;
+      uint64_t units;
+      if (mxd_tx_amount_to_units(tx->inputs[i].amount, &units) != 0 ||
+          units > UINT64_MAX - total_input) {
+        return -1;
+      }
+      total_input += units;
     }
     
-    if (total_output + tx->voluntary_tip > total_input) {
-      MXD_LOG_ERROR("transaction", "Transaction validation failed: outputs (%f) + tip (%f) exceed inputs (%f)",
-             total_output, tx->voluntary_tip, total_input);
+    if (total_output > total_input) {
+      MXD_LOG_ERROR("transaction", "Transaction validation failed: outputs + tip (%f) exceed inputs (%f)",
+             mxd_tx_units_to_amount(total_output), mxd_tx_units_to_amount(total_input));
       return -1;
     }
   }
@@ -273,7 +344,7 @@ int mxd_validate_transaction(const mxd_transaction_t *tx) {
 
 // Set voluntary tip for transaction
 int mxd_set_voluntary_tip(mxd_transaction_t *tx, double tip_amount) {
-  if (!tx || tip_amount < 0) {
+  if (!tx || !isfinite(tip_amount) || tip_amount < 0) {
     return -1;
   }
   tx->voluntary_tip = tip_amount;
@@ -288,28 +359,117 @@ double mxd_get_voluntary_tip(const mxd_transaction_t *tx) {
   return tx->voluntary_tip;
 }
 
+// Check an input against its UTXO (NULL if not found) and report its amount
+static int check_input_utxo(const mxd_tx_input_t *input, const mxd_utxo_t *utxo, double *amount) {
+  if (!utxo) {
+    MXD_LOG_WARN("transaction", "UTXO not found for given input (index=%u)", input->output_index);
+    
+    if (input->amount > 0.0) {
+      MXD_LOG_INFO("transaction", "Using provided input amount for testing");
+      *amount = input->amount;
+      return 0;
+    }
+    
+    return -1;
+  }
+  
+  // Verify UTXO is not spent
+  if (utxo->is_spent) {
+    MXD_LOG_ERROR("transaction", "UTXO is already spent");
+    return -1;
+  }
+  
+  // Verify public key matches
+  if (memcmp(utxo->owner_key, input->public_key, 256) != 0) {
+    MXD_LOG_ERROR("transaction", "UTXO owner key mismatch");
+    return -1;
+  }
+  
+  *amount = utxo->amount;
+  return 0;
+}
+
 // Validate transaction inputs against UTXO database
 int mxd_validate_transaction_inputs(const mxd_transaction_t *tx) {
-  if (!tx || tx->is_coinbase) {
+  if (!tx || tx->is_coinbase || tx->input_count > MXD_MAX_TX_INPUTS) {
     return -1;
   }
   
-  // Verify each input UTXO exists and has sufficient funds
+  // Resolve all input UTXOs with one batched lookup
+  mxd_utxo_outpoint_t outpoints[MXD_MAX_TX_INPUTS];
+  int found[MXD_MAX_TX_INPUTS];
+  mxd_utxo_t *utxos = calloc(tx->input_count ? tx->input_count : 1, sizeof(mxd_utxo_t));
+  if (!utxos) {
+    return -1;
+  }
   for (uint32_t i = 0; i < tx->input_count; i++) {
+    memcpy(outpoints[i].tx_hash, tx->inputs[i].prev_tx_hash, 64);
+    outpoints[i].output_index = tx->inputs[i].output_index;
+  }
+  int result = mxd_find_utxos(outpoints, tx->input_count, utxos, found);
+  if (result != 0) {
+    MXD_LOG_ERROR("transaction", "UTXO lookup failed for transaction inputs");
+  }
+  
+  // Verify each input UTXO exists and has sufficient funds
+  for (uint32_t i = 0; i < tx->input_count && result == 0; i++) {
     double amount = 0.0;
-    if (mxd_verify_tx_input_utxo(&tx->inputs[i], &amount) != 0) {
+    uint64_t units, cached_units;
+    if (check_input_utxo(&tx->inputs[i], found[i] == 0 ? &utxos[i] : NULL, &amount) != 0) {
       MXD_LOG_ERROR("transaction", "UTXO verification failed for input %u", i);
-      return -1;
-    }
-    
-    // Verify amount matches cached amount
-    if (amount != tx->inputs[i].amount) {
+      result = -1;
+    } else if (mxd_tx_amount_to_units(amount, &units) != 0 ||
+               mxd_tx_amount_to_units(tx->inputs[i].amount, &cached_units) != 0 ||
+               units != cached_units) {
+      // Verify amount matches cached amount
       MXD_LOG_ERROR("transaction", "UTXO amount mismatch for input %u: cached=%f, actual=%f", 
              i, tx->inputs[i].amount, amount);
-      return -1;
+      result = -1;
     }
   }
   
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    if (found[i] == 0) {
+      mxd_free_utxo(&utxos[i]);
+    }
+  }
+  free(utxos);
+  return result;
+}
+
+// Fill in the amount of every input from the UTXO it spends
+int mxd_load_tx_input_amounts(mxd_transaction_t *tx) {
+  if (!tx || tx->input_count > MXD_MAX_TX_INPUTS ||
+      (tx->input_count > 0 && !tx->inputs)) {
+    return -1;
+  }
+  if (tx->is_coinbase || tx->input_count == 0) {
+    return 0;
+  }
+
+  mxd_utxo_outpoint_t outpoints[MXD_MAX_TX_INPUTS];
+  int found[MXD_MAX_TX_INPUTS];
+  mxd_utxo_t *utxos = calloc(tx->input_count, sizeof(mxd_utxo_t));
+  if (!utxos) {
+    return -1;
+  }
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    memcpy(outpoints[i].tx_hash, tx->inputs[i].prev_tx_hash, 64);
+    outpoints[i].output_index = tx->inputs[i].output_index;
+  }
+  if (mxd_find_utxos(outpoints, tx->input_count, utxos, found) != 0) {
+    free(utxos);
+    return -1;
+  }
+
+  // Unknown outpoints keep amount 0 and fail full validation
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    tx->inputs[i].amount = found[i] == 0 ? utxos[i].amount : 0.0;
+    if (found[i] == 0) {
+      mxd_free_utxo(&utxos[i]);
+    }
+  }
+  free(utxos);
   return 0;
 }
 
@@ -321,32 +481,12 @@ int mxd_verify_tx_input_utxo(const mxd_tx_input_t *input, double *amount) {
   
   mxd_utxo_t utxo;
   if (mxd_get_utxo(input->prev_tx_hash, input->output_index, &utxo) != 0) {
-    MXD_LOG_WARN("transaction", "UTXO not found for given input (index=%u)", input->output_index);
-    
-    if (input->amount > 0.0) {
-      MXD_LOG_INFO("transaction", "Using provided input amount for testing");
-      *amount = input->amount;
-      return 0;
-    }
-    
-    return -1;
+    return check_input_utxo(input, NULL, amount);
   }
   
-  // Verify UTXO is not spent
-  if (utxo.is_spent) {
-    MXD_LOG_ERROR("transaction", "UTXO is already spent");
-    return -1;
-  }
-  
-  // Verify public key matches
-  if (memcmp(utxo.owner_key, input->public_key, 256) != 0) {
-    MXD_LOG_ERROR("transaction", "UTXO owner key mismatch");
-    return -1;
-  }
-  
-  *amount = utxo.amount;
-  
-  return 0;
+  int result = check_input_utxo(input, &utxo, amount);
+  mxd_free_utxo(&utxo);
+  return result;
 }
 
 // Calculate public key hash for indexing
@@ -462,11 +602,78 @@ int mxd_create_coinbase_transaction(mxd_transaction_t *tx, const uint8_t recipie
   return mxd_calculate_tx_hash(tx, tx->tx_hash);
 }
 
+// Start building a transaction whose arrays come from arena
+int mxd_tx_builder_begin(mxd_tx_builder_t *builder, mxd_arena_t *arena,
+                         mxd_transaction_t *tx, uint32_t max_inputs,
+                         uint32_t max_outputs) {
+  if (!builder || !arena || !tx || max_inputs > MXD_MAX_TX_INPUTS ||
+      max_outputs > MXD_MAX_TX_OUTPUTS) {
+    return -1;
+  }
+
+  if (mxd_create_transaction(tx) != 0) {
+    return -1;
+  }
+  tx->arena_allocated = 1;
+
+  // Reserve both arrays up front so appends never reallocate
+  if (max_inputs > 0) {
+    tx->inputs = mxd_arena_alloc(arena, max_inputs * sizeof(mxd_tx_input_t), 0);
+  }
+  if (max_outputs > 0) {
+    tx->outputs = mxd_arena_alloc(arena, max_outputs * sizeof(mxd_tx_output_t), 0);
+  }
+  if ((max_inputs > 0 && !tx->inputs) || (max_outputs > 0 && !tx->outputs)) {
+    MXD_LOG_WARN("transaction", "Transaction arena exhausted");
+    memset(tx, 0, sizeof(mxd_transaction_t));
+    return -1;
+  }
+
+  builder->tx = tx;
+  builder->input_capacity = max_inputs;
+  builder->output_capacity = max_outputs;
+  return 0;
+}
+
+// Append an input to the transaction being built
+int mxd_tx_builder_add_input(mxd_tx_builder_t *builder,
+                             const uint8_t prev_tx_hash[64],
+                             uint32_t output_index,
+                             const uint8_t public_key[256]) {
+  if (!builder || !builder->tx || !prev_tx_hash || !public_key ||
+      builder->tx->input_count >= builder->input_capacity) {
+    return -1;
+  }
+
+  mxd_transaction_t *tx = builder->tx;
+  init_tx_input(tx, &tx->inputs[tx->input_count], prev_tx_hash, output_index,
+                public_key);
+  tx->input_count++;
+  return 0;
+}
+
+// Append an output to the transaction being built
+int mxd_tx_builder_add_output(mxd_tx_builder_t *builder,
+                              const uint8_t recipient_key[256], double amount) {
+  if (!builder || !builder->tx || !recipient_key || amount <= 0 ||
+      builder->tx->output_count >= builder->output_capacity) {
+    return -1;
+  }
+
+  mxd_transaction_t *tx = builder->tx;
+  init_tx_output(tx, &tx->outputs[tx->output_count], recipient_key, amount);
+  tx->output_count++;
+  return 0;
+}
+
 // Free transaction resources
 void mxd_free_transaction(mxd_transaction_t *tx) {
   if (tx) {
-    free(tx->inputs);
-    free(tx->outputs);
+    // Arena-backed arrays are released by resetting the arena
+    if (!tx->arena_allocated) {
+      free(tx->inputs);
+      free(tx->outputs);
+    }
     memset(tx, 0, sizeof(mxd_transaction_t));
   }
 }
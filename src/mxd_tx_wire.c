@@ -0,0 +1,565 @@
+#include "../include/mxd_tx_wire.h"
+#include "../include/mxd_crypto.h"
+#include "../include/mxd_logging.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Largest amount, in base units, a transaction may carry
+#define MXD_TX_WIRE_MAX_UNITS 9000000000000000000ULL
+
+static const uint8_t zero_padding[256] = {0};
+
+size_t mxd_varint_size(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+size_t mxd_varint_write(uint8_t *out, uint64_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+int mxd_varint_read(const uint8_t *data, size_t length, size_t *offset,
+                    uint64_t max, uint64_t *value) {
+  uint64_t result = 0;
+  size_t pos = *offset;
+
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (pos >= length) {
+      return -1;
+    }
+    uint8_t byte = data[pos++];
+    if (shift == 63 && byte > 1) {
+      return -1;
+    }
+    result |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      // A trailing zero byte means the value had a shorter encoding
+      if (byte == 0 && shift > 0) {
+        return -1;
+      }
+      if (result > max) {
+        return -1;
+      }
+      *offset = pos;
+      *value = result;
+      return 0;
+    }
+  }
+  return -1;
+}
+
+// Length of a fixed 256-byte field without its zero padding
+static size_t trimmed_length(const uint8_t field[256]) {
+  size_t len = 256;
+  while (len > 0 && field[len - 1] == 0) {
+    len--;
+  }
+  return len;
+}
+
+// Read a length-prefixed key or signature in place
+static int read_field(const uint8_t *data, size_t length, size_t *offset,
+                      const uint8_t **field, size_t *field_length) {
+  uint64_t len;
+  if (mxd_varint_read(data, length, offset, 256, &len) != 0 ||
+      len > length - *offset) {
+    return -1;
+  }
+  // Canonical fields carry no zero padding
+  if (len > 0 && data[*offset + len - 1] == 0) {
+    return -1;
+  }
+  *field = data + *offset;
+  *field_length = (size_t)len;
+  *offset += (size_t)len;
+  return 0;
+}
+
+int mxd_tx_amount_to_units(double amount, uint64_t *units) {
+  if (!units || !isfinite(amount) || amount < 0.0 ||
+      amount > (double)MXD_TX_WIRE_MAX_UNITS / (double)MXD_TX_WIRE_AMOUNT_SCALE) {
+    return -1;
+  }
+  // Quantize to the nearest unit, so that e.g. change computed as 0.1 + 0.2
+  // encodes; transaction hashes and validation are defined over units too
+  *units = (uint64_t)llround(amount * (double)MXD_TX_WIRE_AMOUNT_SCALE);
+  return 0;
+}
+
+double mxd_tx_units_to_amount(uint64_t units) {
+  return (double)units / (double)MXD_TX_WIRE_AMOUNT_SCALE;
+}
+
+size_t mxd_tx_encoded_size(const mxd_transaction_t *tx) {
+  if (!tx || tx->input_count > MXD_MAX_TX_INPUTS ||
+      tx->output_count > MXD_MAX_TX_OUTPUTS ||
+      (tx->input_count > 0 && !tx->inputs) ||
+      (tx->output_count > 0 && !tx->outputs)) {
+    return 0;
+  }
+
+  uint64_t tip_units;
+  if (mxd_tx_amount_to_units(tx->voluntary_tip, &tip_units) != 0) {
+    return 0;
+  }
+
+  size_t size = 1 + mxd_varint_size(tx->version) + 1 + mxd_varint_size(tx->timestamp) +
+                mxd_varint_size(tip_units) + mxd_varint_size(tx->input_count);
+
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    const mxd_tx_input_t *input = &tx->inputs[i];
+    size_t key_len = trimmed_length(input->public_key);
+    size_t sig_len = trimmed_length(input->signature);
+    size += 64 + mxd_varint_size(input->output_index) + mxd_varint_size(key_len) +
+            key_len + mxd_varint_size(sig_len) + sig_len;
+  }
+
+  size += mxd_varint_size(tx->output_count);
+  for (uint32_t i = 0; i < tx->output_count; i++) {
+    const mxd_tx_output_t *output = &tx->outputs[i];
+    uint64_t units;
+    if (mxd_tx_amount_to_units(output->amount, &units) != 0) {
+      return 0;
+    }
+    size_t key_len = trimmed_length(output->recipient_key);
+    size += mxd_varint_size(key_len) + key_len + mxd_varint_size(units);
+  }
+
+  return size;
+}
+
+int mxd_tx_encode(const mxd_transaction_t *tx, uint8_t *buffer, size_t capacity,
+                  size_t *written) {
+  if (!tx || !buffer || !written) {
+    return -1;
+  }
+
+  size_t size = mxd_tx_encoded_size(tx);
+  if (size == 0) {
+    MXD_LOG_WARN("tx_wire", "Transaction cannot be encoded");
+    return -1;
+  }
+  if (size > capacity) {
+    return -1;
+  }
+
+  // Amounts were range-checked by mxd_tx_encoded_size
+  uint64_t units;
+  size_t pos = 0;
+  buffer[pos++] = MXD_TX_WIRE_VERSION;
+  pos += mxd_varint_write(buffer + pos, tx->version);
+  buffer[pos++] = tx->is_coinbase ? MXD_TX_WIRE_FLAG_COINBASE : 0;
+  pos += mxd_varint_write(buffer + pos, tx->timestamp);
+  mxd_tx_amount_to_units(tx->voluntary_tip, &units);
+  pos += mxd_varint_write(buffer + pos, units);
+
+  pos += mxd_varint_write(buffer + pos, tx->input_count);
+  for (uint32_t i = 0; i < tx->input_count; i++) {
+    const mxd_tx_input_t *input = &tx->inputs[i];
+    size_t key_len = trimmed_length(input->public_key);
+    size_t sig_len = trimmed_length(input->signature);
+
+    memcpy(buffer + pos, input->prev_tx_hash, 64);
+    pos += 64;
+    pos += mxd_varint_write(buffer + pos, input->output_index);
+    pos += mxd_varint_write(buffer + pos, key_len);
+    memcpy(buffer + pos, input->public_key, key_len);
+    pos += key_len;
+    pos += mxd_varint_write(buffer + pos, sig_len);
+    memcpy(buffer + pos, input->signature, sig_len);
+    pos += sig_len;
+  }
+
+  pos += mxd_varint_write(buffer + pos, tx->output_count);
+  for (uint32_t i = 0; i < tx->output_count; i++) {
+    const mxd_tx_output_t *output = &tx->outputs[i];
+    size_t key_len = trimmed_length(output->recipient_key);
+
+    pos += mxd_varint_write(buffer + pos, key_len);
+    memcpy(buffer + pos, output->recipient_key, key_len);
+    pos += key_len;
+    mxd_tx_amount_to_units(output->amount, &units);
+    pos += mxd_varint_write(buffer + pos, units);
+  }
+
+  *written = pos;
+  return 0;
+}
+
+// Skip over one encoded input, validating it
+static int skip_input(const uint8_t *data, size_t length, size_t *offset,
+                      mxd_tx_input_view_t *input) {
+  mxd_tx_input_view_t tmp;
+  uint64_t output_index;
+
+  if (!input) {
+    input = &tmp;
+  }
+  if (length - *offset < 64) {
+    return -1;
+  }
+  input->prev_tx_hash = data + *offset;
+  *offset += 64;
+
+  if (mxd_varint_read(data, length, offset, UINT32_MAX, &output_index) != 0 ||
+      read_field(data, length, offset, &input->public_key,
+                 &input->public_key_length) != 0 ||
+      read_field(data, length, offset, &input->signature,
+                 &input->signature_length) != 0) {
+    return -1;
+  }
+  input->output_index = (uint32_t)output_index;
+  return 0;
+}
+
+// Read an amount in base units. Only values that survive the round trip
+// through the decoded transaction's double are accepted: above 2^53 distinct
+// values collapse to the same double, which re-encodes and hashes as another
+// value.
+static int read_units(const uint8_t *data, size_t length, size_t *offset, uint64_t *units) {
+  uint64_t round_trip;
+  if (mxd_varint_read(data, length, offset, MXD_TX_WIRE_MAX_UNITS, units) != 0 ||
+      mxd_tx_amount_to_units(mxd_tx_units_to_amount(*units), &round_trip) != 0 ||
+      round_trip != *units) {
+    return -1;
+  }
+  return 0;
+}
+
+// Skip over one encoded output, validating it
+static int skip_output(const uint8_t *data, size_t length, size_t *offset,
+                       mxd_tx_output_view_t *output) {
+  mxd_tx_output_view_t tmp;
+
+  if (!output) {
+    output = &tmp;
+  }
+  if (read_field(data, length, offset, &output->recipient_key,
+                 &output->recipient_key_length) != 0 ||
+      read_units(data, length, offset, &output->amount_units) != 0) {
+    return -1;
+  }
+  return 0;
+}
+
+int mxd_tx_view_parse(mxd_tx_view_t *view, const uint8_t *buffer, size_t length) {
+  if (!view || !buffer || length == 0) {
+    return -1;
+  }
+
+  memset(view, 0, sizeof(*view));
+  size_t pos = 0;
+  uint64_t value;
+
+  if (buffer[pos++] != MXD_TX_WIRE_VERSION) {
+    return -1;
+  }
+
+  if (mxd_varint_read(buffer, length, &pos, UINT32_MAX, &value) != 0) {
+    return -1;
+  }
+  view->version = (uint32_t)value;
+
+  if (pos >= length || (buffer[pos] & ~MXD_TX_WIRE_FLAG_COINBASE) != 0) {
+    return -1;
+  }
+  view->is_coinbase = buffer[pos++] & MXD_TX_WIRE_FLAG_COINBASE;
+
+  if (mxd_varint_read(buffer, length, &pos, UINT64_MAX, &view->timestamp) != 0 ||
+      read_units(buffer, length, &pos, &view->tip_units) != 0) {
+    return -1;
+  }
+
+  if (mxd_varint_read(buffer, length, &pos, MXD_MAX_TX_INPUTS, &value) != 0) {
+    return -1;
+  }
+  view->input_count = (uint32_t)value;
+  view->inputs_offset = pos;
+  for (uint32_t i = 0; i < view->input_count; i++) {
+    if (skip_input(buffer, length, &pos, NULL) != 0) {
+      return -1;
+    }
+  }
+
+  if (mxd_varint_read(buffer, length, &pos, MXD_MAX_TX_OUTPUTS, &value) != 0) {
+    return -1;
+  }
+  view->output_count = (uint32_t)value;
+  view->outputs_offset = pos;
+  for (uint32_t i = 0; i < view->output_count; i++) {
+    if (skip_output(buffer, length, &pos, NULL) != 0) {
+      return -1;
+    }
+  }
+
+  view->data = buffer;
+  view->length = pos;
+  return 0;
+}
+
+int mxd_tx_view_get_input(const mxd_tx_view_t *view, uint32_t index,
+                          mxd_tx_input_view_t *input) {
+  if (!view || !view->data || !input || index >= view->input_count) {
+    return -1;
+  }
+
+  // The view was validated on parse, so walking it cannot run off the end
+  size_t pos = view->inputs_offset;
+  for (uint32_t i = 0; i < index; i++) {
+    skip_input(view->data, view->length, &pos, NULL);
+  }
+  return skip_input(view->data, view->length, &pos, input);
+}
+
+int mxd_tx_view_get_output(const mxd_tx_view_t *view, uint32_t index,
+                           mxd_tx_output_view_t *output) {
+  if (!view || !view->data || !output || index >= view->output_count) {
+    return -1;
+  }
+
+  size_t pos = view->outputs_offset;
+  for (uint32_t i = 0; i < index; i++) {
+    skip_output(view->data, view->length, &pos, NULL);
+  }
+  return skip_output(view->data, view->length, &pos, output);
+}
+
+int mxd_tx_view_hash(const mxd_tx_view_t *view, uint8_t hash[64]) {
+  if (!view || !view->data || !hash) {
+    return -1;
+  }
+
+  // Same layout as mxd_calculate_tx_hash, with fields re-padded to 256 bytes
+  mxd_hash_ctx_t ctx;
+  if (mxd_hash_init(&ctx, MXD_HASH_SHA512) != 0) {
+    return -1;
+  }
+
+  if (mxd_hash_update(&ctx, &view->version, sizeof(uint32_t)) != 0 ||
+      mxd_hash_update(&ctx, &view->input_count, sizeof(uint32_t)) != 0 ||
+      mxd_hash_update(&ctx, &view->output_count, sizeof(uint32_t)) != 0 ||
+      mxd_hash_update(&ctx, &view->tip_units, sizeof(uint64_t)) != 0 ||
+      mxd_hash_update(&ctx, &view->timestamp, sizeof(uint64_t)) != 0) {
+    return -1;
+  }
+
+  size_t pos = view->inputs_offset;
+  for (uint32_t i = 0; i < view->input_count; i++) {
+    mxd_tx_input_view_t input;
+    if (skip_input(view->data, view->length, &pos, &input) != 0 ||
+        mxd_hash_update(&ctx, input.prev_tx_hash, 64) != 0 ||
+        mxd_hash_update(&ctx, &input.output_index, sizeof(uint32_t)) != 0 ||
+        mxd_hash_update(&ctx, input.public_key, input.public_key_length) != 0 ||
+        mxd_hash_update(&ctx, zero_padding, 256 - input.public_key_length) != 0) {
+      return -1;
+    }
+  }
+
+  pos = view->outputs_offset;
+  for (uint32_t i = 0; i < view->output_count; i++) {
+    mxd_tx_output_view_t output;
+    if (skip_output(view->data, view->length, &pos, &output) != 0) {
+      return -1;
+    }
+    if (mxd_hash_update(&ctx, output.recipient_key, output.recipient_key_length) != 0 ||
+        mxd_hash_update(&ctx, zero_padding, 256 - output.recipient_key_length) != 0 ||
+        mxd_hash_update(&ctx, &output.amount_units, sizeof(uint64_t)) != 0) {
+      return -1;
+    }
+  }
+
+  uint8_t temp_hash[64];
+  if (mxd_hash_final(&ctx, temp_hash) != 0) {
+    return -1;
+  }
+  return mxd_sha512(temp_hash, 64, hash);
+}
+
+// Materialize a view with its arrays on the heap, or in arena if given
+static int view_to_transaction(const mxd_tx_view_t *view, mxd_arena_t *arena,
+                               mxd_transaction_t *tx) {
+  if (!view || !view->data || !tx) {
+    return -1;
+  }
+
+  if (mxd_create_transaction(tx) != 0) {
+    return -1;
+  }
+  tx->version = view->version;
+  tx->is_coinbase = view->is_coinbase;
+  tx->timestamp = view->timestamp;
+  tx->voluntary_tip = mxd_tx_units_to_amount(view->tip_units);
+  tx->arena_allocated = arena != NULL;
+
+  if (view->input_count > 0) {
+    tx->inputs = arena ? mxd_arena_calloc(arena, view->input_count, sizeof(mxd_tx_input_t))
+                       : calloc(view->input_count, sizeof(mxd_tx_input_t));
+    if (!tx->inputs) {
+      mxd_free_transaction(tx);
+      return -1;
+    }
+  }
+  if (view->output_count > 0) {
+    tx->outputs = arena ? mxd_arena_calloc(arena, view->output_count, sizeof(mxd_tx_output_t))
+                        : calloc(view->output_count, sizeof(mxd_tx_output_t));
+    if (!tx->outputs) {
+      mxd_free_transaction(tx);
+      return -1;
+    }
+  }
+
+  size_t pos = view->inputs_offset;
+  for (uint32_t i = 0; i < view->input_count; i++) {
+    mxd_tx_input_view_t input;
+    if (skip_input(view->data, view->length, &pos, &input) != 0) {
+      mxd_free_transaction(tx);
+      return -1;
+    }
+    memcpy(tx->inputs[i].prev_tx_hash, input.prev_tx_hash, 64);
+    tx->inputs[i].output_index = input.output_index;
+    memcpy(tx->inputs[i].public_key, input.public_key, input.public_key_length);
+    memcpy(tx->inputs[i].signature, input.signature, input.signature_length);
+  }
+  tx->input_count = view->input_count;
+
+  // Input amounts are not on the wire; look them up like mxd_add_tx_input
+  if (mxd_load_tx_input_amounts(tx) != 0) {
+    MXD_LOG_WARN("tx_wire", "Could not look up input amounts of decoded transaction");
+    // Don't fail here, will be caught during full validation
+  }
+
+  pos = view->outputs_offset;
+  for (uint32_t i = 0; i < view->output_count; i++) {
+    mxd_tx_output_view_t output;
+    if (skip_output(view->data, view->length, &pos, &output) != 0) {
+      mxd_free_transaction(tx);
+      return -1;
+    }
+    memcpy(tx->outputs[i].recipient_key, output.recipient_key,
+           output.recipient_key_length);
+    tx->outputs[i].amount = mxd_tx_units_to_amount(output.amount_units);
+    mxd_calculate_pubkey_hash(tx->outputs[i].recipient_key,
+                              tx->outputs[i].pubkey_hash);
+  }
+  tx->output_count = view->output_count;
+
+  return 0;
+}
+
+int mxd_tx_view_to_transaction(const mxd_tx_view_t *view, mxd_transaction_t *tx) {
+  return view_to_transaction(view, NULL, tx);
+}
+
+int mxd_tx_view_to_transaction_arena(const mxd_tx_view_t *view, mxd_arena_t *arena,
+                                     mxd_transaction_t *tx) {
+  if (!arena) {
+    return -1;
+  }
+  return view_to_transaction(view, arena, tx);
+}
+
+int mxd_tx_decode(const uint8_t *buffer, size_t length, mxd_transaction_t *tx,
+                  size_t *consumed) {
+  mxd_tx_view_t view;
+  if (mxd_tx_view_parse(&view, buffer, length) != 0 ||
+      mxd_tx_view_to_transaction(&view, tx) != 0) {
+    return -1;
+  }
+  if (consumed) {
+    *consumed = view.length;
+  }
+  return 0;
+}
+
+int mxd_tx_list_encode(const mxd_transaction_t *txs, size_t count,
+                       uint8_t **buffer, size_t *length) {
+  if ((!txs && count > 0) || !buffer || !length || count > UINT32_MAX) {
+    return -1;
+  }
+
+  size_t total = mxd_varint_size(count);
+  for (size_t i = 0; i < count; i++) {
+    size_t size = mxd_tx_encoded_size(&txs[i]);
+    if (size == 0) {
+      return -1;
+    }
+    total += size;
+  }
+
+  uint8_t *data = malloc(total);
+  if (!data) {
+    return -1;
+  }
+
+  size_t pos = mxd_varint_write(data, count);
+  for (size_t i = 0; i < count; i++) {
+    size_t written;
+    if (mxd_tx_encode(&txs[i], data + pos, total - pos, &written) != 0) {
+      free(data);
+      return -1;
+    }
+    pos += written;
+  }
+
+  *buffer = data;
+  *length = pos;
+  return 0;
+}
+
+int mxd_tx_list_validate(const uint8_t *buffer, size_t length, uint32_t *count) {
+  if (!buffer || !count) {
+    return -1;
+  }
+
+  size_t pos = 0;
+  uint64_t n;
+  if (mxd_varint_read(buffer, length, &pos, UINT32_MAX, &n) != 0) {
+    return -1;
+  }
+
+  for (uint64_t i = 0; i < n; i++) {
+    mxd_tx_view_t view;
+    if (mxd_tx_view_parse(&view, buffer + pos, length - pos) != 0) {
+      return -1;
+    }
+    pos += view.length;
+  }
+
+  // Trailing bytes would make the encoding non-canonical
+  if (pos != length) {
+    return -1;
+  }
+  *count = (uint32_t)n;
+  return 0;
+}
+
+int mxd_tx_list_next(const uint8_t *buffer, size_t length, size_t *offset,
+                     mxd_tx_view_t *view) {
+  if (!buffer || !offset || !view) {
+    return -1;
+  }
+
+  if (*offset == 0) {
+    uint64_t n;
+    if (mxd_varint_read(buffer, length, offset, UINT32_MAX, &n) != 0) {
+      return -1;
+    }
+  }
+  if (*offset >= length ||
+      mxd_tx_view_parse(view, buffer + *offset, length - *offset) != 0) {
+    return -1;
+  }
+  *offset += view->length;
+  return 0;
+}
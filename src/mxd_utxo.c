@@ -1,7 +1,12 @@
 #include "mxd_logging.h"
 
 #include "../include/mxd_utxo.h"
+#include "../include/mxd_utxo_cache.h"
+#include "../include/mxd_utxo_resident.h"
 #include "../include/mxd_crypto.h"
+#include "../include/mxd_tx_wire.h"
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,49 +17,161 @@
 static rocksdb_options_t *options = NULL;
 static char *db_path_global = NULL;
 
-static size_t utxo_count = 0;
-static size_t pruned_count = 0;
-static double total_value = 0.0;
+// Running totals over the stored records, kept up to date by every change
+// and persisted under MXD_UTXO_STATS_KEY in the same write
+typedef struct {
+    uint64_t count;          // Stored records, spent or not
+    uint64_t spent;          // Spent records not yet pruned
+    int64_t unspent_units;   // Value of unspent records in base units
+    mxd_muhash_t commitment; // Multiset hash of the unspent records
+} mxd_utxo_stats_record_t;
 
-#define LRU_CACHE_SIZE 5000
-static mxd_utxo_t *lru_cache = NULL;
-static size_t lru_cache_count = 0;
-static uint64_t *lru_access_counter = NULL;
-static uint64_t current_access_count = 0;
+static mxd_utxo_stats_record_t stats;
+
+// Memory budget for the UTXO cache (0 selects the default)
+static size_t utxo_cache_budget = 0;
+
+// Memory mode: the whole set is resident, so lookups never read the
+// database, and blocks are committed without an fsync. RocksDB's WAL is
+// synced in the background every memory_flush_interval blocks; after a
+// crash the set reopens at the last block that reached the WAL and the
+// rest is replayed.
+static int memory_mode = 0;
+static uint32_t memory_flush_interval = MXD_UTXO_DEFAULT_FLUSH_INTERVAL;
+static rocksdb_writeoptions_t *deferred_writeoptions = NULL;
+static uint32_t blocks_since_sync = 0;
+
+static pthread_t wal_sync_thread;
+static pthread_mutex_t wal_sync_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wal_sync_cond = PTHREAD_COND_INITIALIZER;
+static int wal_sync_running = 0;
+static int wal_sync_requested = 0;
+static int wal_sync_stop = 0;
+
+// Compact UTXO record, version 1. The outpoint is part of the key.
+//
+//   u8      record version (MXD_UTXO_RECORD_VERSION)
+//   u8      flags (MXD_UTXO_FLAG_*)
+//   varint  amount in base units, or an 8-byte double with RAW_AMOUNT
+//   u8[20]  owner pubkey hash
+//   varint  owner key length + key without zero padding
+//   varint  required signatures
+//   with COSIGNERS: varint count, then length-prefixed keys as above
+//
+// Older databases stored the raw mxd_utxo_t; those records are still read
+// and are rewritten by migrate_utxo_records() when the database is opened.
+#define MXD_UTXO_RECORD_VERSION 1
+#define MXD_UTXO_FLAG_SPENT 0x01
+#define MXD_UTXO_FLAG_RAW_AMOUNT 0x02   // Amount not representable in base units
+#define MXD_UTXO_FLAG_COSIGNERS 0x04
+#define MXD_UTXO_FLAGS_KNOWN 0x07
+
+#define MXD_UTXO_FORMAT_KEY "utxo_meta:format"
+
+// Present once the per-address balance index covers every stored UTXO
+#define MXD_UTXO_BALANCE_KEY "utxo_meta:balance_index"
+
+// Length of a fixed 256-byte key without its zero padding
+static size_t trimmed_key_length(const uint8_t key[256]) {
+    size_t len = 256;
+    while (len > 0 && key[len - 1] == 0) {
+        len--;
+    }
+    return len;
+}
+
+// Amount in base units if it converts back to exactly the same double;
+// records store any other amount as a raw double so it is kept bit for bit
+static int exact_units(double amount, uint64_t *units) {
+    return mxd_tx_amount_to_units(amount, units) == 0 &&
+           mxd_tx_units_to_amount(*units) == amount ? 0 : -1;
+}
+
+// Amount in base units for the balance index; sub-unit remainders of
+// amounts the record stores as raw doubles are rounded
+static int64_t balance_units(double amount) {
+    uint64_t units;
+    if (mxd_tx_amount_to_units(amount, &units) == 0) {
+        return (int64_t)units;
+    }
+    return (int64_t)llround(amount * (double)MXD_TX_WIRE_AMOUNT_SCALE);
+}
 
 static int serialize_utxo(const mxd_utxo_t *utxo, uint8_t **data, size_t *data_len) {
     if (!utxo || !data || !data_len) {
         return -1;
     }
 
-    size_t size = sizeof(mxd_utxo_t);
-    if (utxo->cosigner_count > 0 && utxo->cosigner_keys) {
-        size += utxo->cosigner_count * 256;
+    uint8_t flags = utxo->is_spent ? MXD_UTXO_FLAG_SPENT : 0;
+    uint64_t units = 0;
+    if (exact_units(utxo->amount, &units) != 0) {
+        flags |= MXD_UTXO_FLAG_RAW_AMOUNT;
+    }
+    uint32_t cosigners = utxo->cosigner_keys ? utxo->cosigner_count : 0;
+    if (cosigners > 0) {
+        flags |= MXD_UTXO_FLAG_COSIGNERS;
+    }
+
+    size_t owner_len = trimmed_key_length(utxo->owner_key);
+    size_t size = 2 + ((flags & MXD_UTXO_FLAG_RAW_AMOUNT) ? sizeof(double) : mxd_varint_size(units)) +
+                  20 + mxd_varint_size(owner_len) + owner_len +
+                  mxd_varint_size(utxo->required_signatures);
+    if (cosigners > 0) {
+        size += mxd_varint_size(cosigners);
+        for (uint32_t i = 0; i < cosigners; i++) {
+            size_t len = trimmed_key_length(utxo->cosigner_keys + i * 256);
+            size += mxd_varint_size(len) + len;
+        }
     }
 
-    // Allocate memory
     *data = malloc(size);
     if (!*data) {
         return -1;
     }
 
-    // Copy UTXO structure
-    memcpy(*data, utxo, sizeof(mxd_utxo_t));
-    
-    // Copy cosigner keys if present
-    if (utxo->cosigner_count > 0 && utxo->cosigner_keys) {
-        memcpy(*data + sizeof(mxd_utxo_t), utxo->cosigner_keys, utxo->cosigner_count * 256);
+    uint8_t *p = *data;
+    *p++ = MXD_UTXO_RECORD_VERSION;
+    *p++ = flags;
+    if (flags & MXD_UTXO_FLAG_RAW_AMOUNT) {
+        memcpy(p, &utxo->amount, sizeof(double));
+        p += sizeof(double);
+    } else {
+        p += mxd_varint_write(p, units);
+    }
+    memcpy(p, utxo->pubkey_hash, 20);
+    p += 20;
+    p += mxd_varint_write(p, owner_len);
+    memcpy(p, utxo->owner_key, owner_len);
+    p += owner_len;
+    p += mxd_varint_write(p, utxo->required_signatures);
+    if (cosigners > 0) {
+        p += mxd_varint_write(p, cosigners);
+        for (uint32_t i = 0; i < cosigners; i++) {
+            const uint8_t *key = utxo->cosigner_keys + i * 256;
+            size_t len = trimmed_key_length(key);
+            p += mxd_varint_write(p, len);
+            memcpy(p, key, len);
+            p += len;
+        }
     }
 
     *data_len = size;
     return 0;
 }
 
-static int deserialize_utxo(const uint8_t *data, size_t data_len, mxd_utxo_t *utxo) {
-    if (!data || !utxo || data_len < sizeof(mxd_utxo_t)) {
-        return -1;
+// A raw mxd_utxo_t record starts with the outpoint it is stored under
+static int is_legacy_record(const uint8_t tx_hash[64], uint32_t output_index,
+                            const uint8_t *data, size_t data_len) {
+    mxd_utxo_t header;
+    if (data_len < sizeof(mxd_utxo_t)) {
+        return 0;
     }
+    memcpy(&header, data, sizeof(mxd_utxo_t));
+    return memcmp(header.tx_hash, tx_hash, 64) == 0 && header.output_index == output_index &&
+           data_len == sizeof(mxd_utxo_t) + (size_t)header.cosigner_count * 256;
+}
 
+static int deserialize_legacy_utxo(const uint8_t *data, size_t data_len, mxd_utxo_t *utxo) {
     // Copy UTXO structure
     memcpy(utxo, data, sizeof(mxd_utxo_t));
     
@@ -72,6 +189,90 @@ static int deserialize_utxo(const uint8_t *data, size_t data_len, mxd_utxo_t *ut
     return 0;
 }
 
+// Read a length-prefixed key into a zero-padded 256-byte field
+static int read_key(const uint8_t *data, size_t data_len, size_t *offset, uint8_t key[256]) {
+    uint64_t len;
+    if (mxd_varint_read(data, data_len, offset, 256, &len) != 0 || len > data_len - *offset) {
+        return -1;
+    }
+    memset(key, 0, 256);
+    memcpy(key, data + *offset, (size_t)len);
+    *offset += (size_t)len;
+    return 0;
+}
+
+static int deserialize_utxo(const uint8_t tx_hash[64], uint32_t output_index,
+                            const uint8_t *data, size_t data_len, mxd_utxo_t *utxo) {
+    if (!tx_hash || !data || !utxo) {
+        return -1;
+    }
+
+    if (is_legacy_record(tx_hash, output_index, data, data_len)) {
+        return deserialize_legacy_utxo(data, data_len, utxo);
+    }
+
+    if (data_len < 2 || data[0] != MXD_UTXO_RECORD_VERSION || (data[1] & ~MXD_UTXO_FLAGS_KNOWN)) {
+        return -1;
+    }
+
+    memset(utxo, 0, sizeof(mxd_utxo_t));
+    memcpy(utxo->tx_hash, tx_hash, 64);
+    utxo->output_index = output_index;
+
+    uint8_t flags = data[1];
+    size_t pos = 2;
+    uint64_t value;
+    utxo->is_spent = (flags & MXD_UTXO_FLAG_SPENT) ? 1 : 0;
+    if (flags & MXD_UTXO_FLAG_RAW_AMOUNT) {
+        if (data_len - pos < sizeof(double)) {
+            return -1;
+        }
+        memcpy(&utxo->amount, data + pos, sizeof(double));
+        pos += sizeof(double);
+    } else {
+        if (mxd_varint_read(data, data_len, &pos, UINT64_MAX, &value) != 0) {
+            return -1;
+        }
+        utxo->amount = mxd_tx_units_to_amount(value);
+    }
+
+    if (data_len - pos < 20) {
+        return -1;
+    }
+    memcpy(utxo->pubkey_hash, data + pos, 20);
+    pos += 20;
+
+    if (read_key(data, data_len, &pos, utxo->owner_key) != 0 ||
+        mxd_varint_read(data, data_len, &pos, UINT32_MAX, &value) != 0) {
+        return -1;
+    }
+    utxo->required_signatures = (uint32_t)value;
+
+    if (flags & MXD_UTXO_FLAG_COSIGNERS) {
+        // Every key takes at least its length byte
+        if (mxd_varint_read(data, data_len, &pos, data_len - pos, &value) != 0 || value == 0) {
+            return -1;
+        }
+        utxo->cosigner_keys = malloc((size_t)value * 256);
+        if (!utxo->cosigner_keys) {
+            return -1;
+        }
+        utxo->cosigner_count = (uint32_t)value;
+        for (uint32_t i = 0; i < utxo->cosigner_count; i++) {
+            if (read_key(data, data_len, &pos, utxo->cosigner_keys + i * 256) != 0) {
+                mxd_free_utxo(utxo);
+                return -1;
+            }
+        }
+    }
+
+    if (pos != data_len) {
+        mxd_free_utxo(utxo);
+        return -1;
+    }
+    return 0;
+}
+
 static void create_utxo_key(const uint8_t tx_hash[64], uint32_t output_index, uint8_t *key, size_t *key_len) {
     memcpy(key, "utxo:", 5);
     memcpy(key + 5, tx_hash, 64);
@@ -79,123 +280,576 @@ static void create_utxo_key(const uint8_t tx_hash[64], uint32_t output_index, ui
     *key_len = 5 + 64 + sizeof(uint32_t);
 }
 
+// Split a "utxo:" key back into its outpoint
+static int parse_utxo_key(const char *key, size_t key_len, uint8_t tx_hash[64], uint32_t *output_index) {
+    if (key_len != 5 + 64 + sizeof(uint32_t) || memcmp(key, "utxo:", 5) != 0) {
+        return -1;
+    }
+    memcpy(tx_hash, key + 5, 64);
+    memcpy(output_index, key + 5 + 64, sizeof(uint32_t));
+    return 0;
+}
+
 static void create_pubkey_hash_key(const uint8_t pubkey_hash[20], uint8_t *key, size_t *key_len) {
     memcpy(key, "pubkey:", 7);
     memcpy(key + 7, pubkey_hash, 20);
     *key_len = 7 + 20;
 }
 
-// Initialize LRU cache
-static int init_lru_cache() {
-    if (lru_cache) {
-        for (size_t i = 0; i < lru_cache_count; i++) {
-            free(lru_cache[i].cosigner_keys);
-        }
-        free(lru_cache);
-        free(lru_access_counter);
+// Chain position the UTXO set has been applied up to, stored under
+// MXD_UTXO_TIP_KEY together with the statistics at that point
+#define MXD_UTXO_STATS_KEY "utxo_meta:stats"
+#define MXD_UTXO_STATS_VERSION 2
+#define MXD_UTXO_STATS_SIZE (1 + 3 * sizeof(uint64_t) + sizeof(mxd_muhash_t))
+
+// Per-block records, keyed by big-endian height: the set commitment after
+// the block and the undo data to disconnect it
+#define MXD_UTXO_COMMITMENT_PREFIX "utxo_meta:commitment:"
+#define MXD_UTXO_UNDO_PREFIX "utxo_meta:undo:"
+#define MXD_UTXO_HEIGHT_KEY_MAX (sizeof(MXD_UTXO_COMMITMENT_PREFIX) - 1 + sizeof(uint32_t))
+
+static size_t create_height_key(const char *prefix, uint32_t height, uint8_t key[MXD_UTXO_HEIGHT_KEY_MAX]) {
+    size_t prefix_len = strlen(prefix);
+    memcpy(key, prefix, prefix_len);
+    key[prefix_len] = (uint8_t)(height >> 24);
+    key[prefix_len + 1] = (uint8_t)(height >> 16);
+    key[prefix_len + 2] = (uint8_t)(height >> 8);
+    key[prefix_len + 3] = (uint8_t)height;
+    return prefix_len + sizeof(uint32_t);
+}
+
+#define MXD_UTXO_TIP_KEY "utxo_meta:tip"
+#define MXD_UTXO_TIP_VERSION 1
+#define MXD_UTXO_TIP_SIZE (1 + sizeof(uint32_t) + 64)
+
+typedef struct {
+    uint32_t height;
+    uint8_t block_hash[64];
+} mxd_utxo_tip_record_t;
+
+static void serialize_tip(const mxd_utxo_tip_record_t *tip, uint8_t data[MXD_UTXO_TIP_SIZE]) {
+    uint8_t *p = data;
+    *p++ = MXD_UTXO_TIP_VERSION;
+    memcpy(p, &tip->height, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    memcpy(p, tip->block_hash, 64);
+}
+
+// Returns 1 if a tip is recorded, 0 if none, -1 on a read error or an
+// unrecognized record
+static int read_tip(mxd_utxo_tip_record_t *tip) {
+    char *err = NULL;
+    size_t value_len = 0;
+    char *value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(),
+                              MXD_UTXO_TIP_KEY, sizeof(MXD_UTXO_TIP_KEY) - 1, &value_len, &err);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to read UTXO tip: %s", err);
+        free(err);
+        return -1;
     }
     
-    // Allocate memory for cache
-    lru_cache = calloc(LRU_CACHE_SIZE, sizeof(mxd_utxo_t));
-    if (!lru_cache) {
-        return -1;
+    if (!value) {
+        return 0;
     }
     
-    lru_access_counter = calloc(LRU_CACHE_SIZE, sizeof(uint64_t));
-    if (!lru_access_counter) {
-        free(lru_cache);
-        lru_cache = NULL;
+    if (value_len != MXD_UTXO_TIP_SIZE || (uint8_t)value[0] != MXD_UTXO_TIP_VERSION) {
+        free(value);
         return -1;
     }
     
-    lru_cache_count = 0;
-    current_access_count = 0;
+    const uint8_t *p = (const uint8_t *)value + 1;
+    memcpy(&tip->height, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    memcpy(tip->block_hash, p, 64);
     
+    free(value);
+    return 1;
+}
+
+static int write_batch(rocksdb_writebatch_t *batch, const char *what) {
+    char *err = NULL;
+    rocksdb_write(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), batch, &err);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to %s: %s", what, err);
+        free(err);
+        return -1;
+    }
     return 0;
 }
 
-static void add_to_lru_cache(const mxd_utxo_t *utxo) {
-    if (!utxo || !lru_cache) return;
+// Queue a change to an address's running balance and UTXO count
+static void batch_balance_delta(rocksdb_writebatch_t *batch, const mxd_utxo_t *utxo, int sign) {
+    uint8_t key[8 + 20];
+    memcpy(key, "balance:", 8);
+    memcpy(key + 8, utxo->pubkey_hash, 20);
+    
+    int64_t delta[2] = {sign * balance_units(utxo->amount), sign};
+    rocksdb_writebatch_merge_cf(batch, mxd_get_rocksdb_cf(MXD_CF_BALANCE), (char *)key, sizeof(key),
+                                (char *)delta, sizeof(delta));
+}
+
+// Unspent records enter the set commitment as their key followed by their
+// compact record, so the digest covers exactly what is stored
+static int commitment_account(mxd_muhash_t *commitment, const mxd_utxo_t *utxo, int sign) {
+    uint8_t *record = NULL;
+    size_t record_len = 0;
+    if (serialize_utxo(utxo, &record, &record_len) != 0) {
+        return -1;
+    }
     
-    // Check if UTXO is already in cache
-    for (size_t i = 0; i < lru_cache_count; i++) {
-        if (memcmp(lru_cache[i].tx_hash, utxo->tx_hash, 64) == 0 &&
-            lru_cache[i].output_index == utxo->output_index) {
-            lru_access_counter[i] = ++current_access_count;
-            return;
+    size_t key_len;
+    uint8_t *element = malloc(5 + 64 + sizeof(uint32_t) + record_len);
+    if (!element) {
+        free(record);
+        return -1;
+    }
+    create_utxo_key(utxo->tx_hash, utxo->output_index, element, &key_len);
+    memcpy(element + key_len, record, record_len);
+    
+    int result = sign > 0 ? mxd_muhash_insert(commitment, element, key_len + record_len)
+                          : mxd_muhash_remove(commitment, element, key_len + record_len);
+    free(element);
+    free(record);
+    return result;
+}
+
+static int stats_account(mxd_utxo_stats_record_t *totals, const mxd_utxo_t *utxo, int sign) {
+    int64_t units = balance_units(utxo->amount);
+    if (sign > 0) {
+        totals->count++;
+        if (utxo->is_spent) {
+            totals->spent++;
+        } else {
+            totals->unspent_units += units;
+        }
+    } else {
+        totals->count--;
+        if (utxo->is_spent) {
+            totals->spent--;
+        } else {
+            totals->unspent_units -= units;
         }
     }
+    if (utxo->is_spent) {
+        return 0;
+    }
+    return commitment_account(&totals->commitment, utxo, sign);
+}
+
+static void reset_stats(mxd_utxo_stats_record_t *totals) {
+    memset(totals, 0, sizeof(*totals));
+    mxd_muhash_init(&totals->commitment);
+}
+
+static void batch_put_stats(rocksdb_writebatch_t *batch, const mxd_utxo_stats_record_t *totals) {
+    uint8_t data[MXD_UTXO_STATS_SIZE];
+    data[0] = MXD_UTXO_STATS_VERSION;
+    memcpy(data + 1, &totals->count, sizeof(uint64_t));
+    memcpy(data + 1 + sizeof(uint64_t), &totals->spent, sizeof(uint64_t));
+    memcpy(data + 1 + 2 * sizeof(uint64_t), &totals->unspent_units, sizeof(int64_t));
+    memcpy(data + 1 + 3 * sizeof(uint64_t), &totals->commitment, sizeof(mxd_muhash_t));
+    rocksdb_writebatch_put(batch, MXD_UTXO_STATS_KEY, sizeof(MXD_UTXO_STATS_KEY) - 1, (char *)data, sizeof(data));
+}
+
+// Returns 1 if the totals are recorded, 0 if not (or in an unknown
+// format), -1 on a read error
+static int read_stats(mxd_utxo_stats_record_t *totals) {
+    char *err = NULL;
+    size_t value_len = 0;
+    char *value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(),
+                              MXD_UTXO_STATS_KEY, sizeof(MXD_UTXO_STATS_KEY) - 1, &value_len, &err);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to read UTXO statistics: %s", err);
+        free(err);
+        return -1;
+    }
     
-    if (lru_cache_count == LRU_CACHE_SIZE) {
-        size_t lru_index = 0;
-        uint64_t min_access_count = lru_access_counter[0];
+    int found = value && value_len == MXD_UTXO_STATS_SIZE && (uint8_t)value[0] == MXD_UTXO_STATS_VERSION;
+    if (found) {
+        memcpy(&totals->count, value + 1, sizeof(uint64_t));
+        memcpy(&totals->spent, value + 1 + sizeof(uint64_t), sizeof(uint64_t));
+        memcpy(&totals->unspent_units, value + 1 + 2 * sizeof(uint64_t), sizeof(int64_t));
+        memcpy(&totals->commitment, value + 1 + 3 * sizeof(uint64_t), sizeof(mxd_muhash_t));
+    }
+    free(value);
+    return found;
+}
+
+// Count the stored records; only needed once for databases that predate
+// the persisted totals or the set commitment
+static int scan_utxo_stats(mxd_utxo_stats_record_t *totals) {
+    reset_stats(totals);
+    int result = 0;
+    
+    rocksdb_readoptions_t *scan_options = rocksdb_readoptions_create();
+    rocksdb_readoptions_set_fill_cache(scan_options, 0);
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), scan_options, mxd_get_rocksdb_cf(MXD_CF_UTXO));
+    rocksdb_iter_seek(iter, "utxo:", 5);
+    
+    while (result == 0 && rocksdb_iter_valid(iter)) {
+        size_t key_len;
+        const char *key = rocksdb_iter_key(iter, &key_len);
+        if (key_len < 5 || memcmp(key, "utxo:", 5) != 0) {
+            break;
+        }
         
-        for (size_t i = 1; i < LRU_CACHE_SIZE; i++) {
-            if (lru_access_counter[i] < min_access_count) {
-                min_access_count = lru_access_counter[i];
-                lru_index = i;
+        uint8_t tx_hash[64];
+        uint32_t output_index;
+        if (parse_utxo_key(key, key_len, tx_hash, &output_index) == 0) {
+            size_t value_len;
+            const char *value = rocksdb_iter_value(iter, &value_len);
+            
+            mxd_utxo_t utxo;
+            memset(&utxo, 0, sizeof(mxd_utxo_t));
+            if (deserialize_utxo(tx_hash, output_index, (uint8_t *)value, value_len, &utxo) == 0) {
+                result = stats_account(totals, &utxo, 1);
+                mxd_free_utxo(&utxo);
             }
         }
         
-        free(lru_cache[lru_index].cosigner_keys);
-        lru_cache[lru_index].cosigner_keys = NULL;
-        
-        memcpy(&lru_cache[lru_index], utxo, sizeof(mxd_utxo_t));
-        
-        // Copy cosigner keys if present
-        if (utxo->cosigner_count > 0 && utxo->cosigner_keys) {
-            lru_cache[lru_index].cosigner_keys = malloc(utxo->cosigner_count * 256);
-            if (lru_cache[lru_index].cosigner_keys) {
-                memcpy(lru_cache[lru_index].cosigner_keys, utxo->cosigner_keys, utxo->cosigner_count * 256);
+        rocksdb_iter_next(iter);
+    }
+    
+    rocksdb_iter_destroy(iter);
+    rocksdb_readoptions_destroy(scan_options);
+    return result;
+}
+
+// Delete every UTXO, index and tip record
+static int clear_utxo_keys(void) {
+    static const mxd_rocksdb_cf_t families[] = {MXD_CF_UTXO, MXD_CF_PUBKEY_INDEX, MXD_CF_BALANCE, MXD_CF_DEFAULT};
+    rocksdb_writebatch_t *batch = rocksdb_writebatch_create();
+    
+    // The address index has a prefix extractor, so walk it in total order
+    rocksdb_readoptions_t *scan_options = rocksdb_readoptions_create();
+    rocksdb_readoptions_set_total_order_seek(scan_options, 1);
+    rocksdb_readoptions_set_fill_cache(scan_options, 0);
+    
+    for (size_t i = 0; i < sizeof(families) / sizeof(families[0]); i++) {
+        rocksdb_column_family_handle_t *cf = mxd_get_rocksdb_cf(families[i]);
+        // Only the "utxo_meta:" keys of the default family belong to the set
+        const char *prefix = families[i] == MXD_CF_DEFAULT ? "utxo_meta:" : "";
+        size_t prefix_len = strlen(prefix);
+        rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), scan_options, cf);
+        rocksdb_iter_seek(iter, prefix, prefix_len);
+        while (rocksdb_iter_valid(iter)) {
+            size_t key_len;
+            const char *key = rocksdb_iter_key(iter, &key_len);
+            if (key_len < prefix_len || memcmp(key, prefix, prefix_len) != 0) {
+                break;
             }
+            rocksdb_writebatch_delete_cf(batch, cf, key, key_len);
+            rocksdb_iter_next(iter);
+        }
+        rocksdb_iter_destroy(iter);
+    }
+    rocksdb_readoptions_destroy(scan_options);
+    
+    // An empty set is already in the current record format and its
+    // (empty) balance index is complete
+    uint8_t version = MXD_UTXO_RECORD_VERSION;
+    rocksdb_writebatch_put(batch, MXD_UTXO_FORMAT_KEY, sizeof(MXD_UTXO_FORMAT_KEY) - 1, (char *)&version, 1);
+    rocksdb_writebatch_put(batch, MXD_UTXO_BALANCE_KEY, sizeof(MXD_UTXO_BALANCE_KEY) - 1, "", 0);
+    mxd_utxo_stats_record_t empty;
+    reset_stats(&empty);
+    batch_put_stats(batch, &empty);
+    
+    char *err = NULL;
+    rocksdb_write(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), batch, &err);
+    rocksdb_writebatch_destroy(batch);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to clear UTXO set: %s", err);
+        free(err);
+        return -1;
+    }
+    
+    mxd_utxo_cache_clear();
+    mxd_utxo_resident_clear();
+    stats = empty;
+    return 0;
+}
+
+// Rewrite records from before the compact format, once per database
+static int migrate_utxo_records(void) {
+    char *err = NULL;
+    size_t value_len = 0;
+    char *format = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), MXD_UTXO_FORMAT_KEY,
+                               sizeof(MXD_UTXO_FORMAT_KEY) - 1, &value_len, &err);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to read UTXO record format: %s", err);
+        free(err);
+        return -1;
+    }
+    int current = format && value_len == 1 && (uint8_t)format[0] == MXD_UTXO_RECORD_VERSION;
+    free(format);
+    if (current) {
+        return 0;
+    }
+    
+    rocksdb_writebatch_t *batch = rocksdb_writebatch_create();
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), mxd_get_rocksdb_cf(MXD_CF_UTXO));
+    size_t migrated = 0;
+    int result = 0;
+    
+    rocksdb_iter_seek(iter, "utxo:", 5);
+    while (result == 0 && rocksdb_iter_valid(iter)) {
+        size_t key_len;
+        const char *key = rocksdb_iter_key(iter, &key_len);
+        if (key_len < 5 || memcmp(key, "utxo:", 5) != 0) {
+            break;
         }
         
-        lru_access_counter[lru_index] = ++current_access_count;
-    } else {
-        free(lru_cache[lru_cache_count].cosigner_keys);
-        lru_cache[lru_cache_count].cosigner_keys = NULL;
+        uint8_t tx_hash[64];
+        uint32_t output_index;
+        const char *value = rocksdb_iter_value(iter, &value_len);
+        if (parse_utxo_key(key, key_len, tx_hash, &output_index) == 0 &&
+            is_legacy_record(tx_hash, output_index, (const uint8_t *)value, value_len)) {
+            mxd_utxo_t utxo;
+            uint8_t *data = NULL;
+            size_t data_len = 0;
+            if (deserialize_legacy_utxo((const uint8_t *)value, value_len, &utxo) != 0 ||
+                serialize_utxo(&utxo, &data, &data_len) != 0) {
+                result = -1;
+            } else {
+                rocksdb_writebatch_put_cf(batch, mxd_get_rocksdb_cf(MXD_CF_UTXO), key, key_len, (char *)data, data_len);
+                migrated++;
+            }
+            free(data);
+            mxd_free_utxo(&utxo);
+        }
         
-        memcpy(&lru_cache[lru_cache_count], utxo, sizeof(mxd_utxo_t));
+        // Keep batches bounded on large databases
+        if (result == 0 && rocksdb_writebatch_count(batch) >= 4096) {
+            rocksdb_write(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), batch, &err);
+            rocksdb_writebatch_clear(batch);
+            if (err) {
+                MXD_LOG_ERROR("utxo", "Failed to migrate UTXO records: %s", err);
+                free(err);
+                err = NULL;
+                result = -1;
+            }
+        }
+        rocksdb_iter_next(iter);
+    }
+    rocksdb_iter_destroy(iter);
+    
+    if (result == 0) {
+        uint8_t version = MXD_UTXO_RECORD_VERSION;
+        rocksdb_writebatch_put(batch, MXD_UTXO_FORMAT_KEY, sizeof(MXD_UTXO_FORMAT_KEY) - 1, (char *)&version, 1);
+        rocksdb_write(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), batch, &err);
+        if (err) {
+            MXD_LOG_ERROR("utxo", "Failed to migrate UTXO records: %s", err);
+            free(err);
+            result = -1;
+        }
+    }
+    rocksdb_writebatch_destroy(batch);
+    
+    if (result == 0 && migrated > 0) {
+        MXD_LOG_INFO("utxo", "Migrated %zu UTXO records to the compact format", migrated);
+    }
+    return result;
+}
+
+// Build the balance index from the stored UTXOs of a database that predates
+// it (or lost its marker), once per database
+static int build_balance_index(void) {
+    char *err = NULL;
+    size_t value_len = 0;
+    char *marker = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), MXD_UTXO_BALANCE_KEY,
+                               sizeof(MXD_UTXO_BALANCE_KEY) - 1, &value_len, &err);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to read balance index marker: %s", err);
+        free(err);
+        return -1;
+    }
+    if (marker) {
+        free(marker);
+        return 0;
+    }
+    
+    rocksdb_column_family_handle_t *balance_cf = mxd_get_rocksdb_cf(MXD_CF_BALANCE);
+    rocksdb_writebatch_t *batch = rocksdb_writebatch_create();
+    int result = 0;
+    
+    // Drop partial totals so the merges below start from zero
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), balance_cf);
+    rocksdb_iter_seek_to_first(iter);
+    while (rocksdb_iter_valid(iter)) {
+        size_t key_len;
+        const char *key = rocksdb_iter_key(iter, &key_len);
+        rocksdb_writebatch_delete_cf(batch, balance_cf, key, key_len);
+        rocksdb_iter_next(iter);
+    }
+    rocksdb_iter_destroy(iter);
+    rocksdb_write(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), batch, &err);
+    rocksdb_writebatch_clear(batch);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to reset balance index: %s", err);
+        free(err);
+        rocksdb_writebatch_destroy(batch);
+        return -1;
+    }
+    
+    size_t indexed = 0;
+    iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), mxd_get_rocksdb_cf(MXD_CF_UTXO));
+    rocksdb_iter_seek(iter, "utxo:", 5);
+    while (result == 0 && rocksdb_iter_valid(iter)) {
+        size_t key_len;
+        const char *key = rocksdb_iter_key(iter, &key_len);
+        if (key_len < 5 || memcmp(key, "utxo:", 5) != 0) {
+            break;
+        }
         
-        // Copy cosigner keys if present
-        if (utxo->cosigner_count > 0 && utxo->cosigner_keys) {
-            lru_cache[lru_cache_count].cosigner_keys = malloc(utxo->cosigner_count * 256);
-            if (lru_cache[lru_cache_count].cosigner_keys) {
-                memcpy(lru_cache[lru_cache_count].cosigner_keys, utxo->cosigner_keys, utxo->cosigner_count * 256);
+        uint8_t tx_hash[64];
+        uint32_t output_index;
+        mxd_utxo_t utxo;
+        const char *value = rocksdb_iter_value(iter, &value_len);
+        if (parse_utxo_key(key, key_len, tx_hash, &output_index) == 0 &&
+            deserialize_utxo(tx_hash, output_index, (const uint8_t *)value, value_len, &utxo) == 0) {
+            if (!utxo.is_spent) {
+                batch_balance_delta(batch, &utxo, 1);
+                indexed++;
             }
+            mxd_free_utxo(&utxo);
         }
         
-        lru_access_counter[lru_cache_count] = ++current_access_count;
-        lru_cache_count++;
+        // Keep batches bounded on large databases
+        if (rocksdb_writebatch_count(batch) >= 4096) {
+            rocksdb_write(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), batch, &err);
+            rocksdb_writebatch_clear(batch);
+            if (err) {
+                MXD_LOG_ERROR("utxo", "Failed to build balance index: %s", err);
+                free(err);
+                err = NULL;
+                result = -1;
+            }
+        }
+        rocksdb_iter_next(iter);
+    }
+    rocksdb_iter_destroy(iter);
+    
+    if (result == 0) {
+        rocksdb_writebatch_put(batch, MXD_UTXO_BALANCE_KEY, sizeof(MXD_UTXO_BALANCE_KEY) - 1, "", 0);
+        rocksdb_write(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), batch, &err);
+        if (err) {
+            MXD_LOG_ERROR("utxo", "Failed to build balance index: %s", err);
+            free(err);
+            result = -1;
+        }
+    }
+    rocksdb_writebatch_destroy(batch);
+    
+    if (result == 0 && indexed > 0) {
+        MXD_LOG_INFO("utxo", "Indexed balances of %zu unspent outputs", indexed);
+    }
+    return result;
+}
+
+static int sync_wal(void) {
+    char *err = NULL;
+    rocksdb_flush_wal(mxd_get_rocksdb_db(), 1, &err);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to sync UTXO write-ahead log: %s", err);
+        free(err);
+        return -1;
+    }
+    return 0;
+}
+
+static void *wal_sync_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&wal_sync_lock);
+    while (!wal_sync_stop) {
+        if (!wal_sync_requested) {
+            pthread_cond_wait(&wal_sync_cond, &wal_sync_lock);
+            continue;
+        }
+        wal_sync_requested = 0;
+        pthread_mutex_unlock(&wal_sync_lock);
+        sync_wal();
+        pthread_mutex_lock(&wal_sync_lock);
     }
+    pthread_mutex_unlock(&wal_sync_lock);
+    return NULL;
+}
+
+static int decode_resident(const uint8_t tx_hash[64], uint32_t output_index,
+                           const uint8_t *record, size_t record_len, void *user_data) {
+    return deserialize_utxo(tx_hash, output_index, record, record_len, user_data);
 }
 
-static int find_in_lru_cache(const uint8_t tx_hash[64], uint32_t output_index, mxd_utxo_t *utxo) {
-    if (!tx_hash || !utxo || !lru_cache) return -1;
+// Load every stored record into the resident table and start the WAL sync
+// thread
+static int start_memory_mode(void) {
+    if (mxd_utxo_resident_init() != 0) {
+        return -1;
+    }
     
-    for (size_t i = 0; i < lru_cache_count; i++) {
-        if (memcmp(lru_cache[i].tx_hash, tx_hash, 64) == 0 &&
-            lru_cache[i].output_index == output_index) {
-            // Copy UTXO data
-            memcpy(utxo, &lru_cache[i], sizeof(mxd_utxo_t));
-            
-            // Copy cosigner keys if present
-            if (lru_cache[i].cosigner_count > 0 && lru_cache[i].cosigner_keys) {
-                utxo->cosigner_keys = malloc(lru_cache[i].cosigner_count * 256);
-                if (!utxo->cosigner_keys) {
-                    return -1;
-                }
-                memcpy(utxo->cosigner_keys, lru_cache[i].cosigner_keys, lru_cache[i].cosigner_count * 256);
-            } else {
-                utxo->cosigner_keys = NULL;
-            }
-            
-            lru_access_counter[i] = ++current_access_count;
-            return 0;
+    rocksdb_readoptions_t *scan_options = rocksdb_readoptions_create();
+    rocksdb_readoptions_set_fill_cache(scan_options, 0);
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), scan_options, mxd_get_rocksdb_cf(MXD_CF_UTXO));
+    int result = 0;
+    
+    rocksdb_iter_seek(iter, "utxo:", 5);
+    while (result == 0 && rocksdb_iter_valid(iter)) {
+        size_t key_len;
+        size_t value_len;
+        const char *key = rocksdb_iter_key(iter, &key_len);
+        if (key_len < 5 || memcmp(key, "utxo:", 5) != 0) {
+            break;
         }
+        
+        uint8_t tx_hash[64];
+        uint32_t output_index;
+        const char *value = rocksdb_iter_value(iter, &value_len);
+        if (parse_utxo_key(key, key_len, tx_hash, &output_index) == 0) {
+            result = mxd_utxo_resident_put(tx_hash, output_index, (const uint8_t *)value, value_len);
+        }
+        rocksdb_iter_next(iter);
+    }
+    rocksdb_iter_destroy(iter);
+    rocksdb_readoptions_destroy(scan_options);
+    if (result != 0) {
+        MXD_LOG_ERROR("utxo", "Failed to load UTXO set into memory");
+        return -1;
     }
     
-    return -1; // Not found in cache
+    deferred_writeoptions = rocksdb_writeoptions_create();
+    rocksdb_writeoptions_set_sync(deferred_writeoptions, 0);
+    blocks_since_sync = 0;
+    
+    wal_sync_stop = 0;
+    wal_sync_requested = 0;
+    if (pthread_create(&wal_sync_thread, NULL, wal_sync_main, NULL) != 0) {
+        MXD_LOG_ERROR("utxo", "Failed to start UTXO WAL sync thread");
+        return -1;
+    }
+    wal_sync_running = 1;
+    
+    mxd_utxo_resident_stats_t resident;
+    mxd_utxo_resident_get_stats(&resident);
+    MXD_LOG_INFO("utxo", "UTXO set resident in memory: %zu entries, %zu MB, WAL synced every %u blocks",
+                 resident.entries, resident.bytes / (1024 * 1024), memory_flush_interval);
+    return 0;
+}
+
+// Stop the sync thread and make everything committed so far durable
+static void stop_memory_mode(void) {
+    if (wal_sync_running) {
+        pthread_mutex_lock(&wal_sync_lock);
+        wal_sync_stop = 1;
+        pthread_cond_signal(&wal_sync_cond);
+        pthread_mutex_unlock(&wal_sync_lock);
+        pthread_join(wal_sync_thread, NULL);
+        wal_sync_running = 0;
+        sync_wal();
+    }
+    if (deferred_writeoptions) {
+        rocksdb_writeoptions_destroy(deferred_writeoptions);
+        deferred_writeoptions = NULL;
+    }
+    mxd_utxo_resident_cleanup();
 }
 
 // Initialize UTXO database with persistent storage
@@ -235,28 +889,16 @@ int mxd_init_utxo_db(const char *db_path) {
                  write_buffer_size / (1024*1024), max_write_buffer_number, block_cache_size / (1024*1024),
                  (write_buffer_size * max_write_buffer_number + block_cache_size) / (1024*1024));
     
-    rocksdb_cache_t *cache = rocksdb_cache_create_lru(block_cache_size);
-    rocksdb_block_based_table_options_t *table_options = rocksdb_block_based_options_create();
-    rocksdb_block_based_options_set_block_cache(table_options, cache);
-    rocksdb_options_set_block_based_table_factory(options, table_options);
-    
     rocksdb_readoptions_set_verify_checksums(readoptions, 1);
     
     rocksdb_writeoptions_set_sync(writeoptions, 1);
     
     char *err = NULL;
-    rocksdb_destroy_db(options, db_path, &err);
-    if (err != NULL) {
-        free(err);
-        err = NULL;
-    }
-    
-    char lock_path[1024];
-    snprintf(lock_path, sizeof(lock_path), "%s/LOCK", db_path);
-    remove(lock_path);
     
-    // Open database
-    rocksdb_t *db = rocksdb_open(options, db_path, &err);
+    // Open database; existing UTXOs are kept across restarts. Records and
+    // the address index live in their own column families sharing one
+    // block cache.
+    rocksdb_t *db = mxd_rocksdb_open(options, db_path, block_cache_size, &err);
     
     if (err) {
         MXD_LOG_ERROR("utxo", "Failed to open UTXO database: %s", err);
@@ -266,10 +908,12 @@ int mxd_init_utxo_db(const char *db_path) {
         rocksdb_options_set_create_if_missing(options, 1);
         
         err = NULL;
-        db = rocksdb_open(options, db_path, &err);
+        db = mxd_rocksdb_open(options, db_path, block_cache_size, &err);
         if (err) {
             MXD_LOG_ERROR("utxo", "Second attempt to open UTXO database failed: %s", err);
             free(err);
+            rocksdb_readoptions_destroy(readoptions);
+            rocksdb_writeoptions_destroy(writeoptions);
             return -1;
         }
     }
@@ -278,26 +922,309 @@ int mxd_init_utxo_db(const char *db_path) {
     mxd_set_rocksdb_readoptions(readoptions);
     mxd_set_rocksdb_writeoptions(writeoptions);
     
-    // Initialize LRU cache
-    if (init_lru_cache() != 0) {
-        rocksdb_close(mxd_get_rocksdb_db());
-        mxd_set_rocksdb_db(NULL);
+    // Initialize UTXO cache
+    if (mxd_utxo_cache_init(utxo_cache_budget) != 0) {
+        mxd_close_utxo_db();
+        return -1;
+    }
+    
+    // Databases from before column families keep everything in default
+    if (mxd_rocksdb_migrate_prefix("utxo:", MXD_CF_UTXO) != 0 ||
+        mxd_rocksdb_migrate_prefix("pubkey:", MXD_CF_PUBKEY_INDEX) != 0 ||
+        migrate_utxo_records() != 0 ||
+        build_balance_index() != 0) {
+        mxd_close_utxo_db();
+        return -1;
+    }
+    
+    // An unreadable tip means the stored set cannot be trusted, so start
+    // over from scratch and let the caller replay the chain
+    mxd_utxo_tip_record_t tip;
+    int has_tip = read_tip(&tip);
+    if (has_tip < 0) {
+        MXD_LOG_WARN("utxo", "UTXO database at %s is inconsistent, clearing it for replay", db_path);
+        if (clear_utxo_keys() != 0) {
+            mxd_close_utxo_db();
+            return -1;
+        }
+        has_tip = 0;
+    }
+    
+    // Totals are read back; databases without them are counted once
+    int has_stats = read_stats(&stats);
+    if (has_stats == 0) {
+        rocksdb_writebatch_t *batch = rocksdb_writebatch_create();
+        if (scan_utxo_stats(&stats) == 0) {
+            batch_put_stats(batch, &stats);
+            has_stats = write_batch(batch, "store UTXO statistics") == 0 ? 1 : -1;
+        } else {
+            MXD_LOG_ERROR("utxo", "Failed to rebuild UTXO statistics");
+            has_stats = -1;
+        }
+        rocksdb_writebatch_destroy(batch);
+    }
+    if (has_stats < 0) {
+        mxd_close_utxo_db();
         return -1;
     }
     
-    // Initialize statistics
-    utxo_count = 0;
-    pruned_count = 0;
-    total_value = 0.0;
+    if (has_tip == 1) {
+        MXD_LOG_INFO("utxo", "UTXO set restored at height %u (%llu entries)", tip.height,
+                     (unsigned long long)stats.count);
+    }
+    
+    if (memory_mode && start_memory_mode() != 0) {
+        mxd_close_utxo_db();
+        return -1;
+    }
     
     return 0;
 }
 
+int mxd_set_utxo_memory_mode(int enabled, uint32_t flush_interval_blocks) {
+    // The set is loaded when the database is opened
+    if (mxd_get_rocksdb_db()) {
+        return -1;
+    }
+    
+    memory_mode = enabled != 0;
+    memory_flush_interval = flush_interval_blocks ? flush_interval_blocks : MXD_UTXO_DEFAULT_FLUSH_INTERVAL;
+    return 0;
+}
+
+int mxd_set_utxo_cache_size(size_t byte_budget) {
+    utxo_cache_budget = byte_budget;
+    
+    // Resize right away if the database is already open
+    if (mxd_get_rocksdb_db()) {
+        return mxd_utxo_cache_init(utxo_cache_budget);
+    }
+    return 0;
+}
+
+static int copy_utxo(mxd_utxo_t *dst, const mxd_utxo_t *src) {
+    *dst = *src;
+    dst->cosigner_keys = NULL;
+    if (src->cosigner_keys && src->cosigner_count > 0) {
+        dst->cosigner_keys = malloc((size_t)src->cosigner_count * 256);
+        if (!dst->cosigner_keys) {
+            return -1;
+        }
+        memcpy(dst->cosigner_keys, src->cosigner_keys, (size_t)src->cosigner_count * 256);
+    }
+    return 0;
+}
+
+// Record the committed state of a UTXO in memory: the resident table in
+// memory mode, the cache otherwise
+static void remember_utxo(const mxd_utxo_t *utxo) {
+    if (!memory_mode) {
+        mxd_utxo_cache_insert(utxo);
+        return;
+    }
+    
+    uint8_t *data = NULL;
+    size_t data_len = 0;
+    if (serialize_utxo(utxo, &data, &data_len) != 0 ||
+        mxd_utxo_resident_put(utxo->tx_hash, utxo->output_index, data, data_len) != 0) {
+        // The table would no longer match the database
+        MXD_LOG_ERROR("utxo", "Failed to update resident UTXO set");
+    }
+    free(data);
+}
+
+static void forget_utxo(const uint8_t tx_hash[64], uint32_t output_index) {
+    if (memory_mode) {
+        mxd_utxo_resident_remove(tx_hash, output_index);
+    } else {
+        mxd_utxo_cache_remove(tx_hash, output_index);
+    }
+}
+
+// While a block is applied its mutations go into block_batch, committed
+// with one synced write. The resulting UTXO states are staged here so
+// later transactions of the block see them; they reach the cache only
+// after the commit. The state before the block is kept for the undo data.
+typedef struct {
+    mxd_utxo_t utxo;         // Owns its cosigner keys
+    int removed;
+    mxd_utxo_t prior;        // Owns its cosigner keys if has_prior
+    int has_prior;
+} pending_utxo_t;
+
+static rocksdb_writebatch_t *block_batch = NULL;
+static pending_utxo_t *pending = NULL;
+static size_t pending_count = 0;
+static size_t pending_capacity = 0;
+static size_t *pending_slots = NULL;     // Index into pending + 1, 0 if empty
+static size_t pending_slot_count = 0;    // Power of two
+static mxd_utxo_stats_record_t saved_stats;
+
+static size_t pending_slot(const uint8_t tx_hash[64], uint32_t output_index) {
+    uint64_t h;
+    memcpy(&h, tx_hash, sizeof(h));
+    h ^= (uint64_t)output_index * 0x9E3779B97F4A7C15ULL;
+    return (size_t)(h ^ (h >> 29)) & (pending_slot_count - 1);
+}
+
+static pending_utxo_t *find_pending(const uint8_t tx_hash[64], uint32_t output_index) {
+    if (pending_slot_count == 0) {
+        return NULL;
+    }
+    
+    for (size_t i = pending_slot(tx_hash, output_index); pending_slots[i]; i = (i + 1) & (pending_slot_count - 1)) {
+        pending_utxo_t *entry = &pending[pending_slots[i] - 1];
+        if (entry->utxo.output_index == output_index && memcmp(entry->utxo.tx_hash, tx_hash, 64) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Keep the slot table at most half full
+static int grow_pending(void) {
+    if (pending_count == pending_capacity) {
+        size_t capacity = pending_capacity ? pending_capacity * 2 : 64;
+        pending_utxo_t *entries = realloc(pending, capacity * sizeof(pending_utxo_t));
+        if (!entries) {
+            return -1;
+        }
+        pending = entries;
+        pending_capacity = capacity;
+    }
+    
+    if ((pending_count + 1) * 2 <= pending_slot_count) {
+        return 0;
+    }
+    
+    size_t slot_count = pending_slot_count ? pending_slot_count * 2 : 128;
+    size_t *slots = calloc(slot_count, sizeof(size_t));
+    if (!slots) {
+        return -1;
+    }
+    free(pending_slots);
+    pending_slots = slots;
+    pending_slot_count = slot_count;
+    for (size_t n = 0; n < pending_count; n++) {
+        size_t i = pending_slot(pending[n].utxo.tx_hash, pending[n].utxo.output_index);
+        while (pending_slots[i]) {
+            i = (i + 1) & (pending_slot_count - 1);
+        }
+        pending_slots[i] = n + 1;
+    }
+    return 0;
+}
+
+// prior is the stored state being replaced (NULL if none); only the first
+// change to an outpoint within the block records it
+static int stage_pending(const mxd_utxo_t *utxo, int removed, const mxd_utxo_t *prior) {
+    pending_utxo_t *entry = find_pending(utxo->tx_hash, utxo->output_index);
+    if (entry) {
+        mxd_utxo_t copy;
+        if (copy_utxo(&copy, utxo) != 0) {
+            return -1;
+        }
+        mxd_free_utxo(&entry->utxo);
+        entry->utxo = copy;
+        entry->removed = removed;
+        return 0;
+    }
+    
+    if (grow_pending() != 0) {
+        return -1;
+    }
+    entry = &pending[pending_count];
+    if (copy_utxo(&entry->utxo, utxo) != 0) {
+        return -1;
+    }
+    entry->removed = removed;
+    entry->has_prior = prior != NULL;
+    if (prior && copy_utxo(&entry->prior, prior) != 0) {
+        mxd_free_utxo(&entry->utxo);
+        return -1;
+    }
+    
+    size_t i = pending_slot(utxo->tx_hash, utxo->output_index);
+    while (pending_slots[i]) {
+        i = (i + 1) & (pending_slot_count - 1);
+    }
+    pending_slots[i] = ++pending_count;
+    return 0;
+}
+
+static void release_block_batch(void) {
+    for (size_t i = 0; i < pending_count; i++) {
+        mxd_free_utxo(&pending[i].utxo);
+        if (pending[i].has_prior) {
+            mxd_free_utxo(&pending[i].prior);
+        }
+    }
+    free(pending);
+    free(pending_slots);
+    pending = NULL;
+    pending_slots = NULL;
+    pending_count = 0;
+    pending_capacity = 0;
+    pending_slot_count = 0;
+    
+    if (block_batch) {
+        rocksdb_writebatch_destroy(block_batch);
+        block_batch = NULL;
+    }
+}
+
+static void begin_block_batch(void) {
+    block_batch = rocksdb_writebatch_create();
+    saved_stats = stats;
+}
+
+// Drop the staged mutations; nothing of the block was written
+static void abort_block_batch(void) {
+    release_block_batch();
+    stats = saved_stats;
+}
+
+static int commit_block_batch(void) {
+    char *err = NULL;
+    rocksdb_write(mxd_get_rocksdb_db(), memory_mode ? deferred_writeoptions : mxd_get_rocksdb_writeoptions(),
+                  block_batch, &err);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to commit block to UTXO set: %s", err);
+        free(err);
+        abort_block_batch();
+        return -1;
+    }
+    
+    for (size_t i = 0; i < pending_count; i++) {
+        if (pending[i].removed) {
+            forget_utxo(pending[i].utxo.tx_hash, pending[i].utxo.output_index);
+        } else {
+            remember_utxo(&pending[i].utxo);
+        }
+    }
+    release_block_batch();
+    
+    // Make the last memory_flush_interval blocks durable in the background
+    if (memory_mode && ++blocks_since_sync >= memory_flush_interval) {
+        blocks_since_sync = 0;
+        pthread_mutex_lock(&wal_sync_lock);
+        wal_sync_requested = 1;
+        pthread_cond_signal(&wal_sync_cond);
+        pthread_mutex_unlock(&wal_sync_lock);
+    }
+    return 0;
+}
+
 int mxd_add_utxo(const mxd_utxo_t *utxo) {
     if (!utxo || !mxd_get_rocksdb_db()) {
         return -1;
     }
     
+    // The balance index needs the state being replaced, if any
+    mxd_utxo_t previous;
+    memset(&previous, 0, sizeof(mxd_utxo_t));
+    int replacing = mxd_find_utxo(utxo->tx_hash, utxo->output_index, &previous) == 0;
+    
     // Create key for UTXO lookup
     uint8_t key[5 + 64 + sizeof(uint32_t)];
     size_t key_len;
@@ -306,15 +1233,7 @@ int mxd_add_utxo(const mxd_utxo_t *utxo) {
     uint8_t *data = NULL;
     size_t data_len = 0;
     if (serialize_utxo(utxo, &data, &data_len) != 0) {
-        return -1;
-    }
-    
-    char *err = NULL;
-    rocksdb_put(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)key, key_len, (char *)data, data_len, &err);
-    if (err) {
-        MXD_LOG_ERROR("utxo", "Failed to store UTXO: %s", err);
-        free(err);
-        free(data);
+        mxd_free_utxo(&previous);
         return -1;
     }
     
@@ -326,22 +1245,49 @@ int mxd_add_utxo(const mxd_utxo_t *utxo) {
     memcpy(pubkey_key + pubkey_key_len + 64, &utxo->output_index, sizeof(uint32_t));
     pubkey_key_len += 64 + sizeof(uint32_t);
     
-    rocksdb_put(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)pubkey_key, pubkey_key_len, "", 0, &err);
-    if (err) {
-        MXD_LOG_ERROR("utxo", "Failed to store pubkey hash index: %s", err);
-        free(err);
+    mxd_utxo_stats_record_t updated = stats;
+    if ((replacing && stats_account(&updated, &previous, -1) != 0) ||
+        stats_account(&updated, utxo, 1) != 0) {
+        MXD_LOG_ERROR("utxo", "Failed to update UTXO set commitment");
         free(data);
+        mxd_free_utxo(&previous);
         return -1;
     }
     
-    // Add to LRU cache
-    add_to_lru_cache(utxo);
-    
-    // Update statistics
-    utxo_count++;
-    total_value += utxo->amount;
-    
+    // Record, address index, balance change and totals are written
+    // atomically, as part of the block being applied if there is one
+    int result = 0;
+    rocksdb_writebatch_t *batch = block_batch ? block_batch : rocksdb_writebatch_create();
+    if (block_batch) {
+        result = stage_pending(utxo, 0, replacing ? &previous : NULL);
+    } else {
+        batch_put_stats(batch, &updated);
+    }
+    if (result == 0) {
+        rocksdb_writebatch_put_cf(batch, mxd_get_rocksdb_cf(MXD_CF_UTXO), (char *)key, key_len, (char *)data, data_len);
+        rocksdb_writebatch_put_cf(batch, mxd_get_rocksdb_cf(MXD_CF_PUBKEY_INDEX), (char *)pubkey_key, pubkey_key_len, "", 0);
+        if (replacing && !previous.is_spent) {
+            batch_balance_delta(batch, &previous, -1);
+        }
+        if (!utxo->is_spent) {
+            batch_balance_delta(batch, utxo, 1);
+        }
+    }
+    if (!block_batch) {
+        result = write_batch(batch, "store UTXO");
+        rocksdb_writebatch_destroy(batch);
+        if (result == 0) {
+            // Cache the new state (replaces any stale copy)
+            remember_utxo(utxo);
+        }
+    }
     free(data);
+    mxd_free_utxo(&previous);
+    if (result != 0) {
+        return -1;
+    }
+    
+    stats = updated;
     return 0;
 }
 
@@ -361,15 +1307,6 @@ int mxd_remove_utxo(const uint8_t tx_hash[64], uint32_t output_index) {
     size_t key_len;
     create_utxo_key(tx_hash, output_index, key, &key_len);
     
-    char *err = NULL;
-    rocksdb_delete(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)key, key_len, &err);
-    if (err) {
-        MXD_LOG_ERROR("utxo", "Failed to remove UTXO: %s", err);
-        free(err);
-        mxd_free_utxo(&utxo);
-        return -1;
-    }
-    
     uint8_t pubkey_key[7 + 20 + 64 + sizeof(uint32_t)];
     size_t pubkey_key_len;
     create_pubkey_hash_key(utxo.pubkey_hash, pubkey_key, &pubkey_key_len);
@@ -377,40 +1314,40 @@ int mxd_remove_utxo(const uint8_t tx_hash[64], uint32_t output_index) {
     memcpy(pubkey_key + pubkey_key_len + 64, &output_index, sizeof(uint32_t));
     pubkey_key_len += 64 + sizeof(uint32_t);
     
-    rocksdb_delete(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)pubkey_key, pubkey_key_len, &err);
-    if (err) {
-        MXD_LOG_ERROR("utxo", "Failed to remove pubkey hash index: %s", err);
-        free(err);
+    mxd_utxo_stats_record_t updated = stats;
+    if (stats_account(&updated, &utxo, -1) != 0) {
+        MXD_LOG_ERROR("utxo", "Failed to update UTXO set commitment");
         mxd_free_utxo(&utxo);
         return -1;
     }
     
-    // Remove from LRU cache
-    if (lru_cache) {
-        for (size_t i = 0; i < lru_cache_count; i++) {
-            if (memcmp(lru_cache[i].tx_hash, tx_hash, 64) == 0 &&
-                lru_cache[i].output_index == output_index) {
-                // Free cosigner keys if present
-                free(lru_cache[i].cosigner_keys);
-                lru_cache[i].cosigner_keys = NULL;
-                
-                if (i < lru_cache_count - 1) {
-                    memcpy(&lru_cache[i], &lru_cache[lru_cache_count - 1], sizeof(mxd_utxo_t));
-                    lru_access_counter[i] = lru_access_counter[lru_cache_count - 1];
-                    
-                    lru_cache[lru_cache_count - 1].cosigner_keys = NULL;
-                }
-                
-                lru_cache_count--;
-                break;
-            }
+    int result = 0;
+    rocksdb_writebatch_t *batch = block_batch ? block_batch : rocksdb_writebatch_create();
+    if (block_batch) {
+        result = stage_pending(&utxo, 1, &utxo);
+    } else {
+        batch_put_stats(batch, &updated);
+    }
+    if (result == 0) {
+        rocksdb_writebatch_delete_cf(batch, mxd_get_rocksdb_cf(MXD_CF_UTXO), (char *)key, key_len);
+        rocksdb_writebatch_delete_cf(batch, mxd_get_rocksdb_cf(MXD_CF_PUBKEY_INDEX), (char *)pubkey_key, pubkey_key_len);
+        if (!utxo.is_spent) {
+            batch_balance_delta(batch, &utxo, -1);
         }
     }
+    if (!block_batch) {
+        result = write_batch(batch, "remove UTXO");
+        rocksdb_writebatch_destroy(batch);
+        if (result == 0) {
+            forget_utxo(tx_hash, output_index);
+        }
+    }
+    if (result != 0) {
+        mxd_free_utxo(&utxo);
+        return -1;
+    }
     
-    // Update statistics
-    utxo_count--;
-    total_value -= utxo.amount;
-    
+    stats = updated;
     mxd_free_utxo(&utxo);
     return 0;
 }
@@ -421,7 +1358,18 @@ int mxd_find_utxo(const uint8_t tx_hash[64], uint32_t output_index,
         return -1;
     }
     
-    if (find_in_lru_cache(tx_hash, output_index, utxo) == 0) {
+    // State staged by the block being applied takes precedence
+    const pending_utxo_t *staged = find_pending(tx_hash, output_index);
+    if (staged) {
+        return staged->removed ? -1 : copy_utxo(utxo, &staged->utxo);
+    }
+    
+    // In memory mode the resident table holds the whole set
+    if (memory_mode) {
+        return mxd_utxo_resident_get(tx_hash, output_index, decode_resident, utxo);
+    }
+    
+    if (mxd_utxo_cache_lookup(tx_hash, output_index, utxo) == 0) {
         return 0;
     }
     
@@ -433,7 +1381,8 @@ int mxd_find_utxo(const uint8_t tx_hash[64], uint32_t output_index,
     char *err = NULL;
     char *value = NULL;
     size_t value_len = 0;
-    value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), (char *)key, key_len, &value_len, &err);
+    value = rocksdb_get_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), mxd_get_rocksdb_cf(MXD_CF_UTXO),
+                           (char *)key, key_len, &value_len, &err);
     if (err) {
         MXD_LOG_ERROR("utxo", "Failed to retrieve UTXO: %s", err);
         free(err);
@@ -444,17 +1393,99 @@ int mxd_find_utxo(const uint8_t tx_hash[64], uint32_t output_index,
         return -1; // UTXO not found
     }
     
-    int result = deserialize_utxo((uint8_t *)value, value_len, utxo);
+    int result = deserialize_utxo(tx_hash, output_index, (uint8_t *)value, value_len, utxo);
     
-    // Add to LRU cache
     if (result == 0) {
-        add_to_lru_cache(utxo);
+        mxd_utxo_cache_insert(utxo);
     }
     
     free(value);
     return result;
 }
 
+int mxd_find_utxos(const mxd_utxo_outpoint_t *keys, size_t n, mxd_utxo_t *out, int *status) {
+    if ((!keys || !out || !status) && n > 0) {
+        return -1;
+    }
+    if (!mxd_get_rocksdb_db()) {
+        return -1;
+    }
+    
+    // Serve what is staged or cached, collecting the rest
+    size_t *misses = malloc(n * sizeof(size_t));
+    if (!misses && n > 0) {
+        return -1;
+    }
+    size_t miss_count = 0;
+    for (size_t i = 0; i < n; i++) {
+        status[i] = -1;
+        const pending_utxo_t *staged = find_pending(keys[i].tx_hash, keys[i].output_index);
+        if (staged) {
+            if (!staged->removed && copy_utxo(&out[i], &staged->utxo) == 0) {
+                status[i] = 0;
+            }
+        } else if (memory_mode) {
+            status[i] = mxd_utxo_resident_get(keys[i].tx_hash, keys[i].output_index, decode_resident, &out[i]);
+        } else if (mxd_utxo_cache_lookup(keys[i].tx_hash, keys[i].output_index, &out[i]) == 0) {
+            status[i] = 0;
+        } else {
+            misses[miss_count++] = i;
+        }
+    }
+    
+    if (miss_count == 0) {
+        free(misses);
+        return 0;
+    }
+    
+    // One MultiGet for all misses
+    uint8_t (*key_data)[5 + 64 + sizeof(uint32_t)] = malloc(miss_count * sizeof(*key_data));
+    const char **key_list = malloc(miss_count * sizeof(char *));
+    size_t *key_sizes = malloc(miss_count * sizeof(size_t));
+    const rocksdb_column_family_handle_t **families = malloc(miss_count * sizeof(*families));
+    char **values = malloc(miss_count * sizeof(char *));
+    size_t *value_sizes = malloc(miss_count * sizeof(size_t));
+    char **errs = malloc(miss_count * sizeof(char *));
+    int result = -1;
+    if (key_data && key_list && key_sizes && families && values && value_sizes && errs) {
+        for (size_t m = 0; m < miss_count; m++) {
+            const mxd_utxo_outpoint_t *key = &keys[misses[m]];
+            create_utxo_key(key->tx_hash, key->output_index, key_data[m], &key_sizes[m]);
+            key_list[m] = (const char *)key_data[m];
+            families[m] = mxd_get_rocksdb_cf(MXD_CF_UTXO);
+        }
+        
+        rocksdb_multi_get_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), families, miss_count,
+                             key_list, key_sizes, values, value_sizes, errs);
+        
+        result = 0;
+        for (size_t m = 0; m < miss_count; m++) {
+            size_t i = misses[m];
+            if (errs[m]) {
+                MXD_LOG_ERROR("utxo", "Failed to retrieve UTXO: %s", errs[m]);
+                free(errs[m]);
+                result = -1;
+            } else if (values[m] &&
+                       deserialize_utxo(keys[i].tx_hash, keys[i].output_index, (uint8_t *)values[m],
+                                        value_sizes[m], &out[i]) == 0) {
+                mxd_utxo_cache_insert(&out[i]);
+                status[i] = 0;
+            }
+            free(values[m]);
+        }
+    }
+    
+    free(key_data);
+    free(key_list);
+    free(key_sizes);
+    free(families);
+    free(values);
+    free(value_sizes);
+    free(errs);
+    free(misses);
+    return result;
+}
+
 double mxd_get_balance(const uint8_t public_key[256]) {
     if (!public_key || !mxd_get_rocksdb_db()) {
         return -1;
@@ -465,26 +1496,44 @@ double mxd_get_balance(const uint8_t public_key[256]) {
         return -1;
     }
     
-    mxd_utxo_t *utxos = NULL;
-    size_t utxo_count_local = 0;
-    if (mxd_get_utxos_by_pubkey_hash(pubkey_hash, &utxos, &utxo_count_local) != 0) {
-        return 0.0; // No UTXOs found
+    double balance = 0.0;
+    if (mxd_get_address_balance(pubkey_hash, &balance, NULL) != 0) {
+        return 0.0;
     }
     
-    double balance = 0.0;
-    for (size_t i = 0; i < utxo_count_local; i++) {
-        if (!utxos[i].is_spent) {
-            balance += utxos[i].amount;
-        }
+    return balance;
+}
+
+int mxd_get_address_balance(const uint8_t pubkey_hash[20], double *balance, uint64_t *utxo_count_out) {
+    if (!pubkey_hash || !balance || !mxd_get_rocksdb_db()) {
+        return -1;
     }
     
-    // Free UTXOs
-    for (size_t i = 0; i < utxo_count_local; i++) {
-        mxd_free_utxo(&utxos[i]);
+    uint8_t key[8 + 20];
+    memcpy(key, "balance:", 8);
+    memcpy(key + 8, pubkey_hash, 20);
+    
+    char *err = NULL;
+    size_t value_len = 0;
+    char *value = rocksdb_get_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(),
+                                 mxd_get_rocksdb_cf(MXD_CF_BALANCE), (char *)key, sizeof(key), &value_len, &err);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to read address balance: %s", err);
+        free(err);
+        return -1;
     }
-    free(utxos);
     
-    return balance;
+    int64_t totals[2] = {0, 0};
+    if (value && value_len == sizeof(totals)) {
+        memcpy(totals, value, sizeof(totals));
+    }
+    free(value);
+    
+    *balance = mxd_tx_units_to_amount((uint64_t)(totals[0] > 0 ? totals[0] : 0));
+    if (utxo_count_out) {
+        *utxo_count_out = (uint64_t)(totals[1] > 0 ? totals[1] : 0);
+    }
+    return 0;
 }
 
 int mxd_verify_utxo(const uint8_t tx_hash[64], uint32_t output_index,
@@ -576,8 +1625,8 @@ int mxd_load_utxo_db(void) {
         return -1;
     }
     
-    // RocksDB automatically loads data, just need to update statistics
-    return mxd_get_utxo_stats(&utxo_count, &pruned_count, &total_value);
+    // RocksDB automatically loads data, just need to reload the totals
+    return read_stats(&stats) == 1 ? 0 : -1;
 }
 
 int mxd_close_utxo_db(void) {
@@ -585,7 +1634,9 @@ int mxd_close_utxo_db(void) {
         return -1;
     }
     
-    rocksdb_close(mxd_get_rocksdb_db());
+    stop_memory_mode();
+    
+    mxd_rocksdb_close(mxd_get_rocksdb_db());
     mxd_set_rocksdb_db(NULL);
     
     rocksdb_options_destroy(options);
@@ -598,16 +1649,7 @@ int mxd_close_utxo_db(void) {
     free(db_path_global);
     db_path_global = NULL;
     
-    if (lru_cache) {
-        for (size_t i = 0; i < lru_cache_count; i++) {
-            free(lru_cache[i].cosigner_keys);
-        }
-        free(lru_cache);
-        free(lru_access_counter);
-        lru_cache = NULL;
-        lru_access_counter = NULL;
-        lru_cache_count = 0;
-    }
+    mxd_utxo_cache_cleanup();
     
     return 0;
 }
@@ -647,7 +1689,7 @@ int mxd_get_utxos_by_pubkey_hash(const uint8_t pubkey_hash[20], mxd_utxo_t **utx
     create_pubkey_hash_key(pubkey_hash, prefix_key, &prefix_key_len);
     
     // Create iterator
-    rocksdb_iterator_t *iter = rocksdb_create_iterator(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions());
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(), mxd_get_rocksdb_cf(MXD_CF_PUBKEY_INDEX));
     rocksdb_iter_seek(iter, (char *)prefix_key, prefix_key_len);
     
     size_t count = 0;
@@ -709,51 +1751,102 @@ int mxd_get_utxos_by_pubkey_hash(const uint8_t pubkey_hash[20], mxd_utxo_t **utx
     return 0;
 }
 
+// Spent records deleted per write while pruning
+#define MXD_UTXO_PRUNE_BATCH 2048
+
+static int commit_pruned(rocksdb_writebatch_t *batch, const mxd_utxo_stats_record_t *updated,
+                         const mxd_utxo_outpoint_t *removed, size_t *removed_count, size_t *pruned) {
+    batch_put_stats(batch, updated);
+    int result = write_batch(batch, "prune spent UTXOs");
+    rocksdb_writebatch_clear(batch);
+    if (result == 0) {
+        stats = *updated;
+        *pruned += *removed_count;
+        for (size_t i = 0; i < *removed_count; i++) {
+            forget_utxo(removed[i].tx_hash, removed[i].output_index);
+        }
+    }
+    *removed_count = 0;
+    return result;
+}
+
 int mxd_prune_spent_utxos(void) {
-    if (!mxd_get_rocksdb_db()) {
+    if (!mxd_get_rocksdb_db() || block_batch) {
         return -1;
     }
     
-    // Create iterator
-    rocksdb_iterator_t *iter = rocksdb_create_iterator(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions());
-    rocksdb_iter_seek_to_first(iter);
+    if (stats.spent == 0) {
+        return 0;
+    }
     
+    rocksdb_readoptions_t *scan_options = rocksdb_readoptions_create();
+    rocksdb_readoptions_set_fill_cache(scan_options, 0);
+    rocksdb_iterator_t *iter = rocksdb_create_iterator_cf(mxd_get_rocksdb_db(), scan_options, mxd_get_rocksdb_cf(MXD_CF_UTXO));
+    rocksdb_iter_seek(iter, "utxo:", 5);
+    
+    // Spent records are deleted with their index entries in bounded
+    // batches; spent outputs no longer count towards any balance
+    rocksdb_writebatch_t *batch = rocksdb_writebatch_create();
+    mxd_utxo_outpoint_t *removed = malloc(MXD_UTXO_PRUNE_BATCH * sizeof(mxd_utxo_outpoint_t));
+    size_t removed_count = 0;
     size_t pruned = 0;
+    mxd_utxo_stats_record_t updated = stats;
+    int result = removed ? 0 : -1;
     
-    while (rocksdb_iter_valid(iter)) {
+    while (result == 0 && rocksdb_iter_valid(iter)) {
         size_t key_len;
         const char *key = rocksdb_iter_key(iter, &key_len);
+        if (key_len < 5 || memcmp(key, "utxo:", 5) != 0) {
+            break;
+        }
         
-        // Check if key starts with "utxo:"
-        if (key_len > 5 && memcmp(key, "utxo:", 5) == 0) {
+        uint8_t tx_hash[64];
+        uint32_t output_index;
+        if (parse_utxo_key(key, key_len, tx_hash, &output_index) == 0) {
             size_t value_len;
             const char *value = rocksdb_iter_value(iter, &value_len);
             
             mxd_utxo_t utxo;
             memset(&utxo, 0, sizeof(mxd_utxo_t));
-            if (deserialize_utxo((uint8_t *)value, value_len, &utxo) == 0) {
-                // Check if UTXO is spent
+            if (deserialize_utxo(tx_hash, output_index, (uint8_t *)value, value_len, &utxo) == 0) {
                 if (utxo.is_spent) {
-                    uint8_t tx_hash[64];
-                    uint32_t output_index;
-                    memcpy(tx_hash, key + 5, 64);
-                    memcpy(&output_index, key + 5 + 64, sizeof(uint32_t));
+                    uint8_t pubkey_key[7 + 20 + 64 + sizeof(uint32_t)];
+                    size_t pubkey_key_len;
+                    create_pubkey_hash_key(utxo.pubkey_hash, pubkey_key, &pubkey_key_len);
+                    memcpy(pubkey_key + pubkey_key_len, tx_hash, 64);
+                    memcpy(pubkey_key + pubkey_key_len + 64, &output_index, sizeof(uint32_t));
+                    pubkey_key_len += 64 + sizeof(uint32_t);
                     
-                    mxd_remove_utxo(tx_hash, output_index);
-                    pruned++;
+                    rocksdb_writebatch_delete_cf(batch, mxd_get_rocksdb_cf(MXD_CF_UTXO), key, key_len);
+                    rocksdb_writebatch_delete_cf(batch, mxd_get_rocksdb_cf(MXD_CF_PUBKEY_INDEX),
+                                                 (char *)pubkey_key, pubkey_key_len);
+                    stats_account(&updated, &utxo, -1);
+                    memcpy(removed[removed_count].tx_hash, tx_hash, 64);
+                    removed[removed_count].output_index = output_index;
+                    removed_count++;
                 }
-                
                 mxd_free_utxo(&utxo);
             }
         }
-        
         rocksdb_iter_next(iter);
+        
+        if (removed_count == MXD_UTXO_PRUNE_BATCH) {
+            result = commit_pruned(batch, &updated, removed, &removed_count, &pruned);
+        }
+    }
+    if (result == 0 && removed_count > 0) {
+        result = commit_pruned(batch, &updated, removed, &removed_count, &pruned);
     }
     
+    rocksdb_writebatch_destroy(batch);
     rocksdb_iter_destroy(iter);
-    pruned_count += pruned;
+    rocksdb_readoptions_destroy(scan_options);
+    free(removed);
     
-    return 0;
+    if (pruned > 0) {
+        MXD_LOG_INFO("utxo", "Pruned %zu spent UTXOs", pruned);
+    }
+    return result;
 }
 
 int mxd_get_utxo_count(size_t *count) {
@@ -761,63 +1854,53 @@ int mxd_get_utxo_count(size_t *count) {
         return -1;
     }
     
-    *count = utxo_count;
+    *count = (size_t)stats.count;
     return 0;
 }
 
-// Get UTXO database statistics
+// Get UTXO database statistics from the running totals
 int mxd_get_utxo_stats(size_t *total_count, size_t *pruned_count_out, double *total_value_out) {
     if (!total_count || !pruned_count_out || !total_value_out || !mxd_get_rocksdb_db()) {
         return -1;
     }
     
-    // Reset statistics
-    size_t count = 0;
-    size_t pruned = 0;
-    double value = 0.0;
-    
-    // Create iterator
-    rocksdb_iterator_t *iter = rocksdb_create_iterator(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions());
-    rocksdb_iter_seek_to_first(iter);
-    
-    while (rocksdb_iter_valid(iter)) {
-        size_t key_len;
-        const char *key = rocksdb_iter_key(iter, &key_len);
-        
-        // Check if key starts with "utxo:"
-        if (key_len > 5 && memcmp(key, "utxo:", 5) == 0) {
-            size_t value_len;
-            const char *value_str = rocksdb_iter_value(iter, &value_len);
-            
-            mxd_utxo_t utxo;
-            memset(&utxo, 0, sizeof(mxd_utxo_t));
-            if (deserialize_utxo((uint8_t *)value_str, value_len, &utxo) == 0) {
-                count++;
-                if (!utxo.is_spent) {
-                    value += utxo.amount;
-                } else {
-                    pruned++;
-                }
-                
-                mxd_free_utxo(&utxo);
-            }
-        }
-        
-        rocksdb_iter_next(iter);
+    *total_count = (size_t)stats.count;
+    *pruned_count_out = (size_t)stats.spent;
+    *total_value_out = mxd_tx_units_to_amount((uint64_t)(stats.unspent_units > 0 ? stats.unspent_units : 0));
+    return 0;
+}
+
+int mxd_get_utxo_commitment(uint8_t commitment[64]) {
+    if (!commitment || !mxd_get_rocksdb_db()) {
+        return -1;
     }
     
-    rocksdb_iter_destroy(iter);
-    
-    *total_count = count;
-    *pruned_count_out = pruned;
-    *total_value_out = value;
+    return mxd_muhash_final(&stats.commitment, commitment);
+}
+
+int mxd_get_utxo_commitment_at(uint32_t height, uint8_t commitment[64]) {
+    if (!commitment || !mxd_get_rocksdb_db()) {
+        return -1;
+    }
     
-    // Update global statistics
-    utxo_count = count;
-    pruned_count = pruned;
-    total_value = value;
+    uint8_t key[MXD_UTXO_HEIGHT_KEY_MAX];
+    size_t key_len = create_height_key(MXD_UTXO_COMMITMENT_PREFIX, height, key);
+    char *err = NULL;
+    size_t value_len = 0;
+    char *value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(),
+                              (char *)key, key_len, &value_len, &err);
+    if (err) {
+        MXD_LOG_ERROR("utxo", "Failed to read UTXO commitment: %s", err);
+        free(err);
+        return -1;
+    }
     
-    return 0;
+    int found = value && value_len == 64;
+    if (found) {
+        memcpy(commitment, value, 64);
+    }
+    free(value);
+    return found ? 0 : -1;
 }
 
 int mxd_mark_utxo_spent(const uint8_t tx_hash[64], uint32_t output_index) {
@@ -846,6 +1929,9 @@ int mxd_mark_utxo_spent(const uint8_t tx_hash[64], uint32_t output_index) {
     return result;
 }
 
+// Every column family the UTXO set keeps data in
+static const mxd_rocksdb_cf_t utxo_families[] = {MXD_CF_UTXO, MXD_CF_PUBKEY_INDEX, MXD_CF_BALANCE, MXD_CF_DEFAULT};
+
 int mxd_flush_utxo_db(void) {
     if (!mxd_get_rocksdb_db()) {
         return -1;
@@ -855,7 +1941,9 @@ int mxd_flush_utxo_db(void) {
     rocksdb_flushoptions_t *flushoptions = rocksdb_flushoptions_create();
     rocksdb_flushoptions_set_wait(flushoptions, 1);
     
-    rocksdb_flush(mxd_get_rocksdb_db(), flushoptions, &err);
+    for (size_t i = 0; i < sizeof(utxo_families) / sizeof(utxo_families[0]) && !err; i++) {
+        rocksdb_flush_cf(mxd_get_rocksdb_db(), flushoptions, mxd_get_rocksdb_cf(utxo_families[i]), &err);
+    }
     rocksdb_flushoptions_destroy(flushoptions);
     
     if (err) {
@@ -872,14 +1960,382 @@ int mxd_compact_utxo_db(void) {
         return -1;
     }
     
-    char *err = NULL;
-    rocksdb_compact_range(mxd_get_rocksdb_db(), NULL, 0, NULL, 0);
+    // Compaction is also what folds the balance family's merge operands.
+    // rocksdb_compact_range_cf reports no errors.
+    for (size_t i = 0; i < sizeof(utxo_families) / sizeof(utxo_families[0]); i++) {
+        rocksdb_compact_range_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_cf(utxo_families[i]), NULL, 0, NULL, 0);
+    }
+    
+    return 0;
+}
+
+int mxd_get_utxo_tip(uint32_t *height, uint8_t block_hash[64]) {
+    if (!height || !block_hash || !mxd_get_rocksdb_db()) {
+        return -1;
+    }
+    
+    mxd_utxo_tip_record_t tip;
+    if (read_tip(&tip) != 1) {
+        return -1;
+    }
+    
+    *height = tip.height;
+    memcpy(block_hash, tip.block_hash, 64);
+    return 0;
+}
+
+// Record height and block_hash as the tip
+static void batch_put_tip(rocksdb_writebatch_t *batch, uint32_t height, const uint8_t block_hash[64]) {
+    mxd_utxo_tip_record_t tip;
+    memset(&tip, 0, sizeof(tip));
+    tip.height = height;
+    memcpy(tip.block_hash, block_hash, 64);
+    uint8_t tip_data[MXD_UTXO_TIP_SIZE];
+    serialize_tip(&tip, tip_data);
+    rocksdb_writebatch_put(batch, MXD_UTXO_TIP_KEY, sizeof(MXD_UTXO_TIP_KEY) - 1,
+                           (char *)tip_data, sizeof(tip_data));
+}
+
+// Undo data of a block: the tip it extended and, for every outpoint it
+// touched, the record it replaced (length 0 if the block created it)
+//   1       version
+//   1 + 4 + 64  previous tip: present flag, height, block hash
+//   varint  entry count
+//     per entry: tx_hash[64], output_index (4), varint record length + record
+#define MXD_UTXO_UNDO_VERSION 1
+#define MXD_UTXO_UNDO_HEADER_SIZE (1 + 1 + sizeof(uint32_t) + 64)
+
+static int batch_put_undo(uint32_t height, const mxd_utxo_tip_record_t *prev_tip, int has_prev) {
+    uint8_t **records = calloc(pending_count + 1, sizeof(uint8_t *));
+    size_t *lengths = calloc(pending_count + 1, sizeof(size_t));
+    size_t size = MXD_UTXO_UNDO_HEADER_SIZE;
+    size_t count = 0;
+    int result = records && lengths ? 0 : -1;
+    
+    for (size_t i = 0; result == 0 && i < pending_count; i++) {
+        // Outputs created and spent within the block leave nothing to undo
+        if (!pending[i].has_prior && pending[i].removed) {
+            continue;
+        }
+        if (pending[i].has_prior && serialize_utxo(&pending[i].prior, &records[i], &lengths[i]) != 0) {
+            result = -1;
+            break;
+        }
+        size += 64 + sizeof(uint32_t) + mxd_varint_size(lengths[i]) + lengths[i];
+        count++;
+    }
+    size += mxd_varint_size(count);
+    
+    uint8_t *data = result == 0 ? malloc(size) : NULL;
+    if (data) {
+        uint8_t *p = data;
+        *p++ = MXD_UTXO_UNDO_VERSION;
+        *p++ = has_prev ? 1 : 0;
+        memcpy(p, &prev_tip->height, sizeof(uint32_t));
+        p += sizeof(uint32_t);
+        memcpy(p, prev_tip->block_hash, 64);
+        p += 64;
+        p += mxd_varint_write(p, count);
+        for (size_t i = 0; i < pending_count; i++) {
+            if (!pending[i].has_prior && pending[i].removed) {
+                continue;
+            }
+            memcpy(p, pending[i].utxo.tx_hash, 64);
+            p += 64;
+            memcpy(p, &pending[i].utxo.output_index, sizeof(uint32_t));
+            p += sizeof(uint32_t);
+            p += mxd_varint_write(p, lengths[i]);
+            if (lengths[i] > 0) {
+                memcpy(p, records[i], lengths[i]);
+                p += lengths[i];
+            }
+        }
+        
+        uint8_t key[MXD_UTXO_HEIGHT_KEY_MAX];
+        size_t key_len = create_height_key(MXD_UTXO_UNDO_PREFIX, height, key);
+        rocksdb_writebatch_put(block_batch, (char *)key, key_len, (char *)data, size);
+        free(data);
+    } else {
+        result = -1;
+    }
+    
+    // Only the most recent MXD_UTXO_UNDO_DEPTH blocks can be disconnected
+    if (result == 0 && height >= MXD_UTXO_UNDO_DEPTH) {
+        uint8_t key[MXD_UTXO_HEIGHT_KEY_MAX];
+        size_t key_len = create_height_key(MXD_UTXO_UNDO_PREFIX, height - MXD_UTXO_UNDO_DEPTH, key);
+        rocksdb_writebatch_delete(block_batch, (char *)key, key_len);
+    }
+    
+    if (records) {
+        for (size_t i = 0; i < pending_count; i++) {
+            free(records[i]);
+        }
+    }
+    free(records);
+    free(lengths);
+    return result;
+}
+
+int mxd_apply_block_to_utxo(const mxd_block_t *block, const mxd_transaction_t *txs, size_t tx_count) {
+    if (!block || (!txs && tx_count > 0) || !mxd_get_rocksdb_db()) {
+        return -1;
+    }
+    
+    mxd_utxo_tip_record_t tip;
+    memset(&tip, 0, sizeof(tip));
+    int has_tip = read_tip(&tip);
+    if (has_tip < 0) {
+        MXD_LOG_ERROR("utxo", "UTXO set is inconsistent, reset and replay required");
+        return -1;
+    }
+    
+    // Blocks must extend the recorded tip
+    if (has_tip == 1 && (block->height != tip.height + 1 ||
+                         memcmp(block->prev_block_hash, tip.block_hash, 64) != 0)) {
+        MXD_LOG_ERROR("utxo", "Block at height %u does not extend UTXO tip at height %u",
+                      block->height, tip.height);
+        return -1;
+    }
+    
+    // All of the block's mutations, its undo data and the new tip are
+    // committed together with a single synced write, so a failure or crash
+    // part-way through leaves the set at the previous tip
+    if (block_batch) {
+        MXD_LOG_ERROR("utxo", "Block application already in progress");
+        return -1;
+    }
+    begin_block_batch();
+    
+    for (size_t i = 0; i < tx_count; i++) {
+        if (mxd_apply_transaction_to_utxo(&txs[i]) != 0) {
+            MXD_LOG_ERROR("utxo", "Failed to apply transaction %zu of block %u", i, block->height);
+            abort_block_batch();
+            return -1;
+        }
+    }
+    
+    if (batch_put_undo(block->height, &tip, has_tip == 1) != 0) {
+        MXD_LOG_ERROR("utxo", "Failed to record undo data for block %u", block->height);
+        abort_block_batch();
+        return -1;
+    }
+    batch_put_tip(block_batch, block->height, block->block_hash);
+    batch_put_stats(block_batch, &stats);
+    
+    // Record the set commitment at this height for checkpoints and peers
+    uint8_t commitment_key[MXD_UTXO_HEIGHT_KEY_MAX];
+    size_t commitment_key_len = create_height_key(MXD_UTXO_COMMITMENT_PREFIX, block->height, commitment_key);
+    uint8_t commitment[64];
+    if (mxd_muhash_final(&stats.commitment, commitment) != 0) {
+        abort_block_batch();
+        return -1;
+    }
+    rocksdb_writebatch_put(block_batch, (char *)commitment_key, commitment_key_len,
+                           (char *)commitment, sizeof(commitment));
+    
+    return commit_block_batch();
+}
+
+// Put back the records listed in a block's undo data
+static int apply_undo_entries(const uint8_t *data, size_t data_len, size_t pos) {
+    uint64_t count;
+    if (mxd_varint_read(data, data_len, &pos, data_len, &count) != 0) {
+        return -1;
+    }
+    
+    for (uint64_t n = 0; n < count; n++) {
+        uint8_t tx_hash[64];
+        uint32_t output_index;
+        uint64_t record_len;
+        if (data_len - pos < 64 + sizeof(uint32_t)) {
+            return -1;
+        }
+        memcpy(tx_hash, data + pos, 64);
+        memcpy(&output_index, data + pos + 64, sizeof(uint32_t));
+        pos += 64 + sizeof(uint32_t);
+        if (mxd_varint_read(data, data_len, &pos, data_len - pos, &record_len) != 0) {
+            return -1;
+        }
+        
+        mxd_utxo_t utxo;
+        memset(&utxo, 0, sizeof(mxd_utxo_t));
+        int result;
+        if (record_len == 0) {
+            // Created by the block; it may already have been spent and pruned
+            result = mxd_find_utxo(tx_hash, output_index, &utxo) == 0 ? mxd_remove_utxo(tx_hash, output_index) : 0;
+        } else if (deserialize_utxo(tx_hash, output_index, data + pos, (size_t)record_len, &utxo) == 0) {
+            result = mxd_add_utxo(&utxo);
+        } else {
+            return -1;
+        }
+        mxd_free_utxo(&utxo);
+        if (result != 0) {
+            return -1;
+        }
+        pos += (size_t)record_len;
+    }
+    return pos == data_len ? 0 : -1;
+}
+
+int mxd_disconnect_block_from_utxo(const mxd_block_t *block) {
+    if (!block || !mxd_get_rocksdb_db()) {
+        return -1;
+    }
+    
+    mxd_utxo_tip_record_t tip;
+    if (read_tip(&tip) != 1 || tip.height != block->height ||
+        memcmp(tip.block_hash, block->block_hash, 64) != 0) {
+        MXD_LOG_ERROR("utxo", "Block at height %u is not the UTXO tip", block->height);
+        return -1;
+    }
+    if (block_batch) {
+        MXD_LOG_ERROR("utxo", "Block application already in progress");
+        return -1;
+    }
     
+    uint8_t undo_key[MXD_UTXO_HEIGHT_KEY_MAX];
+    size_t undo_key_len = create_height_key(MXD_UTXO_UNDO_PREFIX, block->height, undo_key);
+    char *err = NULL;
+    size_t value_len = 0;
+    char *value = rocksdb_get(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(),
+                              (char *)undo_key, undo_key_len, &value_len, &err);
     if (err) {
-        MXD_LOG_ERROR("utxo", "Failed to compact UTXO database: %s", err);
+        MXD_LOG_ERROR("utxo", "Failed to read undo data: %s", err);
         free(err);
         return -1;
     }
+    if (!value || value_len < MXD_UTXO_UNDO_HEADER_SIZE || (uint8_t)value[0] != MXD_UTXO_UNDO_VERSION) {
+        MXD_LOG_ERROR("utxo", "No undo data for block %u, rebuild required", block->height);
+        free(value);
+        return -1;
+    }
+    
+    const uint8_t *data = (const uint8_t *)value;
+    int has_prev = data[1];
+    uint32_t prev_height;
+    uint8_t prev_hash[64];
+    memcpy(&prev_height, data + 2, sizeof(uint32_t));
+    memcpy(prev_hash, data + 2 + sizeof(uint32_t), 64);
+    
+    // The restored records, the previous tip and the removal of this
+    // block's records are committed together like a block
+    begin_block_batch();
+    if (apply_undo_entries(data, value_len, MXD_UTXO_UNDO_HEADER_SIZE) != 0) {
+        MXD_LOG_ERROR("utxo", "Failed to apply undo data for block %u", block->height);
+        abort_block_batch();
+        free(value);
+        return -1;
+    }
+    free(value);
+    
+    if (has_prev) {
+        batch_put_tip(block_batch, prev_height, prev_hash);
+    } else {
+        rocksdb_writebatch_delete(block_batch, MXD_UTXO_TIP_KEY, sizeof(MXD_UTXO_TIP_KEY) - 1);
+    }
+    batch_put_stats(block_batch, &stats);
+    uint8_t commitment_key[MXD_UTXO_HEIGHT_KEY_MAX];
+    size_t commitment_key_len = create_height_key(MXD_UTXO_COMMITMENT_PREFIX, block->height, commitment_key);
+    rocksdb_writebatch_delete(block_batch, (char *)commitment_key, commitment_key_len);
+    rocksdb_writebatch_delete(block_batch, (char *)undo_key, undo_key_len);
+    
+    if (commit_block_batch() != 0) {
+        return -1;
+    }
+    MXD_LOG_INFO("utxo", "Disconnected block %u from the UTXO set", block->height);
+    return 0;
+}
+
+int mxd_reorganize_utxo(const mxd_utxo_block_t *old_branch, size_t old_count,
+                        const mxd_utxo_block_t *new_branch, size_t new_count) {
+    if ((!old_branch && old_count > 0) || !new_branch || new_count == 0 || !mxd_get_rocksdb_db()) {
+        return -1;
+    }
+    
+    // Both branches must grow from the same parent
+    if (old_count > 0) {
+        const mxd_block_t *old_first = old_branch[old_count - 1].block;
+        const mxd_block_t *new_first = new_branch[0].block;
+        if (!old_first || !new_first || old_first->height != new_first->height ||
+            memcmp(old_first->prev_block_hash, new_first->prev_block_hash, 64) != 0) {
+            MXD_LOG_ERROR("utxo", "Competing branch does not start at the fork point");
+            return -1;
+        }
+    }
+    
+    size_t disconnected = 0;
+    while (disconnected < old_count &&
+           mxd_disconnect_block_from_utxo(old_branch[disconnected].block) == 0) {
+        disconnected++;
+    }
+    
+    size_t applied = 0;
+    if (disconnected == old_count) {
+        while (applied < new_count &&
+               mxd_apply_block_to_utxo(new_branch[applied].block, new_branch[applied].txs,
+                                       new_branch[applied].tx_count) == 0) {
+            applied++;
+        }
+        if (applied == new_count) {
+            MXD_LOG_INFO("utxo", "Reorganized UTXO set: %zu blocks disconnected, %zu applied",
+                         old_count, new_count);
+            return 0;
+        }
+    }
+    
+    // Put the previous branch back
+    MXD_LOG_ERROR("utxo", "UTXO reorganization failed, restoring the previous branch");
+    while (applied > 0) {
+        applied--;
+        if (mxd_disconnect_block_from_utxo(new_branch[applied].block) != 0) {
+            MXD_LOG_ERROR("utxo", "Failed to restore UTXO set, reset and replay required");
+            return -1;
+        }
+    }
+    while (disconnected > 0) {
+        disconnected--;
+        if (mxd_apply_block_to_utxo(old_branch[disconnected].block, old_branch[disconnected].txs,
+                                    old_branch[disconnected].tx_count) != 0) {
+            MXD_LOG_ERROR("utxo", "Failed to restore UTXO set, reset and replay required");
+            return -1;
+        }
+    }
+    return -1;
+}
+
+int mxd_replay_utxo_blocks(uint32_t target_height, mxd_utxo_replay_fn apply_block, void *user_data) {
+    if (!apply_block || !mxd_get_rocksdb_db()) {
+        return -1;
+    }
+    
+    uint32_t height = 0;
+    uint8_t block_hash[64];
+    if (mxd_get_utxo_tip(&height, block_hash) == 0) {
+        if (height >= target_height) {
+            return 0;
+        }
+        height++;
+    }
+    
+    uint32_t first = height;
+    for (; height <= target_height; height++) {
+        uint32_t applied = 0;
+        if (apply_block(height, user_data) != 0 ||
+            mxd_get_utxo_tip(&applied, block_hash) != 0 || applied != height) {
+            MXD_LOG_ERROR("utxo", "UTXO replay failed at height %u", height);
+            return -1;
+        }
+    }
     
+    MXD_LOG_INFO("utxo", "Replayed %u blocks into the UTXO set (heights %u-%u)",
+                 target_height - first + 1, first, target_height);
     return 0;
 }
+
+int mxd_reset_utxo_db(void) {
+    if (!mxd_get_rocksdb_db()) {
+        return -1;
+    }
+    
+    return clear_utxo_keys();
+}
@@ -0,0 +1,373 @@
+#include "mxd_logging.h"
+
+#include "../include/mxd_utxo_cache.h"
+#include <openssl/rand.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// UTXOs are cached in 16 independently locked open-addressing tables keyed
+// by (tx_hash, output_index). Each table uses linear probing with
+// backward-shift deletion and CLOCK eviction: a hit sets the slot's
+// reference bit, and the clock hand clears bits until it finds a slot that
+// has not been touched since its last pass.
+#define MXD_UTXO_CACHE_SHARDS 16
+#define MXD_UTXO_CACHE_MIN_SLOTS 64
+
+typedef struct {
+    uint64_t hash;       // 0 marks an empty slot
+    uint8_t referenced;
+    mxd_utxo_t utxo;     // Owns its cosigner_keys
+} mxd_utxo_cache_slot_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    mxd_utxo_cache_slot_t *slots;
+    size_t mask;         // Slot count - 1
+    size_t entries;
+    size_t max_entries;  // Keeps the load factor at 3/4
+    size_t extra_bytes;  // Cosigner keys held by cached entries
+    size_t byte_budget;
+    size_t clock_hand;
+} mxd_utxo_cache_shard_t;
+
+static pthread_rwlock_t utxo_cache_lock = PTHREAD_RWLOCK_INITIALIZER;
+static mxd_utxo_cache_shard_t utxo_cache_shards[MXD_UTXO_CACHE_SHARDS];
+static uint64_t utxo_cache_seed = 0;
+static size_t utxo_cache_budget = 0;
+static int utxo_cache_initialized = 0;
+
+static uint64_t utxo_cache_hits = 0;
+static uint64_t utxo_cache_misses = 0;
+static uint64_t utxo_cache_insertions = 0;
+static uint64_t utxo_cache_evictions = 0;
+
+static pthread_once_t utxo_cache_mutex_once = PTHREAD_ONCE_INIT;
+
+static void utxo_cache_init_mutexes(void) {
+    for (int i = 0; i < MXD_UTXO_CACHE_SHARDS; i++) {
+        pthread_mutex_init(&utxo_cache_shards[i].lock, NULL);
+    }
+}
+
+static uint64_t utxo_cache_hash(const uint8_t tx_hash[64], uint32_t output_index) {
+    // tx_hash is already a SHA-512 digest; the seeded finalizer stops peers
+    // from grinding hashes that pile into one probe sequence
+    uint64_t h;
+    memcpy(&h, tx_hash, sizeof(h));
+    h ^= utxo_cache_seed ^ ((uint64_t)output_index * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h ? h : 1;
+}
+
+// Shards use the high bits so slot indices (low bits) stay spread out
+static mxd_utxo_cache_shard_t *shard_for(uint64_t hash) {
+    return &utxo_cache_shards[(hash >> 32) % MXD_UTXO_CACHE_SHARDS];
+}
+
+static size_t cosigner_bytes(const mxd_utxo_t *utxo) {
+    return utxo->cosigner_keys ? (size_t)utxo->cosigner_count * 256 : 0;
+}
+
+static int copy_utxo(mxd_utxo_t *dst, const mxd_utxo_t *src) {
+    memcpy(dst, src, sizeof(mxd_utxo_t));
+    dst->cosigner_keys = NULL;
+    if (src->cosigner_count > 0 && src->cosigner_keys) {
+        dst->cosigner_keys = malloc(src->cosigner_count * 256);
+        if (!dst->cosigner_keys) {
+            return -1;
+        }
+        memcpy(dst->cosigner_keys, src->cosigner_keys, src->cosigner_count * 256);
+    }
+    return 0;
+}
+
+static void utxo_cache_free_locked(void) {
+    for (int i = 0; i < MXD_UTXO_CACHE_SHARDS; i++) {
+        mxd_utxo_cache_shard_t *shard = &utxo_cache_shards[i];
+        if (shard->slots) {
+            for (size_t s = 0; s <= shard->mask; s++) {
+                free(shard->slots[s].utxo.cosigner_keys);
+            }
+        }
+        free(shard->slots);
+        shard->slots = NULL;
+        shard->mask = 0;
+        shard->entries = 0;
+        shard->max_entries = 0;
+        shard->extra_bytes = 0;
+        shard->byte_budget = 0;
+        shard->clock_hand = 0;
+    }
+    utxo_cache_budget = 0;
+    utxo_cache_initialized = 0;
+}
+
+// Find the slot holding the key, or -1
+static long shard_find(const mxd_utxo_cache_shard_t *shard, uint64_t hash,
+                       const uint8_t tx_hash[64], uint32_t output_index) {
+    size_t i = hash & shard->mask;
+    while (shard->slots[i].hash != 0) {
+        const mxd_utxo_cache_slot_t *slot = &shard->slots[i];
+        if (slot->hash == hash && slot->utxo.output_index == output_index &&
+            memcmp(slot->utxo.tx_hash, tx_hash, 64) == 0) {
+            return (long)i;
+        }
+        i = (i + 1) & shard->mask;
+    }
+    return -1;
+}
+
+// Empty slot i, shifting later members of its probe run back so lookups
+// never need tombstones
+static void shard_delete(mxd_utxo_cache_shard_t *shard, size_t i) {
+    shard->extra_bytes -= cosigner_bytes(&shard->slots[i].utxo);
+    free(shard->slots[i].utxo.cosigner_keys);
+    shard->entries--;
+
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & shard->mask;
+        if (shard->slots[j].hash == 0) {
+            break;
+        }
+        size_t home = shard->slots[j].hash & shard->mask;
+        // Leave the entry where it is if its home lies cyclically in (i, j]
+        int stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (stays) {
+            continue;
+        }
+        shard->slots[i] = shard->slots[j];
+        i = j;
+    }
+    memset(&shard->slots[i], 0, sizeof(mxd_utxo_cache_slot_t));
+}
+
+static size_t shard_bytes(const mxd_utxo_cache_shard_t *shard) {
+    return (shard->mask + 1) * sizeof(mxd_utxo_cache_slot_t) + shard->extra_bytes;
+}
+
+// Advance the clock hand and evict the first unreferenced entry
+static void shard_evict_one(mxd_utxo_cache_shard_t *shard) {
+    for (;;) {
+        size_t i = shard->clock_hand;
+        shard->clock_hand = (shard->clock_hand + 1) & shard->mask;
+        mxd_utxo_cache_slot_t *slot = &shard->slots[i];
+        if (slot->hash == 0) {
+            continue;
+        }
+        if (slot->referenced) {
+            slot->referenced = 0;
+            continue;
+        }
+        shard_delete(shard, i);
+        __atomic_fetch_add(&utxo_cache_evictions, 1, __ATOMIC_RELAXED);
+        return;
+    }
+}
+
+int mxd_utxo_cache_init(size_t byte_budget) {
+    if (byte_budget == 0) {
+        byte_budget = MXD_UTXO_CACHE_DEFAULT_BYTES;
+    }
+
+    // Largest power-of-two table per shard that fits the budget
+    size_t per_shard = byte_budget / MXD_UTXO_CACHE_SHARDS;
+    size_t slots = MXD_UTXO_CACHE_MIN_SLOTS;
+    while (slots * 2 * sizeof(mxd_utxo_cache_slot_t) <= per_shard) {
+        slots <<= 1;
+    }
+
+    pthread_once(&utxo_cache_mutex_once, utxo_cache_init_mutexes);
+    pthread_rwlock_wrlock(&utxo_cache_lock);
+    utxo_cache_free_locked();
+
+    if (RAND_bytes((unsigned char *)&utxo_cache_seed, sizeof(utxo_cache_seed)) != 1) {
+        MXD_LOG_ERROR("utxo_cache", "Failed to generate UTXO cache seed");
+        pthread_rwlock_unlock(&utxo_cache_lock);
+        return -1;
+    }
+
+    for (int i = 0; i < MXD_UTXO_CACHE_SHARDS; i++) {
+        mxd_utxo_cache_shard_t *shard = &utxo_cache_shards[i];
+        shard->slots = calloc(slots, sizeof(mxd_utxo_cache_slot_t));
+        if (!shard->slots) {
+            MXD_LOG_ERROR("utxo_cache", "Failed to allocate UTXO cache shard");
+            utxo_cache_free_locked();
+            pthread_rwlock_unlock(&utxo_cache_lock);
+            return -1;
+        }
+        shard->mask = slots - 1;
+        shard->max_entries = slots * 3 / 4;
+        shard->byte_budget = per_shard > slots * sizeof(mxd_utxo_cache_slot_t)
+                                 ? per_shard
+                                 : slots * sizeof(mxd_utxo_cache_slot_t);
+    }
+
+    __atomic_store_n(&utxo_cache_hits, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&utxo_cache_misses, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&utxo_cache_insertions, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&utxo_cache_evictions, 0, __ATOMIC_RELAXED);
+
+    // Tiny budgets are rounded up to the minimum table size
+    if (byte_budget < slots * sizeof(mxd_utxo_cache_slot_t) * MXD_UTXO_CACHE_SHARDS) {
+        byte_budget = slots * sizeof(mxd_utxo_cache_slot_t) * MXD_UTXO_CACHE_SHARDS;
+    }
+    utxo_cache_budget = byte_budget;
+    utxo_cache_initialized = 1;
+    pthread_rwlock_unlock(&utxo_cache_lock);
+
+    MXD_LOG_INFO("utxo_cache", "UTXO cache initialized: %zu MB budget, %zu entries max",
+                 byte_budget / (1024 * 1024), (slots * 3 / 4) * MXD_UTXO_CACHE_SHARDS);
+    return 0;
+}
+
+void mxd_utxo_cache_cleanup(void) {
+    pthread_rwlock_wrlock(&utxo_cache_lock);
+    utxo_cache_free_locked();
+    pthread_rwlock_unlock(&utxo_cache_lock);
+}
+
+void mxd_utxo_cache_clear(void) {
+    pthread_rwlock_rdlock(&utxo_cache_lock);
+    for (int i = 0; utxo_cache_initialized && i < MXD_UTXO_CACHE_SHARDS; i++) {
+        mxd_utxo_cache_shard_t *shard = &utxo_cache_shards[i];
+        pthread_mutex_lock(&shard->lock);
+        for (size_t s = 0; s <= shard->mask; s++) {
+            free(shard->slots[s].utxo.cosigner_keys);
+        }
+        memset(shard->slots, 0, (shard->mask + 1) * sizeof(mxd_utxo_cache_slot_t));
+        shard->entries = 0;
+        shard->extra_bytes = 0;
+        shard->clock_hand = 0;
+        pthread_mutex_unlock(&shard->lock);
+    }
+    pthread_rwlock_unlock(&utxo_cache_lock);
+}
+
+int mxd_utxo_cache_lookup(const uint8_t tx_hash[64], uint32_t output_index,
+                          mxd_utxo_t *utxo) {
+    if (!tx_hash || !utxo) {
+        return -1;
+    }
+
+    pthread_rwlock_rdlock(&utxo_cache_lock);
+    if (!utxo_cache_initialized) {
+        pthread_rwlock_unlock(&utxo_cache_lock);
+        return -1;
+    }
+
+    uint64_t hash = utxo_cache_hash(tx_hash, output_index);
+    mxd_utxo_cache_shard_t *shard = shard_for(hash);
+    int result = -1;
+
+    pthread_mutex_lock(&shard->lock);
+    long i = shard_find(shard, hash, tx_hash, output_index);
+    if (i >= 0) {
+        shard->slots[i].referenced = 1;
+        result = copy_utxo(utxo, &shard->slots[i].utxo);
+    }
+    pthread_mutex_unlock(&shard->lock);
+    pthread_rwlock_unlock(&utxo_cache_lock);
+
+    __atomic_fetch_add(i >= 0 ? &utxo_cache_hits : &utxo_cache_misses, 1, __ATOMIC_RELAXED);
+    return result;
+}
+
+void mxd_utxo_cache_insert(const mxd_utxo_t *utxo) {
+    if (!utxo) {
+        return;
+    }
+
+    pthread_rwlock_rdlock(&utxo_cache_lock);
+    if (!utxo_cache_initialized) {
+        pthread_rwlock_unlock(&utxo_cache_lock);
+        return;
+    }
+
+    // Copy outside the shard lock; a failed copy just leaves it uncached
+    mxd_utxo_cache_slot_t entry;
+    memset(&entry, 0, sizeof(entry));
+    if (copy_utxo(&entry.utxo, utxo) != 0) {
+        pthread_rwlock_unlock(&utxo_cache_lock);
+        return;
+    }
+    entry.hash = utxo_cache_hash(utxo->tx_hash, utxo->output_index);
+    entry.referenced = 1;
+
+    mxd_utxo_cache_shard_t *shard = shard_for(entry.hash);
+    size_t entry_bytes = cosigner_bytes(&entry.utxo);
+
+    pthread_mutex_lock(&shard->lock);
+    long existing = shard_find(shard, entry.hash, utxo->tx_hash, utxo->output_index);
+    if (existing >= 0) {
+        shard_delete(shard, (size_t)existing);
+    }
+    while (shard->entries > 0 &&
+           (shard->entries >= shard->max_entries ||
+            shard_bytes(shard) + entry_bytes > shard->byte_budget)) {
+        shard_evict_one(shard);
+    }
+
+    size_t i = entry.hash & shard->mask;
+    while (shard->slots[i].hash != 0) {
+        i = (i + 1) & shard->mask;
+    }
+    shard->slots[i] = entry;
+    shard->entries++;
+    shard->extra_bytes += entry_bytes;
+    pthread_mutex_unlock(&shard->lock);
+    pthread_rwlock_unlock(&utxo_cache_lock);
+
+    __atomic_fetch_add(&utxo_cache_insertions, 1, __ATOMIC_RELAXED);
+}
+
+void mxd_utxo_cache_remove(const uint8_t tx_hash[64], uint32_t output_index) {
+    if (!tx_hash) {
+        return;
+    }
+
+    pthread_rwlock_rdlock(&utxo_cache_lock);
+    if (!utxo_cache_initialized) {
+        pthread_rwlock_unlock(&utxo_cache_lock);
+        return;
+    }
+
+    uint64_t hash = utxo_cache_hash(tx_hash, output_index);
+    mxd_utxo_cache_shard_t *shard = shard_for(hash);
+
+    pthread_mutex_lock(&shard->lock);
+    long i = shard_find(shard, hash, tx_hash, output_index);
+    if (i >= 0) {
+        shard_delete(shard, (size_t)i);
+    }
+    pthread_mutex_unlock(&shard->lock);
+    pthread_rwlock_unlock(&utxo_cache_lock);
+}
+
+void mxd_utxo_cache_get_stats(mxd_utxo_cache_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->hits = __atomic_load_n(&utxo_cache_hits, __ATOMIC_RELAXED);
+    stats->misses = __atomic_load_n(&utxo_cache_misses, __ATOMIC_RELAXED);
+    stats->insertions = __atomic_load_n(&utxo_cache_insertions, __ATOMIC_RELAXED);
+    stats->evictions = __atomic_load_n(&utxo_cache_evictions, __ATOMIC_RELAXED);
+
+    pthread_rwlock_rdlock(&utxo_cache_lock);
+    if (utxo_cache_initialized) {
+        for (int i = 0; i < MXD_UTXO_CACHE_SHARDS; i++) {
+            pthread_mutex_lock(&utxo_cache_shards[i].lock);
+            stats->entries += utxo_cache_shards[i].entries;
+            stats->bytes += shard_bytes(&utxo_cache_shards[i]);
+            pthread_mutex_unlock(&utxo_cache_shards[i].lock);
+        }
+        stats->byte_budget = utxo_cache_budget;
+    }
+    pthread_rwlock_unlock(&utxo_cache_lock);
+}
@@ -0,0 +1,253 @@
+#include "mxd_logging.h"
+
+#include "../include/mxd_utxo_resident.h"
+#include <openssl/rand.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// One open-addressing table with linear probing and backward-shift
+// deletion. Slots are 16 bytes; each points at a single allocation holding
+// the outpoint and its compact record. Unlike the cache nothing is ever
+// evicted: the table doubles when it reaches 3/4 load.
+#define MXD_UTXO_RESIDENT_MIN_SLOTS 1024
+
+typedef struct {
+    uint8_t tx_hash[64];
+    uint32_t output_index;
+    uint32_t record_len;
+    uint8_t record[];
+} mxd_utxo_resident_entry_t;
+
+typedef struct {
+    uint64_t hash;                      // 0 marks an empty slot
+    mxd_utxo_resident_entry_t *entry;
+} mxd_utxo_resident_slot_t;
+
+static pthread_rwlock_t resident_lock = PTHREAD_RWLOCK_INITIALIZER;
+static mxd_utxo_resident_slot_t *resident_slots = NULL;
+static size_t resident_mask = 0;
+static size_t resident_entries = 0;
+static size_t resident_record_bytes = 0;
+static uint64_t resident_seed = 0;
+
+static uint64_t resident_hash(const uint8_t tx_hash[64], uint32_t output_index) {
+    uint64_t h;
+    memcpy(&h, tx_hash, sizeof(h));
+    h ^= resident_seed ^ ((uint64_t)output_index * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h ? h : 1;
+}
+
+static size_t entry_size(size_t record_len) {
+    return sizeof(mxd_utxo_resident_entry_t) + record_len;
+}
+
+static void resident_free_locked(void) {
+    if (resident_slots) {
+        for (size_t i = 0; i <= resident_mask; i++) {
+            free(resident_slots[i].entry);
+        }
+    }
+    free(resident_slots);
+    resident_slots = NULL;
+    resident_mask = 0;
+    resident_entries = 0;
+    resident_record_bytes = 0;
+}
+
+static long resident_find(uint64_t hash, const uint8_t tx_hash[64], uint32_t output_index) {
+    size_t i = hash & resident_mask;
+    while (resident_slots[i].hash != 0) {
+        const mxd_utxo_resident_entry_t *entry = resident_slots[i].entry;
+        if (resident_slots[i].hash == hash && entry->output_index == output_index &&
+            memcmp(entry->tx_hash, tx_hash, 64) == 0) {
+            return (long)i;
+        }
+        i = (i + 1) & resident_mask;
+    }
+    return -1;
+}
+
+static void resident_place(mxd_utxo_resident_slot_t *slots, size_t mask, mxd_utxo_resident_slot_t slot) {
+    size_t i = slot.hash & mask;
+    while (slots[i].hash != 0) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = slot;
+}
+
+static int resident_grow(void) {
+    size_t slot_count = (resident_mask + 1) * 2;
+    mxd_utxo_resident_slot_t *slots = calloc(slot_count, sizeof(mxd_utxo_resident_slot_t));
+    if (!slots) {
+        return -1;
+    }
+    for (size_t i = 0; i <= resident_mask; i++) {
+        if (resident_slots[i].hash != 0) {
+            resident_place(slots, slot_count - 1, resident_slots[i]);
+        }
+    }
+    free(resident_slots);
+    resident_slots = slots;
+    resident_mask = slot_count - 1;
+    return 0;
+}
+
+// Empty slot i, shifting later members of its probe run back
+static void resident_delete(size_t i) {
+    resident_record_bytes -= entry_size(resident_slots[i].entry->record_len);
+    free(resident_slots[i].entry);
+    resident_entries--;
+
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & resident_mask;
+        if (resident_slots[j].hash == 0) {
+            break;
+        }
+        size_t home = resident_slots[j].hash & resident_mask;
+        int stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (stays) {
+            continue;
+        }
+        resident_slots[i] = resident_slots[j];
+        i = j;
+    }
+    memset(&resident_slots[i], 0, sizeof(mxd_utxo_resident_slot_t));
+}
+
+int mxd_utxo_resident_init(void) {
+    pthread_rwlock_wrlock(&resident_lock);
+    resident_free_locked();
+
+    if (RAND_bytes((unsigned char *)&resident_seed, sizeof(resident_seed)) != 1) {
+        MXD_LOG_ERROR("utxo", "Failed to generate resident UTXO table seed");
+        pthread_rwlock_unlock(&resident_lock);
+        return -1;
+    }
+
+    resident_slots = calloc(MXD_UTXO_RESIDENT_MIN_SLOTS, sizeof(mxd_utxo_resident_slot_t));
+    if (!resident_slots) {
+        pthread_rwlock_unlock(&resident_lock);
+        return -1;
+    }
+    resident_mask = MXD_UTXO_RESIDENT_MIN_SLOTS - 1;
+    pthread_rwlock_unlock(&resident_lock);
+    return 0;
+}
+
+void mxd_utxo_resident_cleanup(void) {
+    pthread_rwlock_wrlock(&resident_lock);
+    resident_free_locked();
+    pthread_rwlock_unlock(&resident_lock);
+}
+
+void mxd_utxo_resident_clear(void) {
+    pthread_rwlock_wrlock(&resident_lock);
+    if (resident_slots) {
+        for (size_t i = 0; i <= resident_mask; i++) {
+            free(resident_slots[i].entry);
+        }
+        memset(resident_slots, 0, (resident_mask + 1) * sizeof(mxd_utxo_resident_slot_t));
+    }
+    resident_entries = 0;
+    resident_record_bytes = 0;
+    pthread_rwlock_unlock(&resident_lock);
+}
+
+int mxd_utxo_resident_put(const uint8_t tx_hash[64], uint32_t output_index,
+                          const uint8_t *record, size_t record_len) {
+    if (!tx_hash || !record || record_len > UINT32_MAX) {
+        return -1;
+    }
+
+    mxd_utxo_resident_entry_t *entry = malloc(entry_size(record_len));
+    if (!entry) {
+        return -1;
+    }
+    memcpy(entry->tx_hash, tx_hash, 64);
+    entry->output_index = output_index;
+    entry->record_len = (uint32_t)record_len;
+    memcpy(entry->record, record, record_len);
+
+    pthread_rwlock_wrlock(&resident_lock);
+    if (!resident_slots) {
+        pthread_rwlock_unlock(&resident_lock);
+        free(entry);
+        return -1;
+    }
+
+    uint64_t hash = resident_hash(tx_hash, output_index);
+    long existing = resident_find(hash, tx_hash, output_index);
+    if (existing >= 0) {
+        mxd_utxo_resident_entry_t *old = resident_slots[existing].entry;
+        resident_record_bytes += entry_size(record_len);
+        resident_record_bytes -= entry_size(old->record_len);
+        resident_slots[existing].entry = entry;
+        pthread_rwlock_unlock(&resident_lock);
+        free(old);
+        return 0;
+    }
+
+    if ((resident_entries + 1) * 4 > (resident_mask + 1) * 3 && resident_grow() != 0) {
+        pthread_rwlock_unlock(&resident_lock);
+        free(entry);
+        return -1;
+    }
+    mxd_utxo_resident_slot_t slot = {hash, entry};
+    resident_place(resident_slots, resident_mask, slot);
+    resident_entries++;
+    resident_record_bytes += entry_size(record_len);
+    pthread_rwlock_unlock(&resident_lock);
+    return 0;
+}
+
+int mxd_utxo_resident_get(const uint8_t tx_hash[64], uint32_t output_index,
+                          mxd_utxo_resident_decode_fn decode, void *user_data) {
+    if (!tx_hash || !decode) {
+        return -1;
+    }
+
+    pthread_rwlock_rdlock(&resident_lock);
+    int result = -1;
+    if (resident_slots) {
+        long i = resident_find(resident_hash(tx_hash, output_index), tx_hash, output_index);
+        if (i >= 0) {
+            const mxd_utxo_resident_entry_t *entry = resident_slots[i].entry;
+            result = decode(tx_hash, output_index, entry->record, entry->record_len, user_data);
+        }
+    }
+    pthread_rwlock_unlock(&resident_lock);
+    return result;
+}
+
+void mxd_utxo_resident_remove(const uint8_t tx_hash[64], uint32_t output_index) {
+    if (!tx_hash) {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&resident_lock);
+    if (resident_slots) {
+        long i = resident_find(resident_hash(tx_hash, output_index), tx_hash, output_index);
+        if (i >= 0) {
+            resident_delete((size_t)i);
+        }
+    }
+    pthread_rwlock_unlock(&resident_lock);
+}
+
+void mxd_utxo_resident_get_stats(mxd_utxo_resident_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+
+    pthread_rwlock_rdlock(&resident_lock);
+    stats->entries = resident_entries;
+    stats->bytes = resident_slots ? (resident_mask + 1) * sizeof(mxd_utxo_resident_slot_t) + resident_record_bytes : 0;
+    pthread_rwlock_unlock(&resident_lock);
+}
@@ -17,6 +17,7 @@
 #include "../include/mxd_blockchain.h"
 #include "../include/mxd_logging.h"
 #include "../include/mxd_monitoring.h"
+#include "../include/mxd_crypto.h"
 #include "metrics_display.h"
 #include "memory_utils.h"
 
@@ -202,6 +203,12 @@ int main(int argc, char** argv) {
         MXD_LOG_INFO("node", "Port overridden from command line: %d", override_port);
     }
     
+    // Select hashing backends for this CPU and self-test them
+    if (mxd_crypto_init_backends() != 0) {
+        MXD_LOG_ERROR("node", "Hashing self-test failed, refusing to start");
+        return 1;
+    }
+    
     // Initialize metrics
     MXD_LOG_INFO("node", "Initializing metrics...");
     if (mxd_init_metrics(&node_metrics) != 0) {
@@ -160,36 +160,58 @@ int mxd_verify_aggregate(const mxd_proof_aggregate_t *aggregate) {
     return -1;
   }
 
-  // Verify each proof
   for (size_t i = 0; i < aggregate->count; i++) {
-    if (mxd_verify_proof(&aggregate->proofs[i],
-                         aggregate->proofs[i].public_inputs,
-                         sizeof(aggregate->proofs[i].public_inputs)) != 0) {
+    if (aggregate->proofs[i].type > MXD_PROOF_TYPE_ZK_STARK ||
+        aggregate->proofs[i].proof_size > MXD_MAX_PROOF_SIZE) {
       return -1;
     }
   }
 
-  // Verify aggregate hash
-  uint8_t computed_hash[64];
-  size_t total_size = 0;
+  // Recompute every proof commitment in one batch
+  const uint8_t **inputs = malloc(aggregate->count * sizeof(uint8_t *));
+  size_t *lengths = malloc(aggregate->count * sizeof(size_t));
+  uint8_t(*commitments)[64] = malloc(aggregate->count * 64);
+  if (!inputs || !lengths || !commitments) {
+    free(inputs);
+    free(lengths);
+    free(commitments);
+    return -1;
+  }
+
   for (size_t i = 0; i < aggregate->count; i++) {
-    total_size += aggregate->proofs[i].proof_size;
+    inputs[i] = aggregate->proofs[i].proof_data;
+    lengths[i] = aggregate->proofs[i].proof_size;
   }
 
-  uint8_t *combined = malloc(total_size);
-  if (!combined) {
+  int result = mxd_sha512_batch(inputs, lengths, commitments, aggregate->count);
+  for (size_t i = 0; result == 0 && i < aggregate->count; i++) {
+    if (memcmp(commitments[i], aggregate->proofs[i].commitment, 64) != 0) {
+      result = -1;
+    }
+  }
+
+  free(inputs);
+  free(lengths);
+  free(commitments);
+  if (result != 0) {
     return -1;
   }
 
-  size_t offset = 0;
+  // Verify aggregate hash over the concatenated proof data
+  uint8_t computed_hash[64];
+  mxd_hash_ctx_t ctx;
+  if (mxd_hash_init(&ctx, MXD_HASH_SHA512) != 0) {
+    return -1;
+  }
   for (size_t i = 0; i < aggregate->count; i++) {
-    memcpy(combined + offset, aggregate->proofs[i].proof_data,
-           aggregate->proofs[i].proof_size);
-    offset += aggregate->proofs[i].proof_size;
+    if (mxd_hash_update(&ctx, aggregate->proofs[i].proof_data,
+                        aggregate->proofs[i].proof_size) != 0) {
+      return -1;
+    }
+  }
+  if (mxd_hash_final(&ctx, computed_hash) != 0) {
+    return -1;
   }
-
-  mxd_sha512(combined, total_size, computed_hash);
-  free(combined);
 
   return memcmp(computed_hash, aggregate->aggregate_hash, 64) == 0 ? 0 : -1;
 }
@@ -0,0 +1,415 @@
+#include "../include/mxd_crypto.h"
+#include "../src/base58.h"
+#include <pthread.h>
+#include <sodium.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Per-primitive crypto micro-benchmark. Every primitive is run for at least
+// --min-time-ms at each message size and thread count, and the results are
+// written as JSON (default) or CSV so builds and CPU types can be compared.
+//
+// Usage: mxd_crypto_benchmark [--format json|csv] [--output <file>]
+//                             [--sizes 32,64,...] [--threads 1,2,...]
+//                             [--min-time-ms <ms>] [--filter <name>]
+
+#define BENCH_MAX_SIZES 16
+#define BENCH_MAX_THREADS 16
+#define BENCH_MAX_MESSAGE 65536
+#define BENCH_SIGNATURE_MAX 8192
+#define BENCH_KEY_MAX 8192
+
+typedef struct {
+  uint8_t *message;
+  uint8_t public_key[BENCH_KEY_MAX];
+  uint8_t secret_key[BENCH_KEY_MAX];
+  uint8_t signature[BENCH_SIGNATURE_MAX];
+  size_t signature_length;
+  char encoded[BENCH_MAX_MESSAGE * 2];
+  uint8_t scratch[BENCH_MAX_MESSAGE];
+} bench_state_t;
+
+typedef struct {
+  const char *name;
+  int sized;            // Runs once per message size when set
+  size_t max_size;      // Largest message size worth running (0 = no limit)
+  uint32_t max_threads; // Memory-hard primitives cap their concurrency
+  int (*prepare)(bench_state_t *state, size_t size);
+  int (*run)(bench_state_t *state, size_t size);
+} bench_primitive_t;
+
+typedef struct {
+  const char *primitive;
+  size_t size;
+  uint32_t threads;
+  uint64_t ops;
+  double seconds;
+} bench_result_t;
+
+static int prepare_none(bench_state_t *state, size_t size) {
+  (void)state;
+  (void)size;
+  return 0;
+}
+
+static int prepare_keypair(bench_state_t *state, size_t size) {
+  (void)size;
+  return mxd_dilithium_keygen(state->public_key, state->secret_key);
+}
+
+static int prepare_signature(bench_state_t *state, size_t size) {
+  if (mxd_dilithium_keygen(state->public_key, state->secret_key) != 0) {
+    return -1;
+  }
+  return mxd_dilithium_sign(state->signature, &state->signature_length,
+                            state->message, size, state->secret_key);
+}
+
+static int prepare_encoded(bench_state_t *state, size_t size) {
+  return base58_encode(state->message, size, state->encoded, sizeof(state->encoded));
+}
+
+static int run_sha1(bench_state_t *state, size_t size) {
+  return mxd_sha1(state->message, size, state->scratch);
+}
+
+static int run_sha256(bench_state_t *state, size_t size) {
+  return mxd_sha256(state->message, size, state->scratch);
+}
+
+static int run_sha512(bench_state_t *state, size_t size) {
+  return mxd_sha512(state->message, size, state->scratch);
+}
+
+static int run_ripemd160(bench_state_t *state, size_t size) {
+  return mxd_ripemd160(state->message, size, state->scratch);
+}
+
+static int run_hash160(bench_state_t *state, size_t size) {
+  return mxd_hash160(state->message, size, state->scratch);
+}
+
+static int run_argon2(bench_state_t *state, size_t size) {
+  (void)size;
+  return mxd_argon2("benchmark password", state->message, state->scratch, 32);
+}
+
+static int run_argon2_lowmem(bench_state_t *state, size_t size) {
+  (void)size;
+  return mxd_argon2_lowmem("benchmark password", state->message, state->scratch, 32);
+}
+
+static int run_keygen(bench_state_t *state, size_t size) {
+  (void)size;
+  return mxd_dilithium_keygen(state->public_key, state->secret_key);
+}
+
+static int run_sign(bench_state_t *state, size_t size) {
+  size_t signature_length = 0;
+  return mxd_dilithium_sign(state->signature, &signature_length, state->message,
+                            size, state->secret_key);
+}
+
+static int run_verify(bench_state_t *state, size_t size) {
+  return mxd_dilithium_verify(state->signature, state->signature_length,
+                              state->message, size, state->public_key);
+}
+
+static int run_base58_encode(bench_state_t *state, size_t size) {
+  return base58_encode(state->message, size, state->encoded, sizeof(state->encoded));
+}
+
+static int run_base58_decode(bench_state_t *state, size_t size) {
+  size_t out_len = sizeof(state->scratch);
+  (void)size;
+  return base58_decode(state->encoded, state->scratch, &out_len);
+}
+
+static const bench_primitive_t primitives[] = {
+  {"sha1", 1, 0, BENCH_MAX_THREADS, prepare_none, run_sha1},
+  {"sha256", 1, 0, BENCH_MAX_THREADS, prepare_none, run_sha256},
+  {"sha512", 1, 0, BENCH_MAX_THREADS, prepare_none, run_sha512},
+  {"ripemd160", 1, 0, BENCH_MAX_THREADS, prepare_none, run_ripemd160},
+  {"hash160", 1, 0, BENCH_MAX_THREADS, prepare_none, run_hash160},
+  {"argon2", 0, 0, 1, prepare_none, run_argon2},
+  {"argon2_lowmem", 0, 0, 4, prepare_none, run_argon2_lowmem},
+  {"dilithium_keygen", 0, 0, BENCH_MAX_THREADS, prepare_none, run_keygen},
+  {"dilithium_sign", 1, 0, BENCH_MAX_THREADS, prepare_keypair, run_sign},
+  {"dilithium_verify", 1, 0, BENCH_MAX_THREADS, prepare_signature, run_verify},
+  // Base58 is quadratic in the input length; addresses are ~25 bytes
+  {"base58_encode", 1, 256, BENCH_MAX_THREADS, prepare_none, run_base58_encode},
+  {"base58_decode", 1, 256, BENCH_MAX_THREADS, prepare_encoded, run_base58_decode},
+};
+
+typedef struct {
+  const bench_primitive_t *primitive;
+  size_t size;
+  double min_seconds;
+  uint64_t ops;
+  double seconds;
+  int failed;
+} bench_worker_t;
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void *bench_worker(void *arg) {
+  bench_worker_t *worker = (bench_worker_t *)arg;
+  bench_state_t *state = calloc(1, sizeof(bench_state_t));
+  if (!state || !(state->message = malloc(BENCH_MAX_MESSAGE))) {
+    worker->failed = 1;
+    free(state);
+    return NULL;
+  }
+  randombytes_buf(state->message, BENCH_MAX_MESSAGE);
+
+  if (worker->primitive->prepare(state, worker->size) != 0) {
+    worker->failed = 1;
+  } else {
+    double start = now_seconds();
+    do {
+      // Check the clock every few ops so fast primitives are not timing-bound
+      for (int i = 0; i < 16; i++) {
+        if (worker->primitive->run(state, worker->size) != 0) {
+          worker->failed = 1;
+          break;
+        }
+        worker->ops++;
+        if (!worker->primitive->sized) {
+          break;
+        }
+      }
+    } while (!worker->failed && now_seconds() - start < worker->min_seconds);
+    worker->seconds = now_seconds() - start;
+  }
+
+  free(state->message);
+  free(state);
+  return NULL;
+}
+
+static int run_benchmark(const bench_primitive_t *primitive, size_t size, uint32_t threads,
+                         double min_seconds, bench_result_t *result) {
+  pthread_t handles[BENCH_MAX_THREADS];
+  bench_worker_t workers[BENCH_MAX_THREADS];
+  memset(workers, 0, sizeof(workers));
+
+  for (uint32_t t = 0; t < threads; t++) {
+    workers[t].primitive = primitive;
+    workers[t].size = size;
+    workers[t].min_seconds = min_seconds;
+    if (pthread_create(&handles[t], NULL, bench_worker, &workers[t]) != 0) {
+      threads = t;
+      break;
+    }
+  }
+
+  // Setup (key generation, buffers) is excluded; the run takes as long as
+  // its slowest thread
+  int failed = threads == 0;
+  uint64_t ops = 0;
+  double seconds = 0.0;
+  for (uint32_t t = 0; t < threads; t++) {
+    pthread_join(handles[t], NULL);
+    failed |= workers[t].failed;
+    ops += workers[t].ops;
+    if (workers[t].seconds > seconds) {
+      seconds = workers[t].seconds;
+    }
+  }
+
+  result->primitive = primitive->name;
+  result->size = primitive->sized ? size : 0;
+  result->threads = threads;
+  result->ops = ops;
+  result->seconds = seconds;
+  return failed ? -1 : 0;
+}
+
+// ns/op is per-thread latency; ops/s and bytes/s are aggregate throughput
+static void result_rates(const bench_result_t *r, double *ns_per_op, double *ops_per_sec,
+                         double *bytes_per_sec) {
+  *ops_per_sec = r->seconds > 0 ? (double)r->ops / r->seconds : 0.0;
+  *ns_per_op = r->ops > 0 ? r->seconds * 1e9 * r->threads / (double)r->ops : 0.0;
+  *bytes_per_sec = *ops_per_sec * (double)r->size;
+}
+
+static void write_csv(FILE *out, const bench_result_t *results, size_t count) {
+  fprintf(out, "primitive,message_bytes,threads,ops,seconds,ns_per_op,ops_per_sec,bytes_per_sec\n");
+  for (size_t i = 0; i < count; i++) {
+    double ns, ops, bytes;
+    result_rates(&results[i], &ns, &ops, &bytes);
+    fprintf(out, "%s,%zu,%u,%llu,%.6f,%.1f,%.1f,%.1f\n", results[i].primitive,
+            results[i].size, results[i].threads, (unsigned long long)results[i].ops,
+            results[i].seconds, ns, ops, bytes);
+  }
+}
+
+static void write_json(FILE *out, const bench_result_t *results, size_t count,
+                       size_t signature_bytes) {
+  // Signature size identifies the scheme the library was built with
+  // (64 bytes for ed25519, 4595 for Dilithium5)
+  fprintf(out, "{\n  \"signature_bytes\": %zu,\n  \"results\": [\n", signature_bytes);
+  for (size_t i = 0; i < count; i++) {
+    double ns, ops, bytes;
+    result_rates(&results[i], &ns, &ops, &bytes);
+    fprintf(out,
+            "    {\"primitive\": \"%s\", \"message_bytes\": %zu, \"threads\": %u, "
+            "\"ops\": %llu, \"seconds\": %.6f, \"ns_per_op\": %.1f, "
+            "\"ops_per_sec\": %.1f, \"bytes_per_sec\": %.1f}%s\n",
+            results[i].primitive, results[i].size, results[i].threads,
+            (unsigned long long)results[i].ops, results[i].seconds, ns, ops, bytes,
+            i + 1 < count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+static size_t parse_list(const char *arg, size_t *values, size_t max_values) {
+  size_t count = 0;
+  const char *p = arg;
+  while (*p && count < max_values) {
+    char *end = NULL;
+    unsigned long value = strtoul(p, &end, 10);
+    if (end == p) {
+      break;
+    }
+    values[count++] = (size_t)value;
+    p = *end == ',' ? end + 1 : end;
+  }
+  return count;
+}
+
+int main(int argc, char **argv) {
+  size_t sizes[BENCH_MAX_SIZES] = {32, 64, 256, 1024, 16384};
+  size_t size_count = 5;
+  size_t thread_list[BENCH_MAX_SIZES] = {1, 4};
+  size_t thread_count = 2;
+  double min_seconds = 0.2;
+  const char *format = "json";
+  const char *output_path = NULL;
+  const char *filter = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+      format = argv[++i];
+    } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+      output_path = argv[++i];
+    } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+      size_count = parse_list(argv[++i], sizes, BENCH_MAX_SIZES);
+    } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      thread_count = parse_list(argv[++i], thread_list, BENCH_MAX_SIZES);
+    } else if (strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+      min_seconds = atof(argv[++i]) / 1000.0;
+    } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--format json|csv] [--output <file>] [--sizes 32,64,...] "
+              "[--threads 1,2,...] [--min-time-ms <ms>] [--filter <name>]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  if (strcmp(format, "json") != 0 && strcmp(format, "csv") != 0) {
+    fprintf(stderr, "Unknown format: %s\n", format);
+    return 1;
+  }
+  for (size_t i = 0; i < size_count; i++) {
+    if (sizes[i] == 0 || sizes[i] > BENCH_MAX_MESSAGE) {
+      fprintf(stderr, "Message sizes must be between 1 and %d bytes\n", BENCH_MAX_MESSAGE);
+      return 1;
+    }
+  }
+  for (size_t i = 0; i < thread_count; i++) {
+    if (thread_list[i] == 0 || thread_list[i] > BENCH_MAX_THREADS) {
+      fprintf(stderr, "Thread counts must be between 1 and %d\n", BENCH_MAX_THREADS);
+      return 1;
+    }
+  }
+  if (size_count == 0 || thread_count == 0) {
+    fprintf(stderr, "At least one message size and thread count is required\n");
+    return 1;
+  }
+
+  if (sodium_init() < 0) {
+    fprintf(stderr, "Failed to initialize libsodium\n");
+    return 1;
+  }
+
+  uint8_t probe_public_key[BENCH_KEY_MAX];
+  uint8_t probe_secret_key[BENCH_KEY_MAX];
+  uint8_t probe_signature[BENCH_SIGNATURE_MAX];
+  size_t signature_bytes = 0;
+  if (mxd_dilithium_keygen(probe_public_key, probe_secret_key) != 0 ||
+      mxd_dilithium_sign(probe_signature, &signature_bytes, (const uint8_t *)"probe", 5,
+                         probe_secret_key) != 0) {
+    fprintf(stderr, "Signature self-check failed\n");
+    return 1;
+  }
+
+  size_t primitive_count = sizeof(primitives) / sizeof(primitives[0]);
+  size_t max_results = primitive_count * size_count * thread_count;
+  bench_result_t *results = calloc(max_results, sizeof(bench_result_t));
+  if (!results) {
+    return 1;
+  }
+
+  size_t result_count = 0;
+  int failures = 0;
+  for (size_t p = 0; p < primitive_count; p++) {
+    const bench_primitive_t *primitive = &primitives[p];
+    if (filter && !strstr(primitive->name, filter)) {
+      continue;
+    }
+
+    for (size_t t = 0; t < thread_count; t++) {
+      uint32_t threads = (uint32_t)thread_list[t];
+      if (threads > primitive->max_threads) {
+        continue;
+      }
+
+      size_t runs = primitive->sized ? size_count : 1;
+      for (size_t s = 0; s < runs; s++) {
+        size_t size = primitive->sized ? sizes[s] : 16;
+        if (primitive->max_size && size > primitive->max_size) {
+          continue;
+        }
+        fprintf(stderr, "%s size=%zu threads=%u\n", primitive->name, size, threads);
+        if (run_benchmark(primitive, size, threads, min_seconds, &results[result_count]) != 0) {
+          fprintf(stderr, "  failed\n");
+          failures++;
+          continue;
+        }
+        result_count++;
+      }
+    }
+  }
+
+  FILE *out = stdout;
+  if (output_path) {
+    out = fopen(output_path, "w");
+    if (!out) {
+      fprintf(stderr, "Failed to open %s\n", output_path);
+      free(results);
+      return 1;
+    }
+  }
+
+  if (strcmp(format, "csv") == 0) {
+    write_csv(out, results, result_count);
+  } else {
+    write_json(out, results, result_count, signature_bytes);
+  }
+
+  if (out != stdout) {
+    fclose(out);
+  }
+  free(results);
+  return failures == 0 ? 0 : 1;
+}
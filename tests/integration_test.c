@@ -40,6 +40,7 @@ static void test_node_lifecycle(void) {
     
     // Initialize UTXO database
     TEST_ASSERT(mxd_init_utxo_db("./integration_test_utxo.db") == 0, "UTXO database initialization");
+    TEST_ASSERT(mxd_reset_utxo_db() == 0, "UTXO set cleared");
     
     // Create and configure nodes
     for (size_t i = 0; i < TEST_NODE_COUNT; i++) {
@@ -362,6 +363,7 @@ static void test_node_lifecycle(void) {
     
     mxd_close_utxo_db();
     mxd_init_utxo_db("./integration_test_utxo.db");
+    mxd_reset_utxo_db();
     
     TEST_END("Node Lifecycle Integration Test");
 }
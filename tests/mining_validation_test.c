@@ -31,6 +31,7 @@ static void test_mining_validation(void) {
 
   // Initialize UTXO database
   TEST_ASSERT(mxd_init_utxo_db("./mining_test_utxo.db") == 0, "UTXO database initialization");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "UTXO set cleared");
 
   // Initialize nodes with stakes and metrics
   for (size_t i = 0; i < TEST_NODE_COUNT; i++) {
@@ -307,7 +308,8 @@ static void test_mining_validation(void) {
   mxd_free_transaction(&genesis_tx);
   
   mxd_close_utxo_db();
-  mxd_init_utxo_db("./mining_test_utxo.db"); // Re-initialize to clean state
+  mxd_init_utxo_db("./mining_test_utxo.db");
+  mxd_reset_utxo_db(); // Back to a clean state
 
   TEST_END("Mining and Validation Test");
 }
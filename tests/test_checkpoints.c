@@ -61,6 +61,32 @@ static void test_checkpoint_creation(void) {
   TEST_END("Checkpoint Creation");
 }
 
+static void test_checkpoint_from_hash(void) {
+  mxd_checkpoint_manager_t manager;
+
+  TEST_START("Checkpoint From State Hash");
+  TEST_ASSERT(mxd_init_checkpoints(&manager, 1) == 0, "Manager initialization successful");
+
+  // A digest maintained elsewhere (e.g. the UTXO set commitment) is stored as is
+  uint8_t commitment[64];
+  memset(commitment, 0xA5, sizeof(commitment));
+  TEST_ASSERT(mxd_create_checkpoint_from_hash(&manager, commitment, 100,
+                                              1234567890) == 0, "Checkpoint created from hash");
+  TEST_ASSERT(memcmp(manager.checkpoints[0].state_hash, commitment, 64) == 0,
+              "State hash is the supplied digest");
+
+  commitment[0] = 0x5A;
+  TEST_ASSERT(mxd_create_checkpoint_from_hash(&manager, commitment, 100,
+                                              1234567891) == -1, "Height must increase");
+  TEST_ASSERT(mxd_create_checkpoint_from_hash(&manager, commitment, 200,
+                                              1234567891) == 0, "Second checkpoint grows the manager");
+  TEST_ASSERT(memcmp(manager.checkpoints[1].prev_hash, manager.checkpoints[0].state_hash, 64) == 0,
+              "Checkpoints are chained");
+
+  mxd_free_checkpoints(&manager);
+  TEST_END("Checkpoint From State Hash");
+}
+
 static void test_checkpoint_validation(void) {
   mxd_checkpoint_manager_t manager;
   assert(mxd_init_checkpoints(&manager, 2) == 0);
@@ -131,6 +157,7 @@ int main(void) {
 
   test_checkpoint_initialization();
   test_checkpoint_creation();
+  test_checkpoint_from_hash();
   test_checkpoint_validation();
   test_checkpoint_pruning();
   test_checkpoint_recovery();
@@ -1,4 +1,5 @@
 #include "../include/mxd_crypto.h"
+#include "../include/mxd_sigcache.h"
 #include "test_utils.h"
 #include <assert.h>
 #include <sodium.h>
@@ -19,6 +20,115 @@ static void test_sha512(void) {
   TEST_END("SHA-512");
 }
 
+static void test_streaming_hash(void) {
+  const char *input = "streaming hash test message split into chunks";
+  size_t length = strlen(input);
+  const mxd_hash_alg_t algs[] = {MXD_HASH_SHA1, MXD_HASH_SHA256,
+                                 MXD_HASH_SHA512};
+
+  TEST_START("Streaming Hash");
+
+  for (size_t a = 0; a < sizeof(algs) / sizeof(algs[0]); a++) {
+    uint8_t oneshot[64];
+    uint8_t streamed[64];
+    size_t digest_length = mxd_hash_digest_length(algs[a]);
+    TEST_ASSERT(digest_length > 0, "Digest length is known");
+
+    if (algs[a] == MXD_HASH_SHA1) {
+      TEST_ASSERT(mxd_sha1((const uint8_t *)input, length, oneshot) == 0,
+                  "One-shot SHA-1");
+    } else if (algs[a] == MXD_HASH_SHA256) {
+      TEST_ASSERT(mxd_sha256((const uint8_t *)input, length, oneshot) == 0,
+                  "One-shot SHA-256");
+    } else {
+      TEST_ASSERT(mxd_sha512((const uint8_t *)input, length, oneshot) == 0,
+                  "One-shot SHA-512");
+    }
+
+    // Repeat to exercise context reuse from the per-thread pool
+    for (int round = 0; round < 3; round++) {
+      mxd_hash_ctx_t ctx;
+      TEST_ASSERT(mxd_hash_init(&ctx, algs[a]) == 0, "Init streaming hash");
+      TEST_ASSERT(mxd_hash_update(&ctx, input, 7) == 0, "Update chunk 1");
+      TEST_ASSERT(mxd_hash_update(&ctx, input + 7, 0) == 0, "Empty update");
+      TEST_ASSERT(mxd_hash_update(&ctx, input + 7, length - 7) == 0,
+                  "Update chunk 2");
+      TEST_ASSERT(mxd_hash_final(&ctx, streamed) == 0, "Finalize hash");
+      TEST_ASSERT(memcmp(oneshot, streamed, digest_length) == 0,
+                  "Streaming digest matches one-shot digest");
+    }
+  }
+
+  mxd_hash_ctx_t aborted;
+  TEST_ASSERT(mxd_hash_init(&aborted, MXD_HASH_SHA512) == 0, "Init hash");
+  mxd_hash_abort(&aborted);
+  TEST_ASSERT(aborted.md_ctx == NULL, "Aborted context is released");
+
+  TEST_END("Streaming Hash");
+}
+
+static void test_sha512_batch(void) {
+  // Lengths straddle the 111/112 and 128-byte SHA-512 padding boundaries
+  static const size_t lengths[] = {0,   1,   55,  111, 112, 113, 127, 128,
+                                   129, 239, 240, 255, 256, 300, 1000};
+  const size_t count = sizeof(lengths) / sizeof(lengths[0]);
+  static uint8_t data[sizeof(lengths) / sizeof(lengths[0])][1000];
+  const uint8_t *inputs[sizeof(lengths) / sizeof(lengths[0])];
+  uint8_t outputs[sizeof(lengths) / sizeof(lengths[0])][64];
+
+  TEST_START("SHA-512 Batch");
+
+  for (size_t i = 0; i < count; i++) {
+    for (size_t j = 0; j < sizeof(data[i]); j++) {
+      data[i][j] = (uint8_t)(i * 31 + j * 7);
+    }
+    inputs[i] = data[i];
+  }
+
+  TEST_ASSERT(mxd_sha512_batch(inputs, lengths, outputs, count) == 0,
+              "Batch hash succeeds");
+  for (size_t i = 0; i < count; i++) {
+    uint8_t expected[64];
+    TEST_ASSERT(mxd_sha512(inputs[i], lengths[i], expected) == 0,
+                "Reference hash succeeds");
+    TEST_ASSERT(memcmp(expected, outputs[i], 64) == 0,
+                "Batch digest matches single-message digest");
+  }
+
+  TEST_ASSERT(mxd_sha512_batch(inputs, lengths, outputs, 0) == 0,
+              "Empty batch is a no-op");
+
+  TEST_END("SHA-512 Batch");
+}
+
+static void test_backend_selection(void) {
+  mxd_crypto_backend_info_t info;
+
+  TEST_START("Hash Backend Selection");
+
+  TEST_ASSERT(mxd_crypto_init_backends() == 0, "Known-answer self-tests passed");
+  mxd_crypto_get_backend_info(&info);
+  TEST_ASSERT(info.self_test_passed == 1, "Self-test result reported");
+  TEST_ASSERT(info.sha256_backend && info.sha512_backend && info.sha512_batch_backend,
+              "Backends named");
+  TEST_VALUE("SHA-256 backend", "%s", info.sha256_backend);
+  TEST_VALUE("SHA-512 batch backend", "%s", info.sha512_batch_backend);
+
+  // A batch kernel is only chosen when the CPU has the instructions for it
+  if (strcmp(info.sha512_batch_backend, "avx512") == 0) {
+    TEST_ASSERT(info.cpu_features & MXD_CPU_FEATURE_AVX512F, "AVX-512 kernel requires AVX-512F");
+  } else if (strcmp(info.sha512_batch_backend, "avx2") == 0) {
+    TEST_ASSERT(info.cpu_features & MXD_CPU_FEATURE_AVX2, "AVX2 kernel requires AVX2");
+  } else {
+    TEST_ASSERT(strcmp(info.sha512_batch_backend, "scalar") == 0, "Scalar fallback selected");
+  }
+  TEST_ASSERT((strcmp(info.sha256_backend, "openssl (cpu: sha-ni)") == 0) ==
+                  ((info.cpu_features & MXD_CPU_FEATURE_SHA_NI) != 0),
+              "SHA-NI reported consistently");
+
+  TEST_END("Hash Backend Selection");
+}
+
 static void test_ripemd160(void) {
   const char *input = "test message";
   uint8_t output[20];
@@ -33,6 +143,66 @@ static void test_ripemd160(void) {
   TEST_END("RIPEMD-160");
 }
 
+static void test_muhash(void) {
+  const uint8_t a[] = "utxo a";
+  const uint8_t b[] = "utxo b";
+  const uint8_t c[] = "utxo c";
+  uint8_t empty_digest[64], forward[64], backward[64], digest[64];
+
+  TEST_START("MuHash Set Hash");
+
+  mxd_muhash_t first, second;
+  mxd_muhash_init(&first);
+  TEST_ASSERT(mxd_muhash_final(&first, empty_digest) == 0, "Empty set finalizes");
+
+  TEST_ASSERT(mxd_muhash_insert(&first, a, sizeof(a)) == 0 &&
+                  mxd_muhash_insert(&first, b, sizeof(b)) == 0 &&
+                  mxd_muhash_insert(&first, c, sizeof(c)) == 0,
+              "Elements inserted");
+  mxd_muhash_init(&second);
+  mxd_muhash_insert(&second, c, sizeof(c));
+  mxd_muhash_insert(&second, a, sizeof(a));
+  mxd_muhash_insert(&second, b, sizeof(b));
+  mxd_muhash_final(&first, forward);
+  mxd_muhash_final(&second, backward);
+  TEST_ARRAY("Digest of {a, b, c}", forward, 64);
+  TEST_ASSERT(memcmp(forward, backward, 64) == 0, "Digest does not depend on insertion order");
+  TEST_ASSERT(memcmp(forward, empty_digest, 64) != 0, "Non-empty set differs from the empty set");
+
+  // Removal before insertion still cancels out
+  mxd_muhash_init(&second);
+  mxd_muhash_remove(&second, b, sizeof(b));
+  mxd_muhash_insert(&second, a, sizeof(a));
+  mxd_muhash_insert(&second, b, sizeof(b));
+  mxd_muhash_final(&second, digest);
+  mxd_muhash_t only_a;
+  mxd_muhash_init(&only_a);
+  mxd_muhash_insert(&only_a, a, sizeof(a));
+  mxd_muhash_final(&only_a, backward);
+  TEST_ASSERT(memcmp(digest, backward, 64) == 0, "Removal cancels an insertion in any order");
+
+  mxd_muhash_remove(&first, a, sizeof(a));
+  mxd_muhash_remove(&first, b, sizeof(b));
+  mxd_muhash_remove(&first, c, sizeof(c));
+  mxd_muhash_final(&first, digest);
+  TEST_ASSERT(memcmp(digest, empty_digest, 64) == 0, "Removing every element yields the empty set");
+
+  // Combining {a} with {b, c} gives {a, b, c}
+  mxd_muhash_init(&second);
+  mxd_muhash_insert(&second, b, sizeof(b));
+  mxd_muhash_insert(&second, c, sizeof(c));
+  TEST_ASSERT(mxd_muhash_combine(&only_a, &second) == 0, "Accumulators combine");
+  mxd_muhash_final(&only_a, digest);
+  TEST_ASSERT(memcmp(digest, forward, 64) == 0, "Combined digest matches the union");
+
+  // Multiset: a duplicate element changes the digest
+  mxd_muhash_insert(&only_a, a, sizeof(a));
+  mxd_muhash_final(&only_a, digest);
+  TEST_ASSERT(memcmp(digest, forward, 64) != 0, "Duplicate element is counted");
+
+  TEST_END("MuHash Set Hash");
+}
+
 static void test_argon2(void) {
   const char *input = "test password";
   const uint8_t salt[16] = "MXDTestSalt1234";
@@ -78,6 +248,118 @@ static void test_dilithium(void) {
   TEST_END("Dilithium");
 }
 
+static void test_dilithium_verify_batch(void) {
+  enum { BATCH = 24 };
+  uint8_t public_keys[BATCH][crypto_sign_PUBLICKEYBYTES];
+  uint8_t secret_key[crypto_sign_SECRETKEYBYTES];
+  uint8_t messages[BATCH][32];
+  uint8_t signatures[BATCH][crypto_sign_BYTES];
+  mxd_sig_verify_item_t items[BATCH];
+  int results[BATCH];
+
+  TEST_START("Dilithium Batch Verification");
+
+  for (int i = 0; i < BATCH; i++) {
+    size_t signature_length = 0;
+    memset(messages[i], i, sizeof(messages[i]));
+    TEST_ASSERT(mxd_dilithium_keygen(public_keys[i], secret_key) == 0, "Key generation successful");
+    TEST_ASSERT(mxd_dilithium_sign(signatures[i], &signature_length, messages[i],
+                                   sizeof(messages[i]), secret_key) == 0,
+                "Message signing successful");
+    items[i].signature = signatures[i];
+    items[i].signature_length = signature_length;
+    items[i].message = messages[i];
+    items[i].message_length = sizeof(messages[i]);
+    items[i].public_key = public_keys[i];
+  }
+
+  TEST_ASSERT(mxd_dilithium_verify_batch(items, BATCH, results) == 0, "Valid batch verifies");
+  int all_valid = 1;
+  for (int i = 0; i < BATCH; i++) {
+    all_valid &= results[i] == 0;
+  }
+  TEST_ASSERT(all_valid, "Every item reported valid");
+
+  // Corrupt one signature and swap one key; only those items may fail
+  signatures[5][0] ^= 0x01;
+  items[17].public_key = public_keys[3];
+  TEST_ASSERT(mxd_dilithium_verify_batch(items, BATCH, results) != 0, "Tampered batch rejected");
+  int per_item_ok = 1;
+  for (int i = 0; i < BATCH; i++) {
+    int expect_fail = (i == 5 || i == 17);
+    per_item_ok &= expect_fail ? results[i] != 0 : results[i] == 0;
+  }
+  TEST_ASSERT(per_item_ok, "Failures reported per item");
+
+  // Small batches are verified inline and agree with the single-item API
+  TEST_ASSERT(mxd_dilithium_verify_batch(items, 2, results) == 0, "Small batch verifies");
+  TEST_ASSERT(mxd_dilithium_verify_batch(NULL, 0, NULL) == 0, "Empty batch succeeds");
+
+  TEST_END("Dilithium Batch Verification");
+}
+
+static void test_signature_cache(void) {
+  uint8_t public_key[crypto_sign_PUBLICKEYBYTES];
+  uint8_t other_key[crypto_sign_PUBLICKEYBYTES];
+  uint8_t secret_key[crypto_sign_SECRETKEYBYTES];
+  uint8_t signature[crypto_sign_BYTES];
+  size_t signature_length = 0;
+  const uint8_t message[] = "cached verification";
+  mxd_sigcache_stats_t stats;
+
+  TEST_START("Signature Cache");
+
+  TEST_ASSERT(mxd_sigcache_init(64) == 0, "Cache initialized");
+  TEST_ASSERT(mxd_dilithium_keygen(other_key, secret_key) == 0, "Key generation successful");
+  TEST_ASSERT(mxd_dilithium_keygen(public_key, secret_key) == 0, "Key generation successful");
+  TEST_ASSERT(mxd_dilithium_sign(signature, &signature_length, message, sizeof(message),
+                                 secret_key) == 0, "Message signing successful");
+
+  TEST_ASSERT(mxd_dilithium_verify_cached(signature, signature_length, message,
+                                          sizeof(message), public_key) == 0,
+              "First verification succeeds");
+  mxd_sigcache_get_stats(&stats);
+  TEST_ASSERT(stats.misses == 1 && stats.insertions == 1 && stats.entries == 1,
+              "Successful verification recorded");
+
+  TEST_ASSERT(mxd_dilithium_verify_cached(signature, signature_length, message,
+                                          sizeof(message), public_key) == 0,
+              "Second verification succeeds");
+  mxd_sigcache_get_stats(&stats);
+  TEST_ASSERT(stats.hits == 1, "Second verification served from cache");
+
+  // Any change to the tuple must miss and be checked for real
+  TEST_ASSERT(mxd_dilithium_verify_cached(signature, signature_length, message,
+                                          sizeof(message), other_key) != 0,
+              "Wrong key rejected");
+  signature[0] ^= 0x01;
+  TEST_ASSERT(mxd_dilithium_verify_cached(signature, signature_length, message,
+                                          sizeof(message), public_key) != 0,
+              "Tampered signature rejected");
+  signature[0] ^= 0x01;
+  mxd_sigcache_get_stats(&stats);
+  TEST_ASSERT(stats.insertions == 1, "Failures are not cached");
+
+  // The cache stays within its bound under churn
+  for (int i = 0; i < 1000; i++) {
+    uint8_t key[MXD_SIGCACHE_KEY_SIZE];
+    TEST_ASSERT(mxd_sigcache_compute_key(public_key, sizeof(public_key), (const uint8_t *)&i,
+                                         sizeof(i), signature, signature_length, key) == 0,
+                "Key derived");
+    mxd_sigcache_insert(key);
+  }
+  mxd_sigcache_get_stats(&stats);
+  TEST_ASSERT(stats.entries <= stats.capacity && stats.evictions > 0, "Cache bounded");
+
+  mxd_sigcache_clear();
+  mxd_sigcache_get_stats(&stats);
+  TEST_ASSERT(stats.entries == 0, "Cache cleared");
+
+  TEST_ASSERT(mxd_sigcache_init(MXD_SIGCACHE_DEFAULT_ENTRIES) == 0, "Cache restored to default size");
+
+  TEST_END("Signature Cache");
+}
+
 int main(void) {
   TEST_START("Cryptographic Tests");
   
@@ -88,13 +370,19 @@ int main(void) {
 
   // ISO/IEC 10118-3 (Hash Functions)
   test_sha512();
+  test_streaming_hash();
+  test_sha512_batch();
+  test_backend_selection();
   test_ripemd160();
+  test_muhash();
 
   // ISO/IEC 11889 (Key Derivation)
   test_argon2();
 
   // ISO/IEC 18033-3 (Post-Quantum Signatures)
   test_dilithium();
+  test_dilithium_verify_batch();
+  test_signature_cache();
 
   TEST_END("Cryptographic Tests");
   return 0;
@@ -86,6 +86,9 @@ static void test_monitoring_system(void) {
     const char *prometheus_metrics = mxd_get_prometheus_metrics();
     TEST_ASSERT(prometheus_metrics != NULL, "Prometheus metrics generated");
     TEST_ASSERT(strstr(prometheus_metrics, "mxd_tps_current 25.50") != NULL, "TPS metric present");
+    TEST_ASSERT(strstr(prometheus_metrics, "mxd_crypto_backend_info{sha256=") != NULL, "Crypto backend metric present");
+    TEST_ASSERT(strstr(prometheus_metrics, "mxd_crypto_self_test_passed 1") != NULL, "Crypto self-test metric present");
+    TEST_ASSERT(strstr(prometheus_metrics, "mxd_utxo_cache_hits_total ") != NULL, "UTXO cache metric present");
     
     const char *health_json = mxd_get_health_json();
     TEST_ASSERT(health_json != NULL, "Health JSON generated");
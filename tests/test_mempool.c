@@ -2,6 +2,8 @@
 #include "../include/mxd_mempool.h"
 #include "test_utils.h"
 #include <assert.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h> // For sleep
@@ -124,6 +126,363 @@ static void test_mempool_cleaning(void) {
   printf("Mempool cleaning test passed\n");
 }
 
+static void test_mempool_ordering(void) {
+  uint8_t key[256] = {7};
+  uint8_t hashes[600][64];
+  mxd_transaction_t tx;
+
+  TEST_START("Mempool Index And Ordering");
+  mxd_init_mempool();
+
+  // Tips and priorities interleaved so insertion order is not sorted
+  for (int i = 0; i < 600; i++) {
+    TEST_ASSERT(mxd_create_transaction(&tx) == 0, "Create transaction");
+    mxd_add_tx_output(&tx, key, 1.0 + i);
+    mxd_set_voluntary_tip(&tx, (double)((i * 37) % 101));
+    mxd_calculate_tx_hash(&tx, hashes[i]);
+    TEST_ASSERT(mxd_add_to_mempool(&tx, (mxd_tx_priority_t)(i % 3)) == 0, "Add transaction");
+    if (i == 0) {
+      TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_HIGH) == -1, "Duplicate rejected");
+    }
+    mxd_free_transaction(&tx);
+  }
+  TEST_ASSERT(mxd_get_mempool_size() == 600, "All transactions admitted");
+
+  // Remove every fourth transaction; the rest stay reachable by hash
+  for (int i = 0; i < 600; i += 4) {
+    TEST_ASSERT(mxd_remove_from_mempool(hashes[i]) == 0, "Remove transaction");
+  }
+  TEST_ASSERT(mxd_remove_from_mempool(hashes[0]) == -1, "Removed transaction gone");
+  TEST_ASSERT(mxd_get_mempool_size() == 450, "Size after removals");
+  int reachable = 1;
+  size_t expected = 0;
+  for (int i = 1; i < 600; i++) {
+    mxd_transaction_t found;
+    int present = mxd_get_from_mempool(hashes[i], &found) == 0;
+    if (present) {
+      mxd_free_transaction(&found);
+    }
+    reachable &= present == (i % 4 != 0);
+    expected += i % 4 != 0 && i % 3 != MXD_PRIORITY_LOW;
+  }
+  TEST_ASSERT(reachable, "Lookups match the remaining set");
+
+  // Best-first: priority descending, then tip descending
+  static mxd_transaction_t txs[450];
+  size_t count = 450;
+  TEST_ASSERT(mxd_get_priority_transactions(txs, &count, MXD_PRIORITY_MEDIUM) == 0,
+              "Get medium and high priority transactions");
+  TEST_ASSERT(count == expected, "Low priority entries excluded");
+  int ordered = 1;
+  for (size_t i = 0; i < count; i++) {
+    uint8_t hash[64];
+    mxd_calculate_tx_hash(&txs[i], hash);
+    int index = 0;
+    while (memcmp(hashes[index], hash, 64) != 0) {
+      index++;
+    }
+    if (i > 0) {
+      uint8_t prev_hash[64];
+      mxd_calculate_tx_hash(&txs[i - 1], prev_hash);
+      int prev = 0;
+      while (memcmp(hashes[prev], prev_hash, 64) != 0) {
+        prev++;
+      }
+      if (prev % 3 < index % 3 ||
+          (prev % 3 == index % 3 && txs[i - 1].voluntary_tip < txs[i].voluntary_tip)) {
+        ordered = 0;
+      }
+    }
+  }
+  TEST_ASSERT(ordered, "Transactions returned best first");
+  for (size_t i = 0; i < count; i++) {
+    mxd_free_transaction(&txs[i]);
+  }
+
+  TEST_ASSERT(mxd_clean_mempool(0) == 0, "Clean mempool");
+  TEST_END("Mempool Index And Ordering");
+}
+
+// Transaction spending (prev_hash, index) with one output and the given tip
+static void build_spend(mxd_transaction_t *tx, const uint8_t prev_hash[64], uint32_t index,
+                        double amount, double tip, uint8_t hash[64]) {
+  uint8_t key[256] = {9};
+  mxd_create_transaction(tx);
+  mxd_add_tx_input(tx, prev_hash, index, key);
+  mxd_add_tx_output(tx, key, amount);
+  mxd_set_voluntary_tip(tx, tip);
+  mxd_calculate_tx_hash(tx, hash);
+}
+
+static void test_mempool_conflicts(void) {
+  uint8_t funding[64] = {1};
+  uint8_t parent_hash[64], child_hash[64], grandchild_hash[64];
+  uint8_t low_hash[64], replacement_hash[64], spender[64];
+  mxd_transaction_t parent, child, grandchild, low, replacement;
+
+  TEST_START("Mempool Conflicts And Replacement");
+  mxd_init_mempool();
+
+  // A chain spending one funding output: parent <- child <- grandchild
+  build_spend(&parent, funding, 0, 10.0, 2.0, parent_hash);
+  build_spend(&child, parent_hash, 0, 9.0, 1.0, child_hash);
+  build_spend(&grandchild, child_hash, 0, 8.0, 1.0, grandchild_hash);
+  TEST_ASSERT(mxd_add_to_mempool(&parent, MXD_PRIORITY_MEDIUM) == 0, "Add parent");
+  TEST_ASSERT(mxd_add_to_mempool(&child, MXD_PRIORITY_MEDIUM) == 0, "Add child");
+  TEST_ASSERT(mxd_add_to_mempool(&grandchild, MXD_PRIORITY_MEDIUM) == 0, "Add grandchild");
+  TEST_ASSERT(mxd_get_mempool_spender(funding, 0, spender) == 0 &&
+                  memcmp(spender, parent_hash, 64) == 0,
+              "Funding output spent by parent");
+
+  // Spending the same output must beat the chain's combined tip of 4
+  build_spend(&low, funding, 0, 10.0, 4.0, low_hash);
+  TEST_ASSERT(mxd_add_to_mempool(&low, MXD_PRIORITY_HIGH) == -1, "Conflict with lower tip rejected");
+  TEST_ASSERT(mxd_get_mempool_size() == 3, "Chain left in place");
+
+  build_spend(&replacement, funding, 0, 10.0, 5.0, replacement_hash);
+  TEST_ASSERT(mxd_add_to_mempool(&replacement, MXD_PRIORITY_MEDIUM) == 0, "Higher tip replaces");
+  TEST_ASSERT(mxd_get_mempool_size() == 1, "Descendants evicted with the replaced transaction");
+  mxd_transaction_t found;
+  TEST_ASSERT(mxd_get_from_mempool(child_hash, &found) == -1, "Child evicted");
+  TEST_ASSERT(mxd_get_mempool_spender(parent_hash, 0, spender) == -1, "Evicted spends forgotten");
+  TEST_ASSERT(mxd_get_mempool_spender(funding, 0, spender) == 0 &&
+                  memcmp(spender, replacement_hash, 64) == 0,
+              "Funding output spent by replacement");
+
+  // NaN and infinite tips never replace anything
+  const double bad_tips[] = {NAN, INFINITY};
+  for (int i = 0; i < 2; i++) {
+    mxd_transaction_t bad;
+    uint8_t bad_hash[64];
+    build_spend(&bad, funding, 0, 10.0, 1.0, bad_hash);
+    TEST_ASSERT(mxd_set_voluntary_tip(&bad, bad_tips[i]) == -1, "Non-finite tip refused by setter");
+    bad.voluntary_tip = bad_tips[i];
+    TEST_ASSERT(mxd_add_to_mempool(&bad, MXD_PRIORITY_HIGH) == -1, "Non-finite tip rejected");
+    mxd_free_transaction(&bad);
+  }
+  TEST_ASSERT(mxd_get_mempool_size() == 1, "Replacement left in place");
+  TEST_ASSERT(mxd_get_mempool_spender(funding, 0, spender) == 0 &&
+                  memcmp(spender, replacement_hash, 64) == 0,
+              "Funding output still spent by replacement");
+
+  // Spending one outpoint twice is never admitted
+  mxd_transaction_t twice;
+  uint8_t twice_hash[64], key[256] = {9};
+  build_spend(&twice, replacement_hash, 0, 1.0, 50.0, twice_hash);
+  mxd_add_tx_input(&twice, replacement_hash, 0, key);
+  TEST_ASSERT(mxd_add_to_mempool(&twice, MXD_PRIORITY_HIGH) == -1, "Duplicate inputs rejected");
+  mxd_free_transaction(&twice);
+
+  // A confirmed conflicting spend clears the replacement
+  TEST_ASSERT(mxd_remove_mempool_conflicts(&replacement) == 0, "Transaction does not conflict with itself");
+  TEST_ASSERT(mxd_remove_mempool_conflicts(&parent) == 1, "Confirmed conflict removed");
+  TEST_ASSERT(mxd_get_mempool_size() == 0, "Mempool empty");
+
+  // Replacing a chain longer than MXD_MEMPOOL_MAX_REPLACED is refused
+  uint8_t prev[64];
+  memcpy(prev, funding, 64);
+  for (int i = 0; i <= MXD_MEMPOOL_MAX_REPLACED; i++) {
+    mxd_transaction_t link;
+    uint8_t link_hash[64];
+    build_spend(&link, prev, 0, 10.0, 0.0, link_hash);
+    mxd_add_to_mempool(&link, MXD_PRIORITY_LOW);
+    mxd_free_transaction(&link);
+    memcpy(prev, link_hash, 64);
+  }
+  TEST_ASSERT(mxd_get_mempool_size() == MXD_MEMPOOL_MAX_REPLACED + 1, "Long chain admitted");
+  TEST_ASSERT(mxd_add_to_mempool(&replacement, MXD_PRIORITY_HIGH) == -1, "Replacement limit enforced");
+  TEST_ASSERT(mxd_remove_mempool_conflicts(&replacement) == MXD_MEMPOOL_MAX_REPLACED + 1,
+              "Confirmed conflict removes the whole chain");
+
+  mxd_free_transaction(&parent);
+  mxd_free_transaction(&child);
+  mxd_free_transaction(&grandchild);
+  mxd_free_transaction(&low);
+  mxd_free_transaction(&replacement);
+  TEST_END("Mempool Conflicts And Replacement");
+}
+
+#define CONCURRENT_THREADS 4
+#define CONCURRENT_TXS 200
+
+// Each thread submits its own transactions plus competing spends of one
+// shared outpoint
+static void *submit_transactions(void *arg) {
+  int thread = (int)(intptr_t)arg;
+  uint8_t shared[64] = {0xAA};
+  uint8_t hash[64];
+  for (int i = 0; i < CONCURRENT_TXS; i++) {
+    mxd_transaction_t tx;
+    uint8_t funding[64] = {2, (uint8_t)thread, (uint8_t)i, (uint8_t)(i >> 8)};
+    build_spend(&tx, funding, 0, 1.0, (double)i, hash);
+    mxd_add_to_mempool(&tx, (mxd_tx_priority_t)(i % 3));
+    mxd_free_transaction(&tx);
+
+    build_spend(&tx, shared, 0, 1.0 + thread, (double)(i * CONCURRENT_THREADS + thread), hash);
+    mxd_add_to_mempool(&tx, MXD_PRIORITY_HIGH);
+    mxd_free_transaction(&tx);
+  }
+  return NULL;
+}
+
+static void *read_transactions(void *arg) {
+  static mxd_transaction_t txs[64];
+  for (int i = 0; i < 200; i++) {
+    size_t count = 64;
+    if (mxd_get_priority_transactions(txs, &count, MXD_PRIORITY_LOW) == 0) {
+      for (size_t j = 0; j < count; j++) {
+        mxd_free_transaction(&txs[j]);
+      }
+    }
+  }
+  return NULL;
+}
+
+static void test_mempool_concurrency(void) {
+  pthread_t writers[CONCURRENT_THREADS], reader;
+  uint8_t shared[64] = {0xAA}, spender[64];
+  mxd_transaction_t found;
+
+  TEST_START("Mempool Concurrent Admission");
+  mxd_init_mempool();
+
+  TEST_ASSERT(pthread_create(&reader, NULL, read_transactions, NULL) == 0, "Start reader");
+  for (int i = 0; i < CONCURRENT_THREADS; i++) {
+    TEST_ASSERT(pthread_create(&writers[i], NULL, submit_transactions, (void *)(intptr_t)i) == 0,
+                "Start writer");
+  }
+  for (int i = 0; i < CONCURRENT_THREADS; i++) {
+    pthread_join(writers[i], NULL);
+  }
+  pthread_join(reader, NULL);
+
+  // Every independent transaction plus exactly one spend of the shared outpoint
+  TEST_ASSERT(mxd_get_mempool_size() == CONCURRENT_THREADS * CONCURRENT_TXS + 1,
+              "All independent transactions and one shared spend admitted");
+  TEST_ASSERT(mxd_get_mempool_spender(shared, 0, spender) == 0, "Shared outpoint has one spender");
+  TEST_ASSERT(mxd_get_from_mempool(spender, &found) == 0, "Spender reachable by hash");
+  TEST_VALUE("Winning tip", "%.1f", found.voluntary_tip);
+  TEST_ASSERT(found.voluntary_tip >= (CONCURRENT_TXS - 1) * CONCURRENT_THREADS,
+              "Highest tips won the shared outpoint");
+  mxd_free_transaction(&found);
+
+  // Selection reads a snapshot that follows later changes to the pool
+  static mxd_transaction_t txs[CONCURRENT_THREADS * CONCURRENT_TXS + 1];
+  size_t count = CONCURRENT_THREADS * CONCURRENT_TXS + 1;
+  TEST_ASSERT(mxd_get_priority_transactions(txs, &count, MXD_PRIORITY_LOW) == 0 &&
+                  count == mxd_get_mempool_size(),
+              "Snapshot covers the whole pool");
+  for (size_t i = 0; i < count; i++) {
+    mxd_free_transaction(&txs[i]);
+  }
+  TEST_ASSERT(mxd_remove_from_mempool(spender) == 0, "Remove the shared spend");
+  count = CONCURRENT_THREADS * CONCURRENT_TXS + 1;
+  TEST_ASSERT(mxd_get_priority_transactions(txs, &count, MXD_PRIORITY_HIGH) == 0,
+              "Select after removal");
+  int stale = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint8_t hash[64];
+    mxd_calculate_tx_hash(&txs[i], hash);
+    stale |= memcmp(hash, spender, 64) == 0;
+    mxd_free_transaction(&txs[i]);
+  }
+  TEST_ASSERT(!stale, "Removed transaction not selected");
+
+  TEST_ASSERT(mxd_clean_mempool(0) == 0, "Clean mempool");
+  TEST_END("Mempool Concurrent Admission");
+}
+
+static void test_mempool_budget(void) {
+  uint8_t hashes[10][64], parent_hash[64], child_hash[64], hash[64];
+  mxd_transaction_t tx, found;
+
+  TEST_START("Mempool Byte Budget And Fee-Rate Eviction");
+  mxd_init_mempool();
+
+  // A parent paying almost nothing with a well-paying child, then eight
+  // independent transactions with tips 2..9, all of the same size
+  uint8_t funding[64] = {3};
+  build_spend(&tx, funding, 0, 1.0, 0.1, parent_hash);
+  TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_MEDIUM) == 0, "Add parent");
+  mxd_free_transaction(&tx);
+  size_t entry_bytes = mxd_get_mempool_bytes();
+  TEST_VALUE("Entry bytes", "%zu", entry_bytes);
+  TEST_ASSERT(mxd_set_mempool_max_bytes(10 * entry_bytes) == 0, "Budget of ten entries");
+  build_spend(&tx, parent_hash, 0, 1.0, 5.0, child_hash);
+  TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_MEDIUM) == 0, "Add child");
+  mxd_free_transaction(&tx);
+  for (int i = 2; i < 10; i++) {
+    funding[1] = (uint8_t)i;
+    build_spend(&tx, funding, 0, 1.0, (double)i, hashes[i]);
+    TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_MEDIUM) == 0, "Add transaction");
+    mxd_free_transaction(&tx);
+  }
+  TEST_ASSERT(mxd_get_mempool_bytes() == 10 * entry_bytes, "Pool at budget");
+  TEST_ASSERT(mxd_get_mempool_min_fee_rate() == 0.0, "No minimum fee rate before eviction");
+
+  // Full: a lower fee rate than everything pooled does not get in
+  funding[1] = 100;
+  build_spend(&tx, funding, 0, 1.0, 0.05, hash);
+  TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_HIGH) == -1, "Lowest fee rate rejected when full");
+  mxd_free_transaction(&tx);
+
+  // A better rate evicts the cheapest entry together with its child
+  funding[1] = 101;
+  build_spend(&tx, funding, 0, 1.0, 20.0, hash);
+  TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_LOW) == 0, "Higher fee rate admitted when full");
+  mxd_free_transaction(&tx);
+  TEST_ASSERT(mxd_get_mempool_size() == 9, "Cheapest entry evicted with its descendant");
+  TEST_ASSERT(mxd_get_from_mempool(parent_hash, &found) == -1, "Parent evicted");
+  TEST_ASSERT(mxd_get_from_mempool(child_hash, &found) == -1, "Child evicted");
+  TEST_ASSERT(mxd_get_mempool_bytes() <= 10 * entry_bytes, "Budget respected");
+
+  // The minimum rate now sits above what was evicted
+  double min_rate = mxd_get_mempool_min_fee_rate();
+  TEST_VALUE("Minimum fee rate", "%g", min_rate);
+  TEST_ASSERT(min_rate > 0.1 / (double)entry_bytes, "Minimum fee rate raised");
+  funding[1] = 102;
+  build_spend(&tx, funding, 0, 1.0, 0.1, hash);
+  TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_HIGH) == -1, "Below minimum fee rate rejected");
+  mxd_free_transaction(&tx);
+
+  // A NaN tip neither passes the minimum fee rate nor evicts paying entries
+  funding[1] = 104;
+  build_spend(&tx, funding, 0, 1.0, 1.0, hash);
+  tx.voluntary_tip = NAN;
+  TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_HIGH) == -1, "NaN tip rejected when full");
+  mxd_free_transaction(&tx);
+  TEST_ASSERT(mxd_get_mempool_size() == 9, "Nothing evicted for a NaN tip");
+  TEST_ASSERT(mxd_get_from_mempool(hashes[2], &found) == 0, "Cheapest paying entry kept");
+  mxd_free_transaction(&found);
+
+  // Shrinking the budget evicts from the lowest rate up
+  TEST_ASSERT(mxd_set_mempool_max_bytes(5 * entry_bytes) == 0, "Shrink budget");
+  TEST_ASSERT(mxd_get_mempool_size() == 5, "Pool trimmed to budget");
+  TEST_ASSERT(mxd_get_from_mempool(hashes[5], &found) == -1, "Low rates evicted");
+  TEST_ASSERT(mxd_get_from_mempool(hashes[6], &found) == 0, "High rates kept");
+  mxd_free_transaction(&found);
+
+  // A long chain hanging off the cheapest root goes in one eviction
+  mxd_init_mempool();
+  TEST_ASSERT(mxd_set_mempool_max_bytes(3000 * entry_bytes) == 0, "Budget for a long chain");
+  uint8_t prev[64] = {4};
+  for (int i = 0; i < 3000; i++) {
+    build_spend(&tx, prev, 0, 1.0, i == 0 ? 0.0 : 1.0, hash);
+    TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_LOW) == 0, "Add chain link");
+    mxd_free_transaction(&tx);
+    memcpy(prev, hash, 64);
+  }
+  funding[1] = 103;
+  build_spend(&tx, funding, 0, 1.0, 10.0, hash);
+  TEST_ASSERT(mxd_add_to_mempool(&tx, MXD_PRIORITY_LOW) == 0, "Admission evicts the chain");
+  mxd_free_transaction(&tx);
+  TEST_ASSERT(mxd_get_mempool_size() == 1, "Whole chain evicted with its root");
+
+  TEST_ASSERT(mxd_set_mempool_max_bytes(0) == 0, "Restore default budget");
+  TEST_ASSERT(mxd_clean_mempool(0) == 0, "Clean mempool");
+  TEST_END("Mempool Byte Budget And Fee-Rate Eviction");
+}
+
 int main(void) {
   printf("Starting mempool tests...\n");
 
@@ -131,6 +490,10 @@ int main(void) {
   test_transaction_management();
   test_priority_handling();
   test_mempool_cleaning();
+  test_mempool_ordering();
+  test_mempool_conflicts();
+  test_mempool_concurrency();
+  test_mempool_budget();
 
   printf("All mempool tests passed\n");
   return 0;
@@ -80,21 +80,25 @@ int test_p2p_networking(void) {
     TEST_VALUE("Message length", "%zu", msg_len);
     TEST_ASSERT(mxd_broadcast_message(MXD_MSG_PEERS, test_msg, msg_len) == 0, "Valid message accepted");
     
-    // Test all message types
-    for (mxd_message_type_t type = MXD_MSG_HANDSHAKE; type <= MXD_MSG_TRANSACTIONS; type++) {
+    // Test all message types; transaction lists must be wire-encoded
+    for (mxd_message_type_t type = MXD_MSG_HANDSHAKE; type < MXD_MSG_TRANSACTIONS; type++) {
         TEST_ASSERT(mxd_broadcast_message(type, test_msg, msg_len) == 0, "Message type valid");
     }
+    TEST_ASSERT(mxd_broadcast_message(MXD_MSG_TRANSACTIONS, test_msg, msg_len) != 0, "Unencoded transaction list rejected");
     
     // Test invalid message type
     TEST_ASSERT(mxd_broadcast_message(MXD_MSG_TRANSACTIONS + 1, test_msg, msg_len) != 0, "Invalid message type rejected");
     
     // Test rate limiting
+    mxd_transaction_t tx;
+    TEST_ASSERT(mxd_create_coinbase_transaction(&tx, public_key, 1.0) == 0, "Test transaction created");
     mxd_reset_rate_limit();
     clock_t start = clock();
     for (int i = 0; i < 10; i++) {
-        TEST_ASSERT(mxd_broadcast_message(MXD_MSG_TRANSACTIONS, test_msg, msg_len) == 0, "Transaction validation within rate limit");
+        TEST_ASSERT(mxd_broadcast_transactions(&tx, 1) == 0, "Transaction validation within rate limit");
     }
     clock_t end = clock();
+    mxd_free_transaction(&tx);
     double time_taken = ((double)(end - start)) / CLOCKS_PER_SEC;
     TEST_ASSERT(time_taken <= 1.0, "Transaction rate meets 10 TPS requirement");
     
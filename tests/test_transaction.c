@@ -1,8 +1,10 @@
 #include "../include/mxd_crypto.h"
 #include "../include/mxd_transaction.h"
+#include "../include/mxd_tx_wire.h"
 #include "test_utils.h"
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static void test_transaction_creation(void) {
@@ -149,6 +151,270 @@ static void test_transaction_hashing(void) {
   printf("Transaction hashing test passed\n");
 }
 
+static void test_transaction_sign_inputs(void) {
+  mxd_transaction_t tx;
+  uint8_t prev_hash[64] = {1};
+  uint8_t pub_key[256];
+  uint8_t priv_key[128];
+  uint8_t pub_key2[256];
+  uint8_t priv_key2[128];
+
+  assert(mxd_dilithium_keygen(pub_key, priv_key) == 0);
+  assert(mxd_dilithium_keygen(pub_key2, priv_key2) == 0);
+
+  assert(mxd_create_transaction(&tx) == 0);
+  assert(mxd_add_tx_input(&tx, prev_hash, 0, pub_key) == 0);
+  prev_hash[0] = 2;
+  assert(mxd_add_tx_input(&tx, prev_hash, 1, pub_key2) == 0);
+  assert(mxd_add_tx_output(&tx, pub_key, 1.0) == 0);
+
+  // One call signs every input with its own key
+  const uint8_t *keys[] = {priv_key, priv_key2};
+  assert(mxd_sign_tx_inputs(&tx, keys) == 0);
+  assert(mxd_verify_tx_input(&tx, 0) == 0);
+  assert(mxd_verify_tx_input(&tx, 1) == 0);
+
+  // Editing an output in place invalidates the old signatures, and signing
+  // again covers the new contents
+  tx.outputs[0].amount = 0.5;
+  assert(mxd_verify_tx_input(&tx, 0) == -1);
+  assert(mxd_sign_tx_input(&tx, 0, priv_key) == 0);
+  assert(mxd_verify_tx_input(&tx, 0) == 0);
+  assert(mxd_verify_tx_input(&tx, 1) == -1);
+  assert(mxd_sign_tx_inputs(&tx, keys) == 0);
+  assert(mxd_verify_tx_input(&tx, 1) == 0);
+
+  // Same for an in-place edit of the recipient key
+  tx.outputs[0].recipient_key[0] ^= 0xFF;
+  assert(mxd_verify_tx_input(&tx, 0) == -1);
+  assert(mxd_sign_tx_inputs(&tx, keys) == 0);
+  assert(mxd_verify_tx_input(&tx, 0) == 0);
+  assert(mxd_verify_tx_input(&tx, 1) == 0);
+
+  const uint8_t *missing[] = {priv_key, NULL};
+  assert(mxd_sign_tx_inputs(&tx, missing) == -1);
+  assert(mxd_sign_tx_inputs(&tx, NULL) == -1);
+
+  mxd_free_transaction(&tx);
+  printf("Transaction sign inputs test passed\n");
+}
+
+static void test_transaction_wire_format(void) {
+  mxd_transaction_t tx, decoded;
+  uint8_t prev_hash[64] = {1};
+  uint8_t pub_key[256] = {0};
+  uint8_t priv_key[128];
+  uint8_t buffer[MXD_TX_WIRE_MAX_SIZE];
+  uint8_t hash[64], decoded_hash[64], view_hash[64];
+  size_t written = 0, consumed = 0;
+
+  assert(mxd_dilithium_keygen(pub_key, priv_key) == 0);
+
+  // The spent UTXO, so the decoded transaction can be validated
+  mxd_utxo_t utxo = {0};
+  memcpy(utxo.tx_hash, prev_hash, 64);
+  utxo.output_index = 3;
+  memcpy(utxo.owner_key, pub_key, 256);
+  utxo.amount = 2.0;
+  assert(mxd_hash160(pub_key, 256, utxo.pubkey_hash) == 0);
+  assert(mxd_add_utxo(&utxo) == 0);
+
+  assert(mxd_create_transaction(&tx) == 0);
+  assert(mxd_add_tx_input(&tx, prev_hash, 3, pub_key) == 0);
+  assert(mxd_add_tx_output(&tx, pub_key, 1.25) == 0);
+  assert(mxd_add_tx_output(&tx, pub_key, 0.1) == 0);
+  assert(mxd_set_voluntary_tip(&tx, 0.01) == 0);
+  tx.timestamp = 1708198204;
+  assert(mxd_sign_tx_input(&tx, 0, priv_key) == 0);
+  assert(mxd_calculate_tx_hash(&tx, hash) == 0);
+
+  // Encoding drops the zero padding of the fixed key/signature fields
+  assert(mxd_tx_encode(&tx, buffer, sizeof(buffer), &written) == 0);
+  assert(written == mxd_tx_encoded_size(&tx));
+  assert(written < sizeof(mxd_tx_input_t) + 2 * sizeof(mxd_tx_output_t));
+  assert(mxd_tx_encode(&tx, buffer, written - 1, &written) == -1);
+  assert(mxd_tx_encode(&tx, buffer, sizeof(buffer), &written) == 0);
+
+  // View reads fields in place and hashes like the decoded transaction
+  mxd_tx_view_t view;
+  mxd_tx_input_view_t input;
+  mxd_tx_output_view_t output;
+  assert(mxd_tx_view_parse(&view, buffer, written) == 0);
+  assert(view.length == written);
+  assert(view.input_count == 1 && view.output_count == 2);
+  assert(view.timestamp == tx.timestamp);
+  assert(mxd_tx_view_get_input(&view, 0, &input) == 0);
+  assert(input.output_index == 3);
+  assert(input.prev_tx_hash >= buffer && input.prev_tx_hash < buffer + written);
+  assert(memcmp(input.prev_tx_hash, prev_hash, 64) == 0);
+  assert(mxd_tx_view_get_output(&view, 1, &output) == 0);
+  assert(output.amount_units == 10000000);
+  assert(mxd_tx_view_get_input(&view, 1, &input) == -1);
+  assert(mxd_tx_view_hash(&view, view_hash) == 0);
+  assert(memcmp(view_hash, hash, 64) == 0);
+
+  // Round trip keeps the hash and signature valid
+  assert(mxd_tx_decode(buffer, written, &decoded, &consumed) == 0);
+  assert(consumed == written);
+  assert(mxd_calculate_tx_hash(&decoded, decoded_hash) == 0);
+  assert(memcmp(decoded_hash, hash, 64) == 0);
+  assert(mxd_verify_tx_input(&decoded, 0) == 0);
+
+  // Input amounts are not encoded; decoding fills them in from the UTXO set
+  assert(decoded.inputs[0].amount == 2.0);
+  assert(mxd_validate_transaction(&decoded) == 0);
+  mxd_free_transaction(&decoded);
+
+  // Truncated, padded and non-canonical encodings are rejected
+  assert(mxd_tx_view_parse(&view, buffer, written - 1) == -1);
+  uint8_t bad[MXD_TX_WIRE_MAX_SIZE];
+  memcpy(bad, buffer, written);
+  bad[0] = MXD_TX_WIRE_VERSION + 1;
+  assert(mxd_tx_view_parse(&view, bad, written) == -1);
+  memcpy(bad, buffer, written);
+  bad[2] = 0x80; // Unknown flag bit
+  assert(mxd_tx_view_parse(&view, bad, written) == -1);
+  bad[0] = MXD_TX_WIRE_VERSION;
+  bad[1] = 0x81; // Overlong varint for version 1
+  bad[2] = 0x00;
+  memcpy(bad + 3, buffer + 2, written - 2);
+  assert(mxd_tx_view_parse(&view, bad, written + 1) == -1);
+
+  // Each amount has one encoding: units that do not survive the round
+  // trip through a double, or exceed the amount cap, are rejected
+  size_t tip_offset = 3 + mxd_varint_size(tx.timestamp);
+  size_t tip_size = mxd_varint_size(1000000);
+  size_t amount_offset = written - mxd_varint_size(10000000);
+  const uint64_t malleable[] = {(1ULL << 53) + 1, 9000000000000000001ULL, UINT64_MAX};
+  for (int field = 0; field < 2; field++) {
+    size_t at = field == 0 ? tip_offset : amount_offset;
+    size_t old_size = field == 0 ? tip_size : written - amount_offset;
+    for (int i = -1; i < 3; i++) {
+      uint64_t units = i < 0 ? 123456789 : malleable[i];
+      memcpy(bad, buffer, at);
+      size_t bad_length = at + mxd_varint_write(bad + at, units);
+      memcpy(bad + bad_length, buffer + at + old_size, written - at - old_size);
+      bad_length += written - at - old_size;
+      assert(mxd_tx_view_parse(&view, bad, bad_length) == (i < 0 ? 0 : -1));
+      if (i < 0 && field == 0) {
+        assert(view.tip_units == units);
+      } else if (i < 0) {
+        assert(mxd_tx_view_get_output(&view, 1, &output) == 0 && output.amount_units == units);
+      }
+    }
+  }
+
+  // Amounts are quantized to units: change computed as 0.1 + 0.2 encodes,
+  // and decodes to a transaction with the same hash
+  tx.outputs[1].amount = 0.1 + 0.2;
+  assert(tx.outputs[1].amount != 0.3);
+  assert(mxd_calculate_tx_hash(&tx, hash) == 0);
+  assert(mxd_tx_encode(&tx, buffer, sizeof(buffer), &written) == 0);
+  assert(mxd_tx_decode(buffer, written, &decoded, NULL) == 0);
+  assert(decoded.outputs[1].amount == 0.3);
+  assert(mxd_calculate_tx_hash(&decoded, decoded_hash) == 0);
+  assert(memcmp(decoded_hash, hash, 64) == 0);
+  mxd_free_transaction(&decoded);
+  tx.outputs[1].amount = 0.1;
+  assert(mxd_calculate_tx_hash(&tx, hash) == 0);
+
+  // Amounts that have no unit value cannot be encoded
+  tx.outputs[1].amount = -0.1;
+  assert(mxd_tx_encoded_size(&tx) == 0);
+  tx.outputs[1].amount = 0.1;
+
+  // Lists carry a count prefix and must not have trailing bytes
+  uint8_t *list = NULL;
+  size_t list_length = 0, offset = 0;
+  uint32_t count = 0;
+  mxd_transaction_t txs[2] = {tx, tx};
+  assert(mxd_tx_list_encode(txs, 2, &list, &list_length) == 0);
+  assert(mxd_tx_list_validate(list, list_length, &count) == 0 && count == 2);
+  assert(mxd_tx_list_validate(list, list_length - 1, &count) == -1);
+  assert(mxd_tx_list_next(list, list_length, &offset, &view) == 0);
+  assert(mxd_tx_list_next(list, list_length, &offset, &view) == 0);
+  assert(offset == list_length);
+  assert(mxd_tx_view_hash(&view, view_hash) == 0);
+  assert(memcmp(view_hash, hash, 64) == 0);
+  free(list);
+
+  assert(mxd_remove_utxo(prev_hash, 3) == 0);
+  mxd_free_transaction(&tx);
+  printf("Transaction wire format test passed\n");
+}
+
+static void test_transaction_builder(void) {
+  uint8_t prev_hash[64] = {1};
+  uint8_t pub_key[256];
+  uint8_t priv_key[128];
+  uint8_t hash[64], heap_hash[64];
+  static uint8_t arena_buffer[64 * 1024];
+  mxd_arena_t arena;
+
+  assert(mxd_dilithium_keygen(pub_key, priv_key) == 0);
+  assert(mxd_arena_init(&arena, arena_buffer, sizeof(arena_buffer)) == 0);
+
+  // Arena allocations honour alignment and fail cleanly when exhausted
+  void *small = mxd_arena_alloc(&arena, 3, 1);
+  void *aligned = mxd_arena_alloc(&arena, 8, 64);
+  assert(small && aligned && ((uintptr_t)aligned % 64) == 0);
+  assert(mxd_arena_alloc(&arena, sizeof(arena_buffer), 0) == NULL);
+  mxd_arena_reset(&arena);
+  assert(mxd_arena_remaining(&arena) == sizeof(arena_buffer));
+
+  // Builder output matches a heap-built transaction
+  mxd_transaction_t tx, heap_tx;
+  mxd_tx_builder_t builder;
+  assert(mxd_tx_builder_begin(&builder, &arena, &tx, 2, 1) == 0);
+  assert(tx.arena_allocated == 1);
+  assert(mxd_tx_builder_add_input(&builder, prev_hash, 0, pub_key) == 0);
+  assert(mxd_tx_builder_add_input(&builder, prev_hash, 1, pub_key) == 0);
+  assert(mxd_tx_builder_add_input(&builder, prev_hash, 2, pub_key) == -1);
+  assert(mxd_tx_builder_add_output(&builder, pub_key, 1.0) == 0);
+  assert(mxd_tx_builder_add_output(&builder, pub_key, 1.0) == -1);
+  assert(mxd_add_tx_output(&tx, pub_key, 1.0) == -1);
+
+  assert(mxd_create_transaction(&heap_tx) == 0);
+  heap_tx.timestamp = tx.timestamp;
+  assert(mxd_add_tx_input(&heap_tx, prev_hash, 0, pub_key) == 0);
+  assert(mxd_add_tx_input(&heap_tx, prev_hash, 1, pub_key) == 0);
+  assert(mxd_add_tx_output(&heap_tx, pub_key, 1.0) == 0);
+  assert(mxd_calculate_tx_hash(&tx, hash) == 0);
+  assert(mxd_calculate_tx_hash(&heap_tx, heap_hash) == 0);
+  assert(memcmp(hash, heap_hash, 64) == 0);
+  mxd_free_transaction(&heap_tx);
+
+  assert(mxd_sign_tx_input(&tx, 0, priv_key) == 0);
+  assert(mxd_verify_tx_input(&tx, 0) == 0);
+
+  // Freeing leaves arena memory alone; resetting releases it
+  mxd_free_transaction(&tx);
+  assert(arena.used > 0);
+  mxd_arena_reset(&arena);
+
+  // Decode a block-sized batch into the arena without heap allocations
+  uint8_t encoded[MXD_TX_WIRE_MAX_SIZE];
+  size_t written;
+  assert(mxd_tx_builder_begin(&builder, &arena, &tx, 1, 1) == 0);
+  assert(mxd_tx_builder_add_input(&builder, prev_hash, 0, pub_key) == 0);
+  assert(mxd_tx_builder_add_output(&builder, pub_key, 0.5) == 0);
+  assert(mxd_tx_encode(&tx, encoded, sizeof(encoded), &written) == 0);
+  mxd_arena_reset(&arena);
+
+  mxd_tx_view_t view;
+  assert(mxd_tx_view_parse(&view, encoded, written) == 0);
+  size_t decoded = 0;
+  while (mxd_tx_view_to_transaction_arena(&view, &arena, &tx) == 0) {
+    assert(tx.arena_allocated == 1 && tx.output_count == 1);
+    decoded++;
+  }
+  assert(decoded > 1);
+  assert(mxd_arena_remaining(&arena) < sizeof(mxd_tx_input_t) + sizeof(mxd_tx_output_t));
+  mxd_arena_reset(&arena);
+
+  printf("Transaction builder test passed\n");
+}
+
 int main(void) {
   printf("Starting transaction tests...\n");
 
@@ -157,12 +423,16 @@ int main(void) {
   
   // Initialize UTXO database with a path
   assert(mxd_init_utxo_db("./transaction_test_utxo.db") == 0);
+  assert(mxd_reset_utxo_db() == 0);
 
   test_transaction_creation();
   test_input_output_management();
   test_transaction_signing();
   test_transaction_validation();
   test_transaction_hashing();
+  test_transaction_sign_inputs();
+  test_transaction_wire_format();
+  test_transaction_builder();
 
   mxd_close_utxo_db();
 
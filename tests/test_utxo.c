@@ -1,13 +1,17 @@
 #include "../include/mxd_crypto.h"
 #include "../include/mxd_utxo.h"
+#include "../include/mxd_utxo_cache.h"
+#include "../include/mxd_rocksdb_globals.h"
 #include "test_utils.h"
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 static void test_utxo_initialization(void) {
   TEST_START("UTXO Initialization");
   TEST_ASSERT(mxd_init_utxo_db("./test_utxo.db") == 0, "Initialize UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
   TEST_END("UTXO Initialization");
 }
 
@@ -92,12 +96,835 @@ static void test_multisig_utxo(void) {
   TEST_END("Multi-signature UTXO");
 }
 
+static void test_utxo_cache(void) {
+  mxd_utxo_t utxo = {0};
+  mxd_utxo_t found;
+  mxd_utxo_cache_stats_t stats;
+  uint8_t cosigner_keys[2 * 256] = {5, 6};
+
+  TEST_START("UTXO Cache");
+
+  // Small budget so eviction kicks in
+  TEST_ASSERT(mxd_utxo_cache_init(1024 * 1024) == 0, "Initialize UTXO cache");
+
+  utxo.amount = 1.0;
+  utxo.tx_hash[0] = 9;
+  utxo.output_index = 7;
+  TEST_ASSERT(mxd_utxo_cache_lookup(utxo.tx_hash, 7, &found) == -1, "Cold lookup misses");
+  mxd_utxo_cache_insert(&utxo);
+  TEST_ASSERT(mxd_utxo_cache_lookup(utxo.tx_hash, 7, &found) == 0, "Lookup hits after insert");
+  TEST_ASSERT(found.amount == 1.0 && found.output_index == 7, "Cached UTXO matches");
+  TEST_ASSERT(mxd_utxo_cache_lookup(utxo.tx_hash, 8, &found) == -1, "Other output index misses");
+
+  // Inserting again replaces the cached state
+  utxo.is_spent = 1;
+  mxd_utxo_cache_insert(&utxo);
+  TEST_ASSERT(mxd_utxo_cache_lookup(utxo.tx_hash, 7, &found) == 0 && found.is_spent == 1,
+              "Re-insert updates cached UTXO");
+
+  // Cosigner keys are deep-copied both ways
+  TEST_ASSERT(mxd_create_multisig_utxo(&utxo, cosigner_keys, 2, 1) == 0, "Create multi-sig UTXO");
+  mxd_utxo_cache_insert(&utxo);
+  mxd_free_utxo(&utxo);
+  uint8_t tx_hash[64] = {9};
+  TEST_ASSERT(mxd_utxo_cache_lookup(tx_hash, 7, &found) == 0 && found.cosigner_keys &&
+              memcmp(found.cosigner_keys, cosigner_keys, 2 * 256) == 0, "Cosigner keys cached");
+  mxd_free_utxo(&found);
+
+  mxd_utxo_cache_remove(tx_hash, 7);
+  TEST_ASSERT(mxd_utxo_cache_lookup(tx_hash, 7, &found) == -1, "Removed UTXO misses");
+
+  // Fill far past the budget; the cache must evict and stay within it
+  for (uint32_t i = 0; i < 20000; i++) {
+    memset(&utxo, 0, sizeof(utxo));
+    memcpy(utxo.tx_hash, &i, sizeof(i));
+    utxo.amount = i;
+    mxd_utxo_cache_insert(&utxo);
+  }
+  mxd_utxo_cache_get_stats(&stats);
+  TEST_VALUE("Cached entries", "%zu", stats.entries);
+  TEST_VALUE("Cache bytes", "%zu", stats.bytes);
+  TEST_ASSERT(stats.evictions > 0, "Entries evicted once full");
+  TEST_ASSERT(stats.bytes <= stats.byte_budget, "Cache stays within its budget");
+  TEST_ASSERT(stats.entries > 0 && stats.entries < 20000, "Cache holds a bounded working set");
+  TEST_ASSERT(stats.hits == 3 && stats.misses == 3, "Hit and miss counters");
+
+  // Every surviving entry must still be reachable after backward-shift deletes
+  size_t reachable = 0;
+  for (uint32_t i = 0; i < 20000; i++) {
+    uint8_t key[64] = {0};
+    memcpy(key, &i, sizeof(i));
+    if (mxd_utxo_cache_lookup(key, 0, &found) == 0) {
+      TEST_ASSERT(found.amount == (double)i, "Cached amount matches key");
+      reachable++;
+    }
+  }
+  TEST_ASSERT(reachable == stats.entries, "All cached entries reachable");
+
+  // Database reads repopulate the cache with the current state
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_cache.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+  memset(&utxo, 0, sizeof(utxo));
+  utxo.tx_hash[0] = 42;
+  utxo.amount = 2.0;
+  TEST_ASSERT(mxd_add_utxo(&utxo) == 0, "Add UTXO to database");
+  TEST_ASSERT(mxd_mark_utxo_spent(utxo.tx_hash, 0) == 0, "Mark UTXO spent");
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 0, &found) == 0 && found.is_spent == 1,
+              "Cached lookup sees spent state");
+  TEST_ASSERT(mxd_remove_utxo(utxo.tx_hash, 0) == 0, "Remove UTXO");
+
+  TEST_END("UTXO Cache");
+}
+
+// Block at height whose only transaction is a coinbase paying height + 1 coins
+static int make_test_block(uint32_t height, const uint8_t prev_hash[64], mxd_block_t *block,
+                           mxd_transaction_t *coinbase) {
+  uint8_t miner_key[256] = {3};
+  uint8_t prev[64];
+
+  memcpy(prev, prev_hash, 64); // prev_hash may point into block
+  memset(block, 0, sizeof(*block));
+  block->height = height;
+  memcpy(block->prev_block_hash, prev, 64);
+  memset(block->block_hash, (int)(height + 1), 64);
+  return mxd_create_coinbase_transaction(coinbase, miner_key, height + 1.0);
+}
+
+static int replay_test_block(uint32_t height, void *user_data) {
+  mxd_block_t block;
+  mxd_transaction_t coinbase;
+  uint8_t prev_hash[64];
+  int *replayed = user_data;
+
+  memset(prev_hash, (int)height, 64);
+  if (make_test_block(height, prev_hash, &block, &coinbase) != 0) {
+    return -1;
+  }
+  int result = mxd_apply_block_to_utxo(&block, &coinbase, 1);
+  mxd_free_transaction(&coinbase);
+  (*replayed)++;
+  return result;
+}
+
+static void test_utxo_restart(void) {
+  mxd_block_t block;
+  mxd_transaction_t coinbase;
+  uint8_t zero_hash[64] = {0};
+  uint8_t tip_hash[64];
+  uint8_t coinbase_hash[64];
+  uint8_t prev_hash_5[64];
+  uint32_t tip_height = 0;
+  mxd_utxo_t found;
+  size_t count = 0;
+
+  TEST_START("UTXO Restart");
+
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_restart.db") == 0, "Open UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == -1, "No tip before the first block");
+
+  TEST_ASSERT(make_test_block(0, zero_hash, &block, &coinbase) == 0, "Create genesis block");
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block, &coinbase, 1) == 0, "Apply genesis block");
+  mxd_free_transaction(&coinbase);
+
+  TEST_ASSERT(make_test_block(1, block.block_hash, &block, &coinbase) == 0, "Create block 1");
+  memcpy(coinbase_hash, coinbase.tx_hash, 64);
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block, &coinbase, 1) == 0, "Apply block 1");
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block, &coinbase, 1) == -1, "Block not extending tip rejected");
+  mxd_free_transaction(&coinbase);
+
+  // The set and its tip survive a restart
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_restart.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 1, "Tip restored");
+  TEST_ASSERT(memcmp(tip_hash, block.block_hash, 64) == 0, "Tip hash restored");
+  TEST_ASSERT(mxd_find_utxo(coinbase_hash, 0, &found) == 0 && found.amount == 2.0,
+              "UTXO survives restart");
+  mxd_free_utxo(&found);
+  TEST_ASSERT(mxd_get_utxo_count(&count) == 0 && count == 2, "UTXO count restored");
+
+  // Only the missing blocks are replayed
+  int replayed = 0;
+  TEST_ASSERT(mxd_replay_utxo_blocks(4, replay_test_block, &replayed) == 0, "Replay to height 4");
+  TEST_ASSERT(replayed == 3, "Only blocks 2-4 replayed");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 4, "Tip advanced");
+  replayed = 0;
+  TEST_ASSERT(mxd_replay_utxo_blocks(4, replay_test_block, &replayed) == 0 && replayed == 0,
+              "Nothing to replay at the tip");
+
+  // A block that fails part-way is discarded as a whole
+  mxd_transaction_t txs[3];
+  uint8_t missing_hash[64] = {0xEE};
+  uint8_t key[256] = {4};
+  uint8_t failed_hash[64];
+  memset(prev_hash_5, 5, 64);
+  TEST_ASSERT(make_test_block(5, prev_hash_5, &block, &txs[0]) == 0, "Create block 5");
+  memcpy(failed_hash, txs[0].tx_hash, 64);
+  TEST_ASSERT(mxd_create_transaction(&txs[1]) == 0, "Create spending transaction");
+  TEST_ASSERT(mxd_add_tx_input(&txs[1], missing_hash, 0, key) == 0, "Add missing input");
+  TEST_ASSERT(mxd_add_tx_output(&txs[1], key, 1.0) == 0, "Add output");
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block, txs, 2) == -1, "Failing block rejected");
+  mxd_free_transaction(&txs[0]);
+  mxd_free_transaction(&txs[1]);
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 4, "Tip unchanged after failure");
+  TEST_ASSERT(mxd_find_utxo(failed_hash, 0, &found) == -1, "Outputs of failed block discarded");
+  TEST_ASSERT(mxd_get_utxo_count(&count) == 0 && count == 5, "UTXO count unchanged");
+
+  // The set stays usable across a restart
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_restart.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 4, "Tip kept after failure");
+  TEST_ASSERT(mxd_find_utxo(coinbase_hash, 0, &found) == 0, "Set kept after failure");
+  mxd_free_utxo(&found);
+
+  // Transactions see outputs created earlier in the same block
+  TEST_ASSERT(make_test_block(5, prev_hash_5, &block, &txs[0]) == 0, "Create block 5");
+  TEST_ASSERT(mxd_create_transaction(&txs[1]) == 0, "Create first spend");
+  TEST_ASSERT(mxd_add_tx_input(&txs[1], txs[0].tx_hash, 0, key) == 0, "Spend coinbase");
+  TEST_ASSERT(mxd_add_tx_output(&txs[1], key, 6.0) == 0, "Add output");
+  TEST_ASSERT(mxd_calculate_tx_hash(&txs[1], txs[1].tx_hash) == 0, "Hash first spend");
+  TEST_ASSERT(mxd_create_transaction(&txs[2]) == 0, "Create second spend");
+  TEST_ASSERT(mxd_add_tx_input(&txs[2], txs[1].tx_hash, 0, key) == 0, "Spend first spend");
+  TEST_ASSERT(mxd_add_tx_output(&txs[2], key, 6.0) == 0, "Add output");
+  TEST_ASSERT(mxd_calculate_tx_hash(&txs[2], txs[2].tx_hash) == 0, "Hash second spend");
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block, txs, 3) == 0, "Apply block 5");
+  TEST_ASSERT(mxd_find_utxo(txs[0].tx_hash, 0, &found) == 0 && found.is_spent, "Coinbase spent");
+  mxd_free_utxo(&found);
+  TEST_ASSERT(mxd_find_utxo(txs[1].tx_hash, 0, &found) == 0 && found.is_spent, "First spend spent");
+  mxd_free_utxo(&found);
+  TEST_ASSERT(mxd_find_utxo(txs[2].tx_hash, 0, &found) == 0 && !found.is_spent, "Second spend unspent");
+  mxd_free_utxo(&found);
+  for (int i = 0; i < 3; i++) {
+    mxd_free_transaction(&txs[i]);
+  }
+
+  // A reset set is rebuilt by a full replay
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Reset UTXO set");
+  TEST_ASSERT(mxd_find_utxo(coinbase_hash, 0, &found) == -1, "Reset set is empty");
+  replayed = 0;
+  TEST_ASSERT(mxd_replay_utxo_blocks(4, replay_test_block, &replayed) == 0 && replayed == 5,
+              "Full replay from genesis");
+  TEST_ASSERT(mxd_get_utxo_count(&count) == 0 && count == 5, "UTXO set rebuilt");
+
+  TEST_END("UTXO Restart");
+}
+
+// Size of the stored record for an outpoint, or 0 if absent
+static size_t stored_record_size(const uint8_t tx_hash[64], uint32_t output_index) {
+  uint8_t key[5 + 64 + sizeof(uint32_t)];
+  size_t value_len = 0;
+  char *err = NULL;
+
+  memcpy(key, "utxo:", 5);
+  memcpy(key + 5, tx_hash, 64);
+  memcpy(key + 5 + 64, &output_index, sizeof(uint32_t));
+  char *value = rocksdb_get_cf(mxd_get_rocksdb_db(), mxd_get_rocksdb_readoptions(),
+                               mxd_get_rocksdb_cf(MXD_CF_UTXO), (char *)key, sizeof(key), &value_len, &err);
+  free(err);
+  free(value);
+  return value ? value_len : 0;
+}
+
+static void test_utxo_record_format(void) {
+  mxd_utxo_t utxo;
+  mxd_utxo_t found;
+  uint8_t cosigner_keys[3 * 256] = {0};
+
+  TEST_START("UTXO Record Format");
+
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_format.db") == 0, "Open UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+
+  memset(&utxo, 0, sizeof(utxo));
+  // Single-signature output with a 32-byte key
+  utxo.tx_hash[0] = 0x11;
+  utxo.output_index = 300;
+  memset(utxo.owner_key, 0xAB, 32);
+  utxo.amount = 12.5;
+  utxo.required_signatures = 1;
+  mxd_hash160(utxo.owner_key, 256, utxo.pubkey_hash);
+  TEST_ASSERT(mxd_add_utxo(&utxo) == 0, "Store single-signature UTXO");
+  size_t record_size = stored_record_size(utxo.tx_hash, 300);
+  TEST_VALUE("Record size", "%zu", record_size);
+  TEST_ASSERT(record_size > 0 && record_size * 4 < sizeof(mxd_utxo_t), "Record is several times smaller");
+
+  mxd_utxo_cache_clear();
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 300, &found) == 0, "Read record back");
+  TEST_ASSERT(memcmp(&found, &utxo, sizeof(mxd_utxo_t)) == 0, "Record round-trips");
+
+  // Amounts below the base unit, spent flag and cosigners
+  memset(cosigner_keys, 0x21, 32);
+  memset(cosigner_keys + 256, 0x22, 256);
+  TEST_ASSERT(mxd_create_multisig_utxo(&utxo, cosigner_keys, 3, 2) == 0, "Create multi-sig UTXO");
+  utxo.output_index = 301;
+  utxo.amount = 0.1 + 0.2;
+  utxo.is_spent = 1;
+  TEST_ASSERT(mxd_add_utxo(&utxo) == 0, "Store multi-sig UTXO");
+  mxd_utxo_cache_clear();
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 301, &found) == 0, "Read multi-sig record back");
+  TEST_ASSERT(found.amount == 0.1 + 0.2 && found.is_spent == 1, "Raw amount and spent flag kept");
+  TEST_ASSERT(found.required_signatures == 2 && found.cosigner_count == 3, "Cosigner counts kept");
+  TEST_ASSERT(memcmp(found.cosigner_keys, cosigner_keys, sizeof(cosigner_keys)) == 0,
+              "Cosigner keys kept");
+  TEST_ASSERT(memcmp(found.owner_key, utxo.owner_key, 256) == 0, "Owner key kept");
+  mxd_free_utxo(&found);
+  mxd_free_utxo(&utxo);
+
+  // Raw records in the default column family, as written before compact
+  // records and column families, are moved and rewritten on open
+  memset(&utxo, 0, sizeof(utxo));
+  utxo.tx_hash[0] = 0x12;
+  utxo.output_index = 7;
+  memset(utxo.owner_key, 0xCD, 32);
+  utxo.amount = 3.0;
+  utxo.required_signatures = 1;
+  uint8_t key[5 + 64 + sizeof(uint32_t)];
+  char *err = NULL;
+  memcpy(key, "utxo:", 5);
+  memcpy(key + 5, utxo.tx_hash, 64);
+  memcpy(key + 5 + 64, &utxo.output_index, sizeof(uint32_t));
+  rocksdb_put(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), (char *)key, sizeof(key),
+              (char *)&utxo, sizeof(utxo), &err);
+  rocksdb_delete(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), "utxo_meta:format", 16, &err);
+  TEST_ASSERT(err == NULL, "Write legacy record");
+
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_format.db") == 0, "Reopen UTXO database");
+  size_t migrated_size = stored_record_size(utxo.tx_hash, 7);
+  TEST_ASSERT(migrated_size > 0 && migrated_size < sizeof(mxd_utxo_t), "Legacy record migrated");
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 7, &found) == 0, "Migrated record readable");
+  TEST_ASSERT(memcmp(&found, &utxo, sizeof(mxd_utxo_t)) == 0, "Migrated record matches");
+
+  TEST_END("UTXO Record Format");
+}
+
+static void test_utxo_balance_index(void) {
+  mxd_utxo_t utxo;
+  uint8_t owner_key[256] = {0};
+  uint8_t other_key[256] = {0};
+  uint8_t pubkey_hash[20];
+  double balance = 0.0;
+  uint64_t count = 0;
+
+  TEST_START("UTXO Balance Index");
+
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_balance.db") == 0, "Open UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+
+  memset(owner_key, 0x31, 32);
+  memset(other_key, 0x32, 32);
+  mxd_hash160(owner_key, 256, pubkey_hash);
+  TEST_ASSERT(mxd_get_address_balance(pubkey_hash, &balance, &count) == 0 && balance == 0.0 && count == 0,
+              "Unknown address has no balance");
+
+  memset(&utxo, 0, sizeof(utxo));
+  memcpy(utxo.owner_key, owner_key, 256);
+  memcpy(utxo.pubkey_hash, pubkey_hash, 20);
+  utxo.required_signatures = 1;
+  for (uint32_t i = 0; i < 3; i++) {
+    utxo.tx_hash[0] = 0x40 + i;
+    utxo.amount = 1.25 * (i + 1);
+    TEST_ASSERT(mxd_add_utxo(&utxo) == 0, "Add UTXO");
+  }
+  TEST_ASSERT(mxd_get_address_balance(pubkey_hash, &balance, &count) == 0 && balance == 7.5 && count == 3,
+              "Balance covers all outputs");
+  TEST_ASSERT(mxd_get_balance(owner_key) == 7.5, "Balance by public key");
+  TEST_ASSERT(mxd_get_balance(other_key) == 0.0, "Other address unaffected");
+
+  // Re-adding an output replaces its contribution instead of doubling it
+  utxo.tx_hash[0] = 0x40;
+  utxo.amount = 1.25;
+  TEST_ASSERT(mxd_add_utxo(&utxo) == 0, "Re-add UTXO");
+  TEST_ASSERT(mxd_get_address_balance(pubkey_hash, &balance, &count) == 0 && balance == 7.5 && count == 3,
+              "Re-added output counted once");
+
+  utxo.tx_hash[0] = 0x41;
+  TEST_ASSERT(mxd_mark_utxo_spent(utxo.tx_hash, 0) == 0, "Mark UTXO spent");
+  TEST_ASSERT(mxd_get_address_balance(pubkey_hash, &balance, &count) == 0 && balance == 5.0 && count == 2,
+              "Spent output leaves the balance");
+  TEST_ASSERT(mxd_remove_utxo(utxo.tx_hash, 0) == 0, "Remove spent UTXO");
+  utxo.tx_hash[0] = 0x42;
+  TEST_ASSERT(mxd_remove_utxo(utxo.tx_hash, 0) == 0, "Remove unspent UTXO");
+  TEST_ASSERT(mxd_get_address_balance(pubkey_hash, &balance, &count) == 0 && balance == 1.25 && count == 1,
+              "Removed outputs leave the balance");
+
+  // A database without the index marker has it rebuilt from the UTXOs
+  char *err = NULL;
+  rocksdb_delete(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), "utxo_meta:balance_index", 23, &err);
+  TEST_ASSERT(err == NULL, "Drop balance index marker");
+  utxo.tx_hash[0] = 0x43;
+  utxo.amount = 2.0;
+  TEST_ASSERT(mxd_add_utxo(&utxo) == 0, "Add UTXO");
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_balance.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_get_address_balance(pubkey_hash, &balance, &count) == 0 && balance == 3.25 && count == 2,
+              "Balance index rebuilt");
+
+  TEST_END("UTXO Balance Index");
+}
+
+static void test_utxo_batch_lookup(void) {
+  mxd_utxo_t utxo;
+  mxd_utxo_outpoint_t keys[5];
+  mxd_utxo_t found[5];
+  int status[5];
+  mxd_utxo_cache_stats_t stats;
+
+  TEST_START("UTXO Batch Lookup");
+
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_batch.db") == 0, "Open UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+
+  memset(&utxo, 0, sizeof(utxo));
+  memset(utxo.owner_key, 0x51, 32);
+  mxd_hash160(utxo.owner_key, 256, utxo.pubkey_hash);
+  utxo.required_signatures = 1;
+  memset(keys, 0, sizeof(keys));
+  for (uint32_t i = 0; i < 5; i++) {
+    keys[i].tx_hash[0] = 0x60 + i;
+    keys[i].output_index = i;
+    // Every other outpoint exists
+    if (i % 2 == 0) {
+      memcpy(utxo.tx_hash, keys[i].tx_hash, 64);
+      utxo.output_index = i;
+      utxo.amount = i + 1.0;
+      TEST_ASSERT(mxd_add_utxo(&utxo) == 0, "Add UTXO");
+    }
+  }
+
+  // All misses are resolved from the database
+  mxd_utxo_cache_clear();
+  TEST_ASSERT(mxd_find_utxos(keys, 5, found, status) == 0, "Batch lookup from database");
+  for (uint32_t i = 0; i < 5; i++) {
+    if (i % 2 == 0) {
+      TEST_ASSERT(status[i] == 0 && found[i].amount == i + 1.0 && found[i].output_index == i,
+                  "Stored UTXO found");
+      mxd_free_utxo(&found[i]);
+    } else {
+      TEST_ASSERT(status[i] == -1, "Missing UTXO reported");
+    }
+  }
+
+  // The results were cached
+  mxd_utxo_cache_get_stats(&stats);
+  uint64_t hits = stats.hits;
+  TEST_ASSERT(mxd_find_utxos(keys, 5, found, status) == 0, "Batch lookup from cache");
+  mxd_utxo_cache_get_stats(&stats);
+  TEST_ASSERT(stats.hits == hits + 3, "Found UTXOs served from cache");
+  for (uint32_t i = 0; i < 5; i += 2) {
+    mxd_free_utxo(&found[i]);
+  }
+  TEST_ASSERT(mxd_find_utxos(keys, 0, found, status) == 0, "Empty batch");
+
+  TEST_END("UTXO Batch Lookup");
+}
+
+static void test_utxo_stats(void) {
+  mxd_utxo_t utxo;
+  mxd_utxo_t found;
+  size_t count = 0;
+  size_t spent = 0;
+  double value = 0.0;
+
+  TEST_START("UTXO Statistics");
+
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_stats.db") == 0, "Open UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+  TEST_ASSERT(mxd_get_utxo_stats(&count, &spent, &value) == 0 && count == 0 && spent == 0 && value == 0.0,
+              "Empty set has no totals");
+
+  memset(&utxo, 0, sizeof(utxo));
+  memset(utxo.owner_key, 0x71, 32);
+  mxd_hash160(utxo.owner_key, 256, utxo.pubkey_hash);
+  utxo.required_signatures = 1;
+  for (uint32_t i = 0; i < 3; i++) {
+    utxo.tx_hash[0] = 0x80 + i;
+    utxo.amount = i + 1.0;
+    TEST_ASSERT(mxd_add_utxo(&utxo) == 0, "Add UTXO");
+  }
+  utxo.tx_hash[0] = 0x81;
+  TEST_ASSERT(mxd_mark_utxo_spent(utxo.tx_hash, 0) == 0, "Mark UTXO spent");
+  TEST_ASSERT(mxd_get_utxo_stats(&count, &spent, &value) == 0 && count == 3 && spent == 1 && value == 4.0,
+              "Totals follow adds and spends");
+
+  // Totals are persisted with the changes
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_stats.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_get_utxo_stats(&count, &spent, &value) == 0 && count == 3 && spent == 1 && value == 4.0,
+              "Totals restored");
+
+  TEST_ASSERT(mxd_prune_spent_utxos() == 0, "Prune spent UTXOs");
+  TEST_ASSERT(mxd_get_utxo_stats(&count, &spent, &value) == 0 && count == 2 && spent == 0 && value == 4.0,
+              "Pruned records leave the totals");
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 0, &found) == -1, "Spent UTXO pruned");
+  utxo.tx_hash[0] = 0x82;
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 0, &found) == 0 && found.amount == 3.0, "Unspent UTXO kept");
+  mxd_free_utxo(&found);
+
+  // Databases without stored totals are counted once on open
+  char *err = NULL;
+  rocksdb_delete(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), "utxo_meta:stats", 15, &err);
+  TEST_ASSERT(err == NULL, "Drop stored totals");
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_stats.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_get_utxo_stats(&count, &spent, &value) == 0 && count == 2 && spent == 0 && value == 4.0,
+              "Totals recounted");
+
+  TEST_END("UTXO Statistics");
+}
+
+static void test_utxo_commitment(void) {
+  mxd_utxo_t utxo;
+  uint8_t empty[64], forward[64], digest[64], at_height[64];
+  int replayed = 0;
+
+  TEST_START("UTXO Set Commitment");
+
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_commitment.db") == 0, "Open UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+  TEST_ASSERT(mxd_get_utxo_commitment(empty) == 0, "Empty set has a commitment");
+
+  memset(&utxo, 0, sizeof(utxo));
+  memset(utxo.owner_key, 0xA1, 32);
+  mxd_hash160(utxo.owner_key, 256, utxo.pubkey_hash);
+  utxo.required_signatures = 1;
+  for (uint32_t i = 0; i < 3; i++) {
+    utxo.tx_hash[0] = 0xA0 + i;
+    utxo.amount = i + 1.0;
+    mxd_add_utxo(&utxo);
+  }
+  TEST_ASSERT(mxd_get_utxo_commitment(forward) == 0 && memcmp(forward, empty, 64) != 0,
+              "Commitment covers added outputs");
+
+  // Same set, different order
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Reset UTXO set");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, empty, 64) == 0,
+              "Reset returns to the empty commitment");
+  for (uint32_t i = 3; i-- > 0;) {
+    utxo.tx_hash[0] = 0xA0 + i;
+    utxo.amount = i + 1.0;
+    mxd_add_utxo(&utxo);
+  }
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, forward, 64) == 0,
+              "Commitment is independent of insertion order");
+
+  // Spending takes an output out of the set; pruning the spent record
+  // and re-adding the output leave it where a fresh set would be
+  utxo.tx_hash[0] = 0xA1;
+  TEST_ASSERT(mxd_mark_utxo_spent(utxo.tx_hash, 0) == 0, "Mark UTXO spent");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, forward, 64) != 0,
+              "Spend changes the commitment");
+  uint8_t spent_digest[64];
+  memcpy(spent_digest, digest, 64);
+  TEST_ASSERT(mxd_prune_spent_utxos() == 0, "Prune spent UTXOs");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, spent_digest, 64) == 0,
+              "Pruning does not change the unspent set");
+  utxo.amount = 2.0;
+  mxd_add_utxo(&utxo);
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, forward, 64) == 0,
+              "Re-adding the output restores the commitment");
+
+  // Persisted with the totals, and rebuilt for databases without them
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_commitment.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, forward, 64) == 0,
+              "Commitment restored");
+  char *err = NULL;
+  rocksdb_delete(mxd_get_rocksdb_db(), mxd_get_rocksdb_writeoptions(), "utxo_meta:stats", 15, &err);
+  TEST_ASSERT(err == NULL, "Drop stored totals");
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_commitment.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, forward, 64) == 0,
+              "Commitment recomputed");
+
+  // Each applied block records the commitment at its height
+  TEST_ASSERT(mxd_get_utxo_commitment_at(0, at_height) == -1, "No commitment before the first block");
+  TEST_ASSERT(mxd_replay_utxo_blocks(0, replay_test_block, &replayed) == 0, "Apply block 0");
+  TEST_ASSERT(mxd_get_utxo_commitment_at(0, at_height) == 0, "Commitment recorded for block 0");
+  TEST_ASSERT(mxd_replay_utxo_blocks(1, replay_test_block, &replayed) == 0, "Apply block 1");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && mxd_get_utxo_commitment_at(1, forward) == 0 &&
+                  memcmp(digest, forward, 64) == 0,
+              "Latest recorded commitment matches the set");
+  TEST_ASSERT(memcmp(at_height, forward, 64) != 0, "Block outputs change the commitment");
+
+  TEST_END("UTXO Set Commitment");
+}
+
+static void test_utxo_disconnect(void) {
+  mxd_block_t block0, block1;
+  mxd_transaction_t txs[3];
+  mxd_utxo_t found;
+  uint8_t zero_hash[64] = {0};
+  uint8_t key[256] = {5};
+  uint8_t empty[64], before[64], digest[64];
+  uint8_t tip_hash[64];
+  uint32_t tip_height = 0;
+  size_t count = 0, spent = 0;
+  double value = 0.0;
+
+  TEST_START("UTXO Block Disconnect");
+
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_disconnect.db") == 0, "Open UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+  mxd_get_utxo_commitment(empty);
+
+  TEST_ASSERT(make_test_block(0, zero_hash, &block0, &txs[0]) == 0, "Create genesis block");
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block0, txs, 1) == 0, "Apply genesis block");
+  uint8_t genesis_coinbase[64];
+  memcpy(genesis_coinbase, txs[0].tx_hash, 64);
+  mxd_free_transaction(&txs[0]);
+  mxd_get_utxo_commitment(before);
+
+  // Block 1 spends the genesis output and chains a spend within the block
+  TEST_ASSERT(make_test_block(1, block0.block_hash, &block1, &txs[0]) == 0, "Create block 1");
+  TEST_ASSERT(mxd_create_transaction(&txs[1]) == 0, "Create spend");
+  TEST_ASSERT(mxd_add_tx_input(&txs[1], genesis_coinbase, 0, key) == 0, "Spend genesis coinbase");
+  TEST_ASSERT(mxd_add_tx_output(&txs[1], key, 1.0) == 0, "Add output");
+  TEST_ASSERT(mxd_calculate_tx_hash(&txs[1], txs[1].tx_hash) == 0, "Hash spend");
+  TEST_ASSERT(mxd_create_transaction(&txs[2]) == 0, "Create chained spend");
+  TEST_ASSERT(mxd_add_tx_input(&txs[2], txs[1].tx_hash, 0, key) == 0, "Spend first spend");
+  TEST_ASSERT(mxd_add_tx_output(&txs[2], key, 1.0) == 0, "Add output");
+  TEST_ASSERT(mxd_calculate_tx_hash(&txs[2], txs[2].tx_hash) == 0, "Hash chained spend");
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block1, txs, 3) == 0, "Apply block 1");
+  TEST_ASSERT(mxd_find_utxo(genesis_coinbase, 0, &found) == 0 && found.is_spent, "Genesis output spent");
+  mxd_free_utxo(&found);
+
+  // Only the tip can be disconnected
+  TEST_ASSERT(mxd_disconnect_block_from_utxo(&block0) == -1, "Non-tip block rejected");
+  TEST_ASSERT(mxd_disconnect_block_from_utxo(&block1) == 0, "Disconnect block 1");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 0 &&
+                  memcmp(tip_hash, block0.block_hash, 64) == 0,
+              "Tip back at genesis");
+  TEST_ASSERT(mxd_find_utxo(genesis_coinbase, 0, &found) == 0 && !found.is_spent, "Spent output restored");
+  mxd_free_utxo(&found);
+  for (int i = 0; i < 3; i++) {
+    TEST_ASSERT(mxd_find_utxo(txs[i].tx_hash, 0, &found) == -1, "Created output removed");
+  }
+  TEST_ASSERT(mxd_get_utxo_stats(&count, &spent, &value) == 0 && count == 1 && spent == 0 && value == 1.0,
+              "Totals restored");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, before, 64) == 0,
+              "Commitment restored");
+  TEST_ASSERT(mxd_get_utxo_commitment_at(1, digest) == -1, "Commitment of disconnected block dropped");
+
+  // A competing block takes its place, and survives a restart
+  block1.block_hash[0] = 0xB1;
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block1, txs, 1) == 0, "Apply competing block 1");
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_disconnect.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_disconnect_block_from_utxo(&block1) == 0, "Disconnect competing block");
+  TEST_ASSERT(mxd_disconnect_block_from_utxo(&block0) == 0, "Disconnect genesis block");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == -1, "No tip left");
+  TEST_ASSERT(mxd_get_utxo_count(&count) == 0 && count == 0, "Set empty");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, empty, 64) == 0,
+              "Empty commitment restored");
+  TEST_ASSERT(mxd_disconnect_block_from_utxo(&block0) == -1, "Nothing left to disconnect");
+  for (int i = 0; i < 3; i++) {
+    mxd_free_transaction(&txs[i]);
+  }
+
+  TEST_END("UTXO Block Disconnect");
+}
+
+// Block on a branch tagged 0xA0/0xB0 whose coinbase differs per branch;
+// spend_key, if given, adds a spend of the genesis coinbase to it
+static int make_branch_block(uint32_t height, const uint8_t prev_hash[64], uint8_t branch,
+                             const uint8_t genesis_coinbase[64], const uint8_t *spend_key,
+                             mxd_block_t *block, mxd_transaction_t txs[2], size_t *tx_count) {
+  if (make_test_block(height, prev_hash, block, &txs[0]) != 0) {
+    return -1;
+  }
+  block->block_hash[0] = (uint8_t)(branch + height);
+  txs[0].timestamp += branch;
+  if (mxd_calculate_tx_hash(&txs[0], txs[0].tx_hash) != 0) {
+    return -1;
+  }
+  *tx_count = 1;
+  if (!spend_key) {
+    return 0;
+  }
+  *tx_count = 2;
+  if (mxd_create_transaction(&txs[1]) != 0 ||
+      mxd_add_tx_input(&txs[1], genesis_coinbase, 0, spend_key) != 0 ||
+      mxd_add_tx_output(&txs[1], spend_key, 1.0) != 0) {
+    return -1;
+  }
+  return mxd_calculate_tx_hash(&txs[1], txs[1].tx_hash);
+}
+
+static void test_utxo_reorganize(void) {
+  mxd_block_t block0, a[2], b[3];
+  mxd_transaction_t genesis, a_txs[2][2], b_txs[3][2];
+  size_t a_counts[2], b_counts[3];
+  mxd_utxo_block_t a_branch[2], b_branch[3], a_tip_first[2], b_tip_first[3];
+  mxd_utxo_t found;
+  uint8_t zero_hash[64] = {0};
+  uint8_t key_a[256] = {0xA};
+  uint8_t key_b[256] = {0xB};
+  uint8_t genesis_coinbase[64];
+  uint8_t on_a[64], on_b[64], direct[64], digest[64];
+  uint8_t tip_hash[64];
+  uint32_t tip_height = 0;
+
+  TEST_START("UTXO Reorganization");
+
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_reorg.db") == 0, "Open UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+  TEST_ASSERT(make_test_block(0, zero_hash, &block0, &genesis) == 0, "Create genesis block");
+  memcpy(genesis_coinbase, genesis.tx_hash, 64);
+
+  // Both branches spend the genesis coinbase, to different keys
+  for (uint32_t i = 0; i < 2; i++) {
+    TEST_ASSERT(make_branch_block(i + 1, i == 0 ? block0.block_hash : a[i - 1].block_hash, 0xA0,
+                                  genesis_coinbase, i == 0 ? key_a : NULL, &a[i], a_txs[i],
+                                  &a_counts[i]) == 0,
+                "Create block on branch A");
+    a_branch[i] = (mxd_utxo_block_t){&a[i], a_txs[i], a_counts[i]};
+    a_tip_first[1 - i] = a_branch[i];
+  }
+  for (uint32_t i = 0; i < 3; i++) {
+    TEST_ASSERT(make_branch_block(i + 1, i == 0 ? block0.block_hash : b[i - 1].block_hash, 0xB0,
+                                  genesis_coinbase, i == 0 ? key_b : NULL, &b[i], b_txs[i],
+                                  &b_counts[i]) == 0,
+                "Create block on branch B");
+    b_branch[i] = (mxd_utxo_block_t){&b[i], b_txs[i], b_counts[i]};
+    b_tip_first[2 - i] = b_branch[i];
+  }
+
+  // Commitment of the genesis block followed directly by branch B
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block0, &genesis, 1) == 0, "Apply genesis block");
+  TEST_ASSERT(mxd_reorganize_utxo(NULL, 0, b_branch, 3) == 0, "Apply branch B");
+  TEST_ASSERT(mxd_get_utxo_commitment(direct) == 0, "Commitment of branch B");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start over");
+
+  TEST_ASSERT(mxd_apply_block_to_utxo(&block0, &genesis, 1) == 0, "Apply genesis block again");
+  TEST_ASSERT(mxd_reorganize_utxo(NULL, 0, a_branch, 2) == 0, "Apply branch A");
+  TEST_ASSERT(mxd_get_utxo_commitment(on_a) == 0, "Commitment of branch A");
+
+  // A branch that does not start at the fork point is refused untouched
+  TEST_ASSERT(mxd_reorganize_utxo(a_tip_first, 1, b_branch, 3) == -1, "Misaligned branch rejected");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 2 &&
+                  memcmp(tip_hash, a[1].block_hash, 64) == 0,
+              "Tip unchanged");
+
+  // A competing branch that fails part-way leaves branch A in place
+  b[1].prev_block_hash[0] ^= 0xFF;
+  TEST_ASSERT(mxd_reorganize_utxo(a_tip_first, 2, b_branch, 3) == -1, "Broken branch rejected");
+  b[1].prev_block_hash[0] ^= 0xFF;
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 2 &&
+                  memcmp(tip_hash, a[1].block_hash, 64) == 0,
+              "Tip restored after failed reorganization");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, on_a, 64) == 0,
+              "Commitment restored after failed reorganization");
+
+  // Switching to branch B undoes A's spend and applies B's
+  TEST_ASSERT(mxd_reorganize_utxo(a_tip_first, 2, b_branch, 3) == 0, "Reorganize to branch B");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 3 &&
+                  memcmp(tip_hash, b[2].block_hash, 64) == 0,
+              "Tip on branch B");
+  TEST_ASSERT(mxd_find_utxo(genesis_coinbase, 0, &found) == 0 && found.is_spent, "Genesis output spent");
+  mxd_free_utxo(&found);
+  TEST_ASSERT(mxd_find_utxo(a_txs[0][1].tx_hash, 0, &found) == -1, "Branch A spend gone");
+  TEST_ASSERT(mxd_find_utxo(a_txs[1][0].tx_hash, 0, &found) == -1, "Branch A coinbase gone");
+  TEST_ASSERT(mxd_find_utxo(b_txs[0][1].tx_hash, 0, &found) == 0 && found.amount == 1.0,
+              "Branch B spend present");
+  mxd_free_utxo(&found);
+  TEST_ASSERT(mxd_get_utxo_commitment(on_b) == 0 && memcmp(on_b, direct, 64) == 0,
+              "Commitment matches branch B applied directly");
+
+  // And back again
+  TEST_ASSERT(mxd_reorganize_utxo(b_tip_first, 3, a_branch, 2) == 0, "Reorganize back to branch A");
+  TEST_ASSERT(mxd_get_utxo_commitment(digest) == 0 && memcmp(digest, on_a, 64) == 0,
+              "Commitment of branch A restored");
+
+  mxd_free_transaction(&genesis);
+  for (int i = 0; i < 2; i++) {
+    for (size_t j = 0; j < a_counts[i]; j++) {
+      mxd_free_transaction(&a_txs[i][j]);
+    }
+  }
+  for (int i = 0; i < 3; i++) {
+    for (size_t j = 0; j < b_counts[i]; j++) {
+      mxd_free_transaction(&b_txs[i][j]);
+    }
+  }
+
+  TEST_END("UTXO Reorganization");
+}
+
+static void test_utxo_memory_mode(void) {
+  mxd_utxo_t utxo;
+  mxd_utxo_t found;
+  mxd_utxo_cache_stats_t before;
+  mxd_utxo_cache_stats_t after;
+  uint32_t tip_height = 0;
+  uint8_t tip_hash[64];
+  size_t count = 0;
+  int replayed = 0;
+
+  TEST_START("UTXO Memory Mode");
+
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_memory.db") == 0, "Open UTXO database");
+  TEST_ASSERT(mxd_reset_utxo_db() == 0, "Start from an empty UTXO set");
+  memset(&utxo, 0, sizeof(utxo));
+  memset(utxo.owner_key, 0x91, 32);
+  mxd_hash160(utxo.owner_key, 256, utxo.pubkey_hash);
+  utxo.required_signatures = 1;
+  utxo.tx_hash[0] = 0x90;
+  utxo.amount = 5.0;
+  TEST_ASSERT(mxd_add_utxo(&utxo) == 0, "Store UTXO before memory mode");
+  TEST_ASSERT(mxd_set_utxo_memory_mode(1, 2) == -1, "Mode cannot change while open");
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+
+  // Stored records are loaded on open and served without the database
+  TEST_ASSERT(mxd_set_utxo_memory_mode(1, 2) == 0, "Enable memory mode");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_memory.db") == 0, "Open UTXO database in memory mode");
+  mxd_utxo_cache_get_stats(&before);
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 0, &found) == 0 && found.amount == 5.0, "Loaded UTXO found");
+  mxd_free_utxo(&found);
+  utxo.tx_hash[0] = 0x9F;
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 0, &found) == -1, "Unknown UTXO missing");
+  mxd_utxo_cache_get_stats(&after);
+  TEST_ASSERT(after.hits == before.hits && after.misses == before.misses, "Cache not consulted");
+
+  // Blocks and direct changes update the resident set
+  TEST_ASSERT(mxd_replay_utxo_blocks(4, replay_test_block, &replayed) == 0 && replayed == 5,
+              "Apply blocks in memory mode");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 4, "Tip advanced");
+  TEST_ASSERT(mxd_get_utxo_count(&count) == 0 && count == 6, "Block outputs counted");
+  utxo.tx_hash[0] = 0x90;
+  TEST_ASSERT(mxd_mark_utxo_spent(utxo.tx_hash, 0) == 0, "Mark UTXO spent");
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 0, &found) == 0 && found.is_spent, "Spend visible");
+  mxd_free_utxo(&found);
+  TEST_ASSERT(mxd_remove_utxo(utxo.tx_hash, 0) == 0, "Remove UTXO");
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 0, &found) == -1, "Removal visible");
+
+  // Everything reaches the database
+  TEST_ASSERT(mxd_close_utxo_db() == 0, "Close UTXO database");
+  TEST_ASSERT(mxd_set_utxo_memory_mode(0, 0) == 0, "Disable memory mode");
+  TEST_ASSERT(mxd_init_utxo_db("./test_utxo_memory.db") == 0, "Reopen UTXO database");
+  TEST_ASSERT(mxd_get_utxo_tip(&tip_height, tip_hash) == 0 && tip_height == 4, "Tip persisted");
+  TEST_ASSERT(mxd_get_utxo_count(&count) == 0 && count == 5, "Set persisted");
+  TEST_ASSERT(mxd_find_utxo(utxo.tx_hash, 0, &found) == -1, "Removal persisted");
+
+  TEST_END("UTXO Memory Mode");
+}
+
 int main(void) {
   TEST_START("UTXO Tests");
 
   test_utxo_initialization();
   test_utxo_management();
   test_multisig_utxo();
+  test_utxo_cache();
+  test_utxo_restart();
+  test_utxo_record_format();
+  test_utxo_balance_index();
+  test_utxo_batch_lookup();
+  test_utxo_stats();
+  test_utxo_commitment();
+  test_utxo_disconnect();
+  test_utxo_reorganize();
+  test_utxo_memory_mode();
 
   mxd_close_utxo_db();
 